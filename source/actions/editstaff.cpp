@@ -30,32 +30,35 @@ EditStaff::EditStaff(const ScoreLocation &location, Staff::ClefType clef,
 
 void EditStaff::redo()
 {
-    System &system = myLocation.getSystem();
-    myOriginalSystem = system;
+    // Keep the original systems before taking any references to them, since
+    // modifying a system that is shared makes a copy.
+    Score &score = myLocation.getScore();
+    const int system_index = myLocation.getSystemIndex();
+    myOriginalSystem = score.getSystemHandle(system_index);
+    myOriginalNextSystem.reset();
+    if (system_index + 1 < static_cast<int>(score.getSystems().size()))
+        myOriginalNextSystem = score.getSystemHandle(system_index + 1);
 
+    System &system = myLocation.getSystem();
     Staff &staff = myLocation.getStaff();
     staff.setClefType(myClef);
 
     // If we're changing the number of strings, more work is required...
     if (myNumStrings != staff.getStringCount())
     {
-        Score &score = myLocation.getScore();
         const int staff_index = myLocation.getStaffIndex();
 
         // If the following system doesn't start with a player change, it will
         // need one so that it has players with the correct number of strings.
-        const int next_system_index = myLocation.getSystemIndex() + 1;
-        if (next_system_index < score.getSystems().size())
+        const int next_system_index = system_index + 1;
+        if (myOriginalNextSystem &&
+            (*myOriginalNextSystem)->getStaves().size() >= staff_index)
         {
-            System &next_system = score.getSystems()[next_system_index];
-            myOriginalNextSystem = next_system;
-
-            if (next_system.getStaves().size() >= staff_index)
-                addPlayerChangeAtStart(score, next_system_index);
+            addPlayerChangeAtStart(score, next_system_index);
         }
 
         // Ensure that there's a player change at the start of the system.
-        addPlayerChangeAtStart(score, myLocation.getSystemIndex());
+        addPlayerChangeAtStart(score, system_index);
 
         // Clear out all active players in this staff.
         for (PlayerChange &change : system.getPlayerChanges())
@@ -72,10 +75,10 @@ void EditStaff::undo()
 {
     Score &score = myLocation.getScore();
     const int system_index = myLocation.getSystemIndex();
-    score.getSystems()[system_index] = myOriginalSystem;
+    score.restoreSystem(system_index, myOriginalSystem);
 
     if (myOriginalNextSystem)
-        score.getSystems()[system_index + 1] = *myOriginalNextSystem;
+        score.restoreSystem(system_index + 1, *myOriginalNextSystem);
 }
 
 void EditStaff::addPlayerChangeAtStart(Score &score, int system_index)
@@ -20,8 +20,8 @@
 
 #include <boost/optional.hpp>
 #include <QUndoCommand>
+#include <score/score.h>
 #include <score/scorelocation.h>
-#include <score/system.h>
 
 class EditStaff : public QUndoCommand
 {
@@ -35,8 +35,8 @@ private:
     static void addPlayerChangeAtStart(Score &score, int system_index);
 
     ScoreLocation myLocation;
-    System myOriginalSystem;
-    boost::optional<System> myOriginalNextSystem;
+    Score::SystemHandle myOriginalSystem;
+    boost::optional<Score::SystemHandle> myOriginalNextSystem;
     Staff::ClefType myClef;
     int myNumStrings;
 };
@@ -27,16 +27,16 @@ PolishScore::PolishScore(Score &score)
 
 void PolishScore::redo()
 {
-    for (const System &system : myScore.getSystems())
-        myOriginalSystems.push_back(system);
+    for (unsigned int i = 0; i < myScore.getSystems().size(); ++i)
+        myOriginalSystems.push_back(myScore.getSystemHandle(i));
 
     ScoreUtils::polishScore(myScore);
 }
 
 void PolishScore::undo()
 {
-    std::copy(myOriginalSystems.begin(), myOriginalSystems.end(),
-              myScore.getSystems().begin());
+    for (unsigned int i = 0; i < myOriginalSystems.size(); ++i)
+        myScore.restoreSystem(i, myOriginalSystems[i]);
 
     myOriginalSystems.clear();
 }
@@ -19,9 +19,7 @@
 #define ACTIONS_POLISHSCORE_H
 
 #include <QUndoCommand>
-#include <score/system.h>
-
-class Score;
+#include <score/score.h>
 
 class PolishScore : public QUndoCommand
 {
@@ -33,7 +31,7 @@ public:
 
 private:
     Score &myScore;
-    std::vector<System> myOriginalSystems;
+    std::vector<Score::SystemHandle> myOriginalSystems;
 };
 
 #endif
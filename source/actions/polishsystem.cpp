@@ -17,6 +17,7 @@
   
 #include "polishsystem.h"
 
+#include <score/score.h>
 #include <score/utils/scorepolisher.h>
 
 PolishSystem::PolishSystem(const ScoreLocation &location)
@@ -26,12 +27,14 @@ PolishSystem::PolishSystem(const ScoreLocation &location)
 
 void PolishSystem::redo()
 {
-    myOriginalSystem = myLocation.getSystem();
+    myOriginalSystem =
+        myLocation.getScore().getSystemHandle(myLocation.getSystemIndex());
     ScoreUtils::polishSystem(myLocation.getSystem());
 }
 
 void PolishSystem::undo()
 {
-    myLocation.getSystem() = *myOriginalSystem;
+    myLocation.getScore().restoreSystem(myLocation.getSystemIndex(),
+                                        myOriginalSystem);
     myOriginalSystem.reset();
 }
@@ -20,9 +20,8 @@
 
 #include <QUndoCommand>
 
-#include <boost/optional/optional.hpp>
+#include <score/score.h>
 #include <score/scorelocation.h>
-#include <score/system.h>
 
 class PolishSystem : public QUndoCommand
 {
@@ -34,7 +33,7 @@ public:
 
 private:
     ScoreLocation myLocation;
-    boost::optional<System> myOriginalSystem;
+    Score::SystemHandle myOriginalSystem;
 };
 
 #endif
@@ -23,7 +23,7 @@ RemoveSystem::RemoveSystem(Score &score, int index)
     : QUndoCommand(QObject::tr("Remove System")),
       myScore(score),
       myIndex(index),
-      myOriginalSystem(score.getSystems()[index])
+      myOriginalSystem(score.getSystemHandle(index))
 {
 }
 
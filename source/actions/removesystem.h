@@ -19,9 +19,7 @@
 #define ACTIONS_REMOVESYSTEM_H
 
 #include <QUndoCommand>
-#include <score/system.h>
-
-class Score;
+#include <score/score.h>
 
 class RemoveSystem : public QUndoCommand
 {
@@ -34,7 +32,7 @@ public:
 private:
     Score &myScore;
     const int myIndex;
-    const System myOriginalSystem;
+    const Score::SystemHandle myOriginalSystem;
 };
 
 #endif
@@ -56,7 +56,10 @@ void Caret::moveHorizontal(int offset)
 
 void Caret::moveVertical(int offset)
 {
-    const int numStrings = myLocation.getStaff().getStringCount();
+    // Read through a const location, so that the system isn't copied if it
+    // is shared.
+    const ScoreLocation &location = myLocation;
+    const int numStrings = location.getStaff().getStringCount();
     myLocation.setString((myLocation.getString() + offset + numStrings) %
                          numStrings);
 
@@ -95,15 +98,16 @@ void Caret::moveStaff(int offset)
 
 void Caret::moveToStaff(int staff)
 {
+    const ScoreLocation &location = myLocation;
     const int num_staves =
-        static_cast<int>(myLocation.getSystem().getStaves().size());
+        static_cast<int>(location.getSystem().getStaves().size());
     staff = boost::algorithm::clamp(staff, 0, num_staves - 1);
 
     const bool is_increasing = staff >= myLocation.getStaffIndex();
     const int increment = is_increasing ? 1 : -1;
     const int end = is_increasing ? num_staves : -1;
 
-    const Score &score = myLocation.getScore();
+    const Score &score = location.getScore();
     const ViewFilter *filter =
         myViewOptions.getFilter()
             ? &score.getViewFilters()[*myViewOptions.getFilter()]
@@ -124,13 +128,14 @@ void Caret::moveToStaff(int staff)
 
 bool Caret::moveToNextBar()
 {
-    const Barline *nextBar = myLocation.getSystem().getNextBarline(
-                myLocation.getPositionIndex());
+    const ScoreLocation &location = myLocation;
+    const Barline *nextBar = location.getSystem().getNextBarline(
+                location.getPositionIndex());
     if (!nextBar)
         return false;
 
     // Move into the next system if necessary.
-    if (*nextBar == myLocation.getSystem().getBarlines().back())
+    if (*nextBar == location.getSystem().getBarlines().back())
         return moveToSystem(myLocation.getSystemIndex() + 1, true);
     else
     {
@@ -141,7 +146,8 @@ bool Caret::moveToNextBar()
 
 void Caret::moveToPrevBar()
 {
-    const System &system = myLocation.getSystem();
+    const ScoreLocation &location = myLocation;
+    const System &system = location.getSystem();
     const Barline *prevBar = system.getPreviousBarline(
                 myLocation.getPositionIndex());
     if (prevBar)
@@ -155,7 +161,7 @@ void Caret::moveToPrevBar()
         moveToSystem(myLocation.getSystemIndex() - 1, true);
 
         // Move to the last barline if possible.
-        const System &newSystem = myLocation.getSystem();
+        const System &newSystem = location.getSystem();
         const size_t count = newSystem.getBarlines().size();
         if (count > 2)
             moveToPosition(newSystem.getBarlines()[count - 2].getPosition());
@@ -200,9 +206,10 @@ bool Caret::moveToSystem(int system, bool keepStaff)
             myLocation.setStaffIndex(0);
         else
         {
+            const ScoreLocation &location = myLocation;
             myLocation.setStaffIndex(boost::algorithm::clamp(
-                myLocation.getStaffIndex(), 0,
-                static_cast<int>(myLocation.getSystem().getStaves().size() - 1)));
+                location.getStaffIndex(), 0,
+                static_cast<int>(location.getSystem().getStaves().size() - 1)));
         }
 
         myLocation.setPositionIndex(0);
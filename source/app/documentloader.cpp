@@ -0,0 +1,150 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "documentloader.h"
+
+#include <chrono>
+#include <formats/fileformatmanager.h>
+#include <QDebug>
+
+/// Copies everything except the systems from one score to another (empty)
+/// score.
+static void copyScoreHeader(const Score &source, Score &dest)
+{
+    dest.setScoreInfo(source.getScoreInfo());
+    dest.setLineSpacing(source.getLineSpacing());
+
+    for (const Player &player : source.getPlayers())
+        dest.insertPlayer(player);
+    for (const Instrument &instrument : source.getInstruments())
+        dest.insertInstrument(instrument);
+    for (const ViewFilter &filter : source.getViewFilters())
+        dest.insertViewFilter(filter);
+}
+
+DocumentLoader::DocumentLoader(const SettingsManager &settings_manager,
+                               const std::string &path,
+                               const FileFormat &format)
+    : myFileFormatManager(new FileFormatManager(settings_manager)),
+      myPath(path),
+      myFormat(format),
+      myCancelled(false),
+      mySucceeded(false),
+      myNumPublished(0),
+      myNumTaken(0)
+{
+}
+
+DocumentLoader::~DocumentLoader()
+{
+    cancel();
+    wait();
+}
+
+void DocumentLoader::cancel()
+{
+    myCancelled = true;
+}
+
+bool DocumentLoader::hasImportedSystems() const
+{
+    std::lock_guard<std::mutex> lock(myMutex);
+    return !myPendingSystems.empty();
+}
+
+void DocumentLoader::takeImportedSystems(Score &score)
+{
+    std::lock_guard<std::mutex> lock(myMutex);
+
+    if (myPendingHeader)
+    {
+        copyScoreHeader(*myPendingHeader, score);
+        myPendingHeader.reset();
+    }
+
+    for (const Score::SystemHandle &system : myPendingSystems)
+        score.insertSystem(system);
+
+    myNumTaken += static_cast<int>(myPendingSystems.size());
+    myPendingSystems.clear();
+}
+
+void DocumentLoader::takeRemainingSystems(Score &score)
+{
+    Q_ASSERT(isFinished() && mySucceeded);
+    takeImportedSystems(score);
+
+    // Some importers don't publish any systems until the end (or at all).
+    if (myNumTaken == 0)
+        copyScoreHeader(myScore, score);
+
+    const int numSystems = static_cast<int>(myScore.getSystems().size());
+    for (int i = myNumTaken; i < numSystems; ++i)
+        score.insertSystem(myScore.getSystemHandle(i));
+
+    myNumTaken = numSystems;
+}
+
+void DocumentLoader::run()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    try
+    {
+        myFileFormatManager->importFile(myScore, myPath, myFormat, this);
+        mySucceeded = true;
+
+        auto end = std::chrono::high_resolution_clock::now();
+        qDebug() << "File loaded in"
+                 << std::chrono::duration_cast<std::chrono::milliseconds>(
+                        end - start).count() << "ms";
+    }
+    catch (const std::exception &e)
+    {
+        myErrorMessage = e.what();
+    }
+}
+
+void DocumentLoader::systemImported(const Score &score, int index)
+{
+    bool notify = false;
+    {
+        std::lock_guard<std::mutex> lock(myMutex);
+
+        if (myNumPublished == 0)
+        {
+            myPendingHeader.reset(new Score());
+            copyScoreHeader(score, *myPendingHeader);
+        }
+
+        // Avoid flooding the event loop; the UI takes all of the pending
+        // systems at once.
+        notify = myPendingSystems.empty();
+
+        for (; myNumPublished <= index; ++myNumPublished)
+            myPendingSystems.push_back(score.getSystemHandle(myNumPublished));
+    }
+
+    if (notify)
+        emit systemsImported();
+}
+
+bool DocumentLoader::isCancelled() const
+{
+    return myCancelled;
+}
@@ -0,0 +1,102 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef APP_DOCUMENTLOADER_H
+#define APP_DOCUMENTLOADER_H
+
+#include <atomic>
+#include <formats/fileformat.h>
+#include <memory>
+#include <mutex>
+#include <QThread>
+#include <score/score.h>
+#include <string>
+#include <vector>
+
+class FileFormatManager;
+class SettingsManager;
+
+/// Imports a file on a background thread. Systems are handed over to the UI
+/// as soon as the importer publishes them, so the start of a large score can
+/// be displayed while the rest of the file is still loading.
+class DocumentLoader : public QThread, private ImportListener
+{
+    Q_OBJECT
+
+public:
+    DocumentLoader(const SettingsManager &settings_manager,
+                   const std::string &path, const FileFormat &format);
+    /// Cancels the import if it is still running.
+    ~DocumentLoader();
+
+    const std::string &getPath() const { return myPath; }
+
+    /// Asks the importer to stop as soon as possible.
+    void cancel();
+    bool wasCancelled() const { return myCancelled; }
+
+    /// Returns whether there are systems that haven't been taken yet.
+    bool hasImportedSystems() const;
+    /// Appends the systems that have been imported since the last call to the
+    /// given score. The score information, players, etc are copied along with
+    /// the first systems.
+    void takeImportedSystems(Score &score);
+    /// Appends the rest of the imported score. This is only valid after the
+    /// thread has finished successfully.
+    void takeRemainingSystems(Score &score);
+
+    /// Returns whether the import succeeded. This is only valid after the
+    /// thread has finished.
+    bool succeeded() const { return mySucceeded; }
+    /// Returns the reason that the import failed.
+    const std::string &getErrorMessage() const { return myErrorMessage; }
+
+signals:
+    /// Emitted from the loading thread when systems are available to be taken.
+    void systemsImported();
+
+private:
+    virtual void run() override;
+
+    virtual void systemImported(const Score &score, int index) override;
+    virtual bool isCancelled() const override;
+
+    /// Each loader has its own importers, since they aren't thread-safe.
+    const std::unique_ptr<FileFormatManager> myFileFormatManager;
+    const std::string myPath;
+    const FileFormat myFormat;
+    std::atomic<bool> myCancelled;
+    bool mySucceeded;
+    std::string myErrorMessage;
+    /// The score being imported, which is only accessed by the loading thread
+    /// until it has finished.
+    Score myScore;
+
+    mutable std::mutex myMutex;
+    /// The systems that have been published but not yet taken, and a copy of
+    /// the score without any systems to accompany the first of them. The
+    /// systems are shared with the imported score rather than copied.
+    std::unique_ptr<Score> myPendingHeader;
+    std::vector<Score::SystemHandle> myPendingSystems;
+    /// The number of systems that have been published by the importer.
+    int myNumPublished;
+    /// The number of systems that have been taken.
+    int myNumTaken;
+};
+
+#endif
@@ -17,8 +17,9 @@
   
 #include "documentmanager.h"
 
+#include <app/recoveryjournal.h>
 #include <app/settings.h>
-#include <app/settingsmanager.h>
+#include <util/settingsmanager.h>
 
 DocumentManager::DocumentManager()
 {
@@ -136,11 +137,26 @@ int DocumentManager::findDocument(const std::string& filepath)
     return -1;
 }
 
+int DocumentManager::findDocument(const Document &doc) const
+{
+    for (size_t i = 0; i < myDocumentList.size(); ++i)
+    {
+        if (myDocumentList[i].get() == &doc)
+            return static_cast<int>(i);
+    }
+
+    return -1;
+}
+
 Document::Document()
     : myCaret(myScore, myViewOptions)
 {
 }
 
+Document::~Document()
+{
+}
+
 bool Document::hasFilename() const
 {
     return myFilename.is_initialized();
@@ -186,3 +202,8 @@ Caret &Document::getCaret()
 {
     return myCaret;
 }
+
+void Document::setJournal(std::unique_ptr<RecoveryJournal> journal)
+{
+    myJournal = std::move(journal);
+}
@@ -25,6 +25,7 @@
 #include <score/score.h>
 #include <vector>
 
+class RecoveryJournal;
 class SettingsManager;
 
 /// A document is a score that is either associated with a file or unsaved.
@@ -32,6 +33,7 @@ class Document
 {
 public:
     Document();
+    ~Document();
     Document(const Document &) = delete;
     Document &operator=(const Document &) = delete;
 
@@ -51,11 +53,16 @@ public:
     const Caret &getCaret() const;
     Caret &getCaret();
 
+    /// Returns the journal of unsaved edits, if one has been started.
+    RecoveryJournal *getJournal() { return myJournal.get(); }
+    void setJournal(std::unique_ptr<RecoveryJournal> journal);
+
 private:
     boost::optional<std::string> myFilename;
     Score myScore;
     ViewOptions myViewOptions;
     Caret myCaret;
+    std::unique_ptr<RecoveryJournal> myJournal;
 };
 
 /// Class for managing open documents.
@@ -82,6 +89,8 @@ public:
     
     /// Returns -1 if the file at filepath is not open, else it returns the index at which the already open file is at
     int findDocument(const std::string& filepath);
+    /// Returns the index of the document, or -1 if it is not open.
+    int findDocument(const Document &doc) const;
 
 private:
     std::vector<std::unique_ptr<Document>> myDocumentList;
@@ -0,0 +1,54 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "documentsaver.h"
+
+#include <formats/fileformatmanager.h>
+#include <score/score.h>
+
+DocumentSaver::DocumentSaver(const FileFormatManager &manager,
+                             std::unique_ptr<Score> snapshot,
+                             const std::string &path, const FileFormat &format)
+    : myFileFormatManager(manager),
+      mySnapshot(std::move(snapshot)),
+      myPath(path),
+      myFormat(format),
+      mySucceeded(false)
+{
+}
+
+DocumentSaver::~DocumentSaver()
+{
+    // The save can't be safely interrupted, so let it finish.
+    wait();
+}
+
+void DocumentSaver::run()
+{
+    try
+    {
+        myFileFormatManager.exportFile(*mySnapshot, myPath, myFormat);
+        mySucceeded = true;
+    }
+    catch (const std::exception &e)
+    {
+        myErrorMessage = e.what();
+    }
+
+    // Free the snapshot on this thread rather than the GUI thread.
+    mySnapshot.reset();
+}
@@ -0,0 +1,60 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef APP_DOCUMENTSAVER_H
+#define APP_DOCUMENTSAVER_H
+
+#include <formats/fileformat.h>
+#include <memory>
+#include <QThread>
+#include <string>
+
+class FileFormatManager;
+class Score;
+
+/// Exports a snapshot of a score on a background thread, so that the UI stays
+/// responsive while large files are saved.
+class DocumentSaver : public QThread
+{
+    Q_OBJECT
+
+public:
+    DocumentSaver(const FileFormatManager &manager,
+                  std::unique_ptr<Score> snapshot, const std::string &path,
+                  const FileFormat &format);
+    ~DocumentSaver();
+
+    const std::string &getPath() const { return myPath; }
+
+    /// Returns whether the save succeeded. This is only valid after the
+    /// thread has finished.
+    bool succeeded() const { return mySucceeded; }
+    /// Returns the reason that the save failed.
+    const std::string &getErrorMessage() const { return myErrorMessage; }
+
+private:
+    virtual void run() override;
+
+    const FileFormatManager &myFileFormatManager;
+    std::unique_ptr<Score> mySnapshot;
+    const std::string myPath;
+    const FileFormat myFormat;
+    bool mySucceeded;
+    std::string myErrorMessage;
+};
+
+#endif
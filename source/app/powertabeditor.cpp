@@ -76,21 +76,24 @@
 #include <app/caret.h>
 #include <app/clipboard.h>
 #include <app/command.h>
+#include <app/documentloader.h>
 #include <app/documentmanager.h>
+#include <app/documentsaver.h>
 #include <app/paths.h>
 #include <app/pubsub/clickpubsub.h>
 #include <app/recentfiles.h>
+#include <app/recoveryjournal.h>
 #include <app/scorearea.h>
 #include <app/settings.h>
-#include <app/settingsmanager.h>
 #include <app/tuningdictionary.h>
 
 #include <audio/midiplayer.h>
-#include <audio/settings.h>
 
+#include <boost/filesystem/operations.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/range/algorithm/transform.hpp>
 #include <chrono>
+#include <stdexcept>
 
 #include <dialogs/alterationofpacedialog.h>
 #include <dialogs/alternateendingdialog.h>
@@ -110,6 +113,7 @@
 #include <dialogs/playerchangedialog.h>
 #include <dialogs/preferencesdialog.h>
 #include <dialogs/rehearsalsigndialog.h>
+#include <dialogs/scorelibrarydialog.h>
 #include <dialogs/staffdialog.h>
 #include <dialogs/tappedharmonicdialog.h>
 #include <dialogs/tempomarkerdialog.h>
@@ -120,6 +124,9 @@
 #include <dialogs/viewfilterdialog.h>
 
 #include <formats/fileformatmanager.h>
+#include <formats/scorelibrary.h>
+
+#include <midi/settings.h>
 
 #include <QCoreApplication>
 #include <QDebug>
@@ -128,24 +135,42 @@
 #include <QFileDialog>
 #include <QFontDatabase>
 #include <QKeyEvent>
+#include <QLockFile>
 #include <QMenuBar>
 #include <QMessageBox>
 #include <QMimeData>
 #include <QPrinter>
 #include <QPrintDialog>
 #include <QPrintPreviewDialog>
+#include <QProgressBar>
+#include <QPushButton>
 #include <QScrollArea>
+#include <QStatusBar>
 #include <QTabBar>
+#include <QUndoStack>
 #include <QUrl>
 #include <QVBoxLayout>
 
 #include <score/utils.h>
 #include <score/voiceutils.h>
 
+#include <util/settingsmanager.h>
+
 #include <widgets/instruments/instrumentpanel.h>
 #include <widgets/mixer/mixer.h>
 #include <widgets/playback/playbackwidget.h>
 
+static const char *theScoreLibraryFilename = "library.idx";
+static const char *theRecoveryDirname = "recovery";
+
+/// Returns the lock file for an instance's directory of recovery journals.
+/// This is kept beside the directory so that it can be held while the
+/// directory is deleted.
+static QString getRecoveryLockFilename(const boost::filesystem::path &dir)
+{
+    return QString::fromStdString(dir.string() + ".lock");
+}
+
 PowerTabEditor::PowerTabEditor()
     : QMainWindow(nullptr),
       mySettingsManager(new SettingsManager()),
@@ -153,6 +178,11 @@ PowerTabEditor::PowerTabEditor()
       myFileFormatManager(new FileFormatManager(*mySettingsManager)),
       myUndoManager(new UndoManager()),
       myTuningDictionary(new TuningDictionary()),
+      myLoadingDocument(nullptr),
+      mySavingDocument(nullptr),
+      mySavingUndoStack(nullptr),
+      mySavingUndoIndex(0),
+      myJournalScoreChanged(false),
       myIsPlaying(false),
       myRecentFiles(nullptr),
       myActiveDurationType(Position::EighthNote),
@@ -162,7 +192,10 @@ PowerTabEditor::PowerTabEditor()
       myInstrumentPanel(nullptr),
       myInstrumentDockWidget(nullptr),
       myPlaybackWidget(nullptr),
-      myPlaybackArea(nullptr)
+      myPlaybackArea(nullptr),
+      mySaveProgressBar(nullptr),
+      myLoadProgressBar(nullptr),
+      myCancelLoadButton(nullptr)
 {
     this->setWindowIcon(QIcon(":icons/app_icon.png"));
 
@@ -181,6 +214,17 @@ PowerTabEditor::PowerTabEditor()
     connect(myUndoManager.get(), SIGNAL(cleanChanged(bool)), this,
             SLOT(updateModified(bool)));
 
+    // Keep a journal of the edits to each document, so that unsaved changes
+    // can be recovered after a crash.
+    connect(myUndoManager.get(), &UndoManager::redrawNeeded, this,
+            &PowerTabEditor::recordSystemEdit);
+    connect(myUndoManager.get(), &UndoManager::fullRedrawNeeded, this,
+            &PowerTabEditor::recordScoreEdit);
+    connect(myUndoManager.get(), &QUndoGroup::indexChanged, this,
+            &PowerTabEditor::writeJournal);
+    connect(myUndoManager.get(), &QUndoGroup::cleanChanged, this,
+            &PowerTabEditor::discardJournal);
+
     myTuningDictionary->loadInBackground();
     mySettingsManager->load(Paths::getConfigDir());
 
@@ -198,6 +242,26 @@ PowerTabEditor::PowerTabEditor()
 
     createTabArea();
 
+    // Show a busy indicator while a file is being saved in the background.
+    mySaveProgressBar = new QProgressBar(this);
+    mySaveProgressBar->setRange(0, 0);
+    mySaveProgressBar->setMaximumWidth(150);
+    mySaveProgressBar->hide();
+    statusBar()->addPermanentWidget(mySaveProgressBar);
+
+    // Similarly for a file that is being loaded, which can also be cancelled.
+    myLoadProgressBar = new QProgressBar(this);
+    myLoadProgressBar->setRange(0, 0);
+    myLoadProgressBar->setMaximumWidth(150);
+    myLoadProgressBar->hide();
+    statusBar()->addPermanentWidget(myLoadProgressBar);
+
+    myCancelLoadButton = new QPushButton(tr("Cancel"), this);
+    myCancelLoadButton->hide();
+    connect(myCancelLoadButton, &QPushButton::clicked, this,
+            &PowerTabEditor::cancelLoad);
+    statusBar()->addPermanentWidget(myCancelLoadButton);
+
     auto settings = mySettingsManager->getReadHandle();
     myPreviousDirectory =
         QString::fromStdString(settings->get(Settings::PreviousDirectory));
@@ -221,8 +285,114 @@ void PowerTabEditor::openFiles(const QStringList &files)
         openFile(filename);
 }
 
+void PowerTabEditor::recoverDocuments()
+{
+    namespace fs = boost::filesystem;
+
+    const fs::path root = Paths::getUserDataDir() / theRecoveryDirname;
+    if (!fs::is_directory(root))
+        return;
+
+    // Each instance locks its directory of journals while it is running, so
+    // the journals are only orphaned if the lock is free or its process no
+    // longer exists. The locks are held until the journals have been
+    // recovered, so that another instance doesn't also recover them.
+    std::vector<std::unique_ptr<QLockFile>> locks;
+    std::vector<fs::path> instance_dirs;
+    std::vector<fs::path> dirs;
+    for (fs::directory_iterator it(root), end; it != end; ++it)
+    {
+        const fs::path &instance_dir = it->path();
+        if (!fs::is_directory(instance_dir) ||
+            instance_dir.string() == myRecoveryDirectory)
+        {
+            continue;
+        }
+
+        std::unique_ptr<QLockFile> lock(
+            new QLockFile(getRecoveryLockFilename(instance_dir)));
+        // Don't take over the lock of a long-running instance.
+        lock->setStaleLockTime(0);
+        if (!lock->tryLock())
+            continue;
+
+        const size_t num_dirs = dirs.size();
+        for (fs::directory_iterator journal_it(instance_dir);
+             journal_it != end; ++journal_it)
+        {
+            if (RecoveryJournal::exists(journal_it->path().string()))
+                dirs.push_back(journal_it->path());
+        }
+
+        // Clean up after instances that exited without any unsaved changes.
+        if (dirs.size() == num_dirs)
+        {
+            boost::system::error_code error;
+            fs::remove_all(instance_dir, error);
+            continue;
+        }
+
+        instance_dirs.push_back(instance_dir);
+        locks.push_back(std::move(lock));
+    }
+
+    if (dirs.empty())
+        return;
+
+    const int ret = QMessageBox::question(
+        this, tr("Recover Documents"),
+        tr("%n document(s) had unsaved changes when the program last exited. "
+           "Do you want to recover them?",
+           "", static_cast<int>(dirs.size())));
+
+    // Keep the journals so that the user can recover them later.
+    if (ret != QMessageBox::Yes)
+        return;
+
+    for (const fs::path &dir : dirs)
+    {
+        Document &doc = myDocumentManager->addDocument();
+        try
+        {
+            RecoveredDocument recovered =
+                RecoveryJournal::recover(dir.string(), doc.getScore());
+            if (!recovered.filename.empty())
+                doc.setFilename(recovered.filename);
+        }
+        catch (const std::exception &e)
+        {
+            myDocumentManager->removeDocument(
+                myDocumentManager->getCurrentDocumentIndex());
+            myDocumentManager->setCurrentDocumentIndex(
+                myTabWidget->currentIndex());
+
+            QMessageBox::warning(
+                this, tr("Error Recovering Document"),
+                tr("Error recovering document: %1")
+                    .arg(QString::fromStdString(e.what())));
+            continue;
+        }
+
+        setupNewTab();
+
+        // Mark the document as modified, which also starts a new journal for
+        // it.
+        myUndoManager->push(new QUndoCommand(tr("Recover Document")),
+                            UndoManager::AFFECTS_ALL_SYSTEMS);
+    }
+
+    for (const fs::path &instance_dir : instance_dirs)
+    {
+        boost::system::error_code error;
+        fs::remove_all(instance_dir, error);
+    }
+}
+
 void PowerTabEditor::createNewDocument()
 {
+    // Only one document is opened at a time.
+    finishLoad();
+
     myDocumentManager->addDefaultDocument(*mySettingsManager);
     setupNewTab();
 }
@@ -239,6 +409,9 @@ void PowerTabEditor::openFile(QString filename)
     if (filename.isEmpty())
         return;
 
+    // Only one file is loaded at a time.
+    finishLoad();
+
     int validationResult = myDocumentManager->findDocument(filename.toStdString());
     if (validationResult > -1)
     {
@@ -247,8 +420,6 @@ void PowerTabEditor::openFile(QString filename)
         return;
     }
 
-    auto start = std::chrono::high_resolution_clock::now();
-
     qDebug() << "Opening file: " << filename;
 
     QFileInfo fileInfo(filename);
@@ -262,30 +433,241 @@ void PowerTabEditor::openFile(QString filename)
         return;
     }
 
+    // Import the file in the background, and display the systems as they
+    // become available.
+    myDocumentLoader.reset(new DocumentLoader(
+        *mySettingsManager, filename.toStdString(), *format));
+    connect(myDocumentLoader.get(), &DocumentLoader::systemsImported, this,
+            &PowerTabEditor::addImportedSystems);
+    connect(myDocumentLoader.get(), &QThread::finished, this,
+            &PowerTabEditor::finishLoad);
+
+    statusBar()->showMessage(tr("Loading %1...").arg(fileInfo.fileName()));
+    myLoadProgressBar->show();
+    myCancelLoadButton->show();
+    myDocumentLoader->start();
+}
+
+void PowerTabEditor::openScoreLibrary()
+{
+    const std::string path =
+        (Paths::getUserDataDir() / theScoreLibraryFilename).string();
+
+    if (!myScoreLibrary)
+    {
+        myScoreLibrary.reset(new ScoreLibrary());
+        if (boost::filesystem::exists(path))
+        {
+            try
+            {
+                myScoreLibrary->load(path);
+            }
+            catch (const std::exception &e)
+            {
+                // The index can be rebuilt by rescanning the directories.
+                qDebug() << "Error loading score library: " << e.what();
+            }
+        }
+    }
+
+    ScoreLibraryDialog dialog(this, *myScoreLibrary, *mySettingsManager);
+    const int result = dialog.exec();
+
     try
     {
-        Document &doc = myDocumentManager->addDocument();
-        myFileFormatManager->importFile(doc.getScore(), filename.toStdString(),
-                                        *format);
-        auto end = std::chrono::high_resolution_clock::now();
-        qDebug() << "File loaded in"
-                 << std::chrono::duration_cast<std::chrono::milliseconds>(end - start) .count()
-                 << "ms";
-
-        doc.setFilename(filename.toStdString());
-        setPreviousDirectory(filename);
-        myRecentFiles->add(filename);
-        setupNewTab();
+        boost::filesystem::create_directories(Paths::getUserDataDir());
+        myScoreLibrary->save(path);
     }
     catch (const std::exception &e)
     {
-        myDocumentManager->removeDocument(
-            myDocumentManager->getCurrentDocumentIndex());
+        qDebug() << "Error saving score library: " << e.what();
+    }
 
-        QMessageBox::warning(
-            this, tr("Error Opening File"),
-            tr("Error opening file: %1").arg(QString(e.what())));
+    if (result == QDialog::Accepted)
+        openFiles(dialog.getSelectedFiles());
+}
+
+void PowerTabEditor::recordSystemEdit(int system)
+{
+    myJournalSystems.insert(system);
+}
+
+void PowerTabEditor::recordScoreEdit()
+{
+    myJournalScoreChanged = true;
+}
+
+void PowerTabEditor::writeJournal()
+{
+    if (myJournalSystems.empty() && !myJournalScoreChanged)
+        return;
+
+    if (myDocumentManager->hasOpenDocuments())
+    {
+        Document &doc = myDocumentManager->getCurrentDocument();
+        const int undo_index = myUndoManager->activeStack()->index();
+
+        try
+        {
+            if (!doc.getJournal())
+            {
+                const boost::filesystem::path dir =
+                    boost::filesystem::path(getRecoveryDirectory()) /
+                    boost::filesystem::unique_path();
+                doc.setJournal(std::unique_ptr<RecoveryJournal>(
+                    new RecoveryJournal(dir.string())));
+            }
+
+            RecoveryJournal &journal = *doc.getJournal();
+            journal.setFilename(doc.hasFilename() ? doc.getFilename() : "");
+
+            if (myJournalScoreChanged)
+                journal.recordScore(doc.getScore(), undo_index);
+            else
+            {
+                for (int system : myJournalSystems)
+                    journal.recordSystem(doc.getScore(), system, undo_index);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            qDebug() << "Error writing recovery journal: " << e.what();
+        }
+    }
+
+    myJournalSystems.clear();
+    myJournalScoreChanged = false;
+}
+
+const std::string &PowerTabEditor::getRecoveryDirectory()
+{
+    if (!myRecoveryLock)
+    {
+        namespace fs = boost::filesystem;
+
+        const fs::path dir = Paths::getUserDataDir() / theRecoveryDirname /
+                             fs::unique_path();
+        fs::create_directories(dir.parent_path());
+
+        // The lock must exist before any journals are written.
+        std::unique_ptr<QLockFile> lock(
+            new QLockFile(getRecoveryLockFilename(dir)));
+        if (!lock->tryLock())
+            throw std::runtime_error("Unable to lock " + dir.string());
+
+        myRecoveryLock = std::move(lock);
+        myRecoveryDirectory = dir.string();
+    }
+
+    return myRecoveryDirectory;
+}
+
+void PowerTabEditor::discardJournal(bool clean)
+{
+    if (!clean || !myDocumentManager->hasOpenDocuments())
+        return;
+
+    if (RecoveryJournal *journal =
+            myDocumentManager->getCurrentDocument().getJournal())
+    {
+        journal->clear();
+    }
+}
+
+void PowerTabEditor::addImportedSystems()
+{
+    // The signal may arrive after the load has already been finished.
+    if (!myDocumentLoader || !myDocumentLoader->hasImportedSystems())
+        return;
+
+    if (myLoadingDocument)
+    {
+        // Another tab may have been selected in the meantime.
+        myDocumentLoader->takeImportedSystems(myLoadingDocument->getScore());
+        getScoreArea(*myLoadingDocument)->renderNewSystems();
+        return;
     }
+
+    Document &doc = myDocumentManager->addDocument();
+    myDocumentLoader->takeImportedSystems(doc.getScore());
+    doc.setFilename(myDocumentLoader->getPath());
+    myLoadingDocument = &doc;
+
+    setupNewTab();
+
+    // Don't allow the document to be edited or played until it is complete.
+    updateLoadingState();
+}
+
+void PowerTabEditor::cancelLoad()
+{
+    if (myDocumentLoader)
+        myDocumentLoader->cancel();
+}
+
+void PowerTabEditor::finishLoad()
+{
+    if (!myDocumentLoader)
+        return;
+
+    // Take ownership before showing any dialogs, since their event loop
+    // could deliver the finished() signal and call this again.
+    myDocumentLoader->wait();
+    std::unique_ptr<DocumentLoader> loader(std::move(myDocumentLoader));
+    Document *doc = myLoadingDocument;
+    myLoadingDocument = nullptr;
+
+    myLoadProgressBar->hide();
+    myCancelLoadButton->hide();
+    statusBar()->clearMessage();
+
+    // Some importers can't be interrupted, so the file may have been loaded
+    // despite being cancelled.
+    if (!loader->succeeded() || loader->wasCancelled())
+    {
+        // Discard the part of the document that was displayed.
+        if (doc)
+        {
+            for (int i = 0; i < myTabWidget->count(); ++i)
+            {
+                if (&myDocumentManager->getDocument(i) == doc)
+                {
+                    closeTab(i);
+                    break;
+                }
+            }
+        }
+
+        if (!loader->wasCancelled())
+        {
+            QMessageBox::warning(
+                this, tr("Error Opening File"),
+                tr("Error opening file: %1")
+                    .arg(QString::fromStdString(loader->getErrorMessage())));
+        }
+
+        return;
+    }
+
+    if (doc)
+    {
+        loader->takeRemainingSystems(doc->getScore());
+        getScoreArea(*doc)->renderNewSystems();
+
+        updateLoadingState();
+        updateCommands();
+    }
+    else
+    {
+        Document &newDoc = myDocumentManager->addDocument();
+        loader->takeRemainingSystems(newDoc.getScore());
+        newDoc.setFilename(loader->getPath());
+        setupNewTab();
+    }
+
+    const QString filename = QString::fromStdString(loader->getPath());
+    setPreviousDirectory(filename);
+    myRecentFiles->add(filename);
 }
 
 void PowerTabEditor::switchTab(int index)
@@ -308,11 +690,24 @@ void PowerTabEditor::switchTab(int index)
 
     myUndoManager->setActiveStackIndex(index);
 
+    // Editing is only blocked for the document that is being loaded.
+    if (myLoadingDocument)
+        updateLoadingState();
+
     updateWindowTitle();
 }
 
 bool PowerTabEditor::closeTab(int index)
 {
+    // Closing a document that is still being loaded cancels the load, which
+    // then removes the tab.
+    if (&myDocumentManager->getDocument(index) == myLoadingDocument)
+    {
+        cancelLoad();
+        finishLoad();
+        return true;
+    }
+
     // Prompt to save modified documents.
     if (isWindowModified())
     {
@@ -327,7 +722,7 @@ bool PowerTabEditor::closeTab(int index)
         const int ret = msg.exec();
         if (ret == QMessageBox::Save)
         {
-            if (!saveFile())
+            if (!saveFileAndWait())
                 return false;
         }
         else if (ret == QMessageBox::Cancel)
@@ -337,6 +732,16 @@ bool PowerTabEditor::closeTab(int index)
     if (myDocumentManager->getDocument(index).getCaret().isInPlaybackMode())
         startStopPlayback();
 
+    // Don't remove a document that is still being saved.
+    finishSave();
+
+    // The document's unsaved changes no longer need to be recovered.
+    if (RecoveryJournal *journal =
+            myDocumentManager->getDocument(index).getJournal())
+    {
+        journal->clear();
+    }
+
     myUndoManager->removeStack(index);
     myDocumentManager->removeDocument(index);
     delete myTabWidget->widget(index);
@@ -358,7 +763,7 @@ bool PowerTabEditor::closeCurrentTab()
     return closeTab(myDocumentManager->getCurrentDocumentIndex());
 }
 
-bool PowerTabEditor::saveFile()
+PowerTabEditor::SaveResult PowerTabEditor::saveFile()
 {
     const Document &doc = myDocumentManager->getCurrentDocument();
     if (!doc.hasFilename())
@@ -369,59 +774,108 @@ bool PowerTabEditor::saveFile()
                                                  : saveFileAs();
 }
 
-bool PowerTabEditor::saveFile(QString path)
+PowerTabEditor::SaveResult PowerTabEditor::saveFile(QString path)
 {
     QFileInfo info(path);
     QString extension = info.suffix();
     Q_ASSERT(!extension.isEmpty());
 
     boost::optional<FileFormat> format =
-        myFileFormatManager->findFormat(extension.toStdString());
+        myFileFormatManager->findExportFormat(extension.toStdString());
     if (!format)
     {
         QMessageBox::warning(this, tr("Error Saving File"),
                              tr("Unsupported file type."));
-        return false;
+        return SaveResult::Failed;
     }
 
-    const std::string path_str = path.toStdString();
+    // Only one save runs at a time.
+    finishSave();
+
     Document &doc = myDocumentManager->getCurrentDocument();
+    mySavingDocument = &doc;
+    mySavingUndoStack = myUndoManager->activeStack();
+    mySavingUndoIndex = mySavingUndoStack->index();
 
-    try
-    {
-        myFileFormatManager->exportFile(doc.getScore(), path_str, *format);
-    }
-    catch (const std::exception &e)
+    // Export a snapshot of the score, so that editing can continue while the
+    // file is written.
+    myDocumentSaver.reset(new DocumentSaver(*myFileFormatManager,
+                                            doc.getScore().clone(),
+                                            path.toStdString(), *format));
+    connect(myDocumentSaver.get(), &QThread::finished, this,
+            &PowerTabEditor::finishSave);
+
+    statusBar()->showMessage(tr("Saving %1...").arg(info.fileName()));
+    mySaveProgressBar->show();
+    myDocumentSaver->start();
+
+    return SaveResult::Pending;
+}
+
+bool PowerTabEditor::saveFileAndWait()
+{
+    return saveFile() == SaveResult::Pending && finishSave();
+}
+
+bool PowerTabEditor::finishSave()
+{
+    if (!myDocumentSaver)
+        return true;
+
+    // Take ownership before showing any dialogs, since their event loop
+    // could deliver the finished() signal and call this again.
+    myDocumentSaver->wait();
+    std::unique_ptr<DocumentSaver> saver(std::move(myDocumentSaver));
+
+    mySaveProgressBar->hide();
+    statusBar()->clearMessage();
+
+    if (!saver->succeeded())
     {
         QMessageBox::warning(
             this, tr("Error Saving File"),
-            tr("Error saving file: %1").arg(QString(e.what())));
+            tr("Error saving file: %1")
+                .arg(QString::fromStdString(saver->getErrorMessage())));
 
         return false;
     }
 
-    if (extension == "pt2")
+    const QString path = QString::fromStdString(saver->getPath());
+    QFileInfo info(path);
+    if (info.suffix() == "pt2")
     {
-        doc.setFilename(path_str);
+        mySavingDocument->setFilename(saver->getPath());
+
+        // Update the window title and tab bar. Another tab may have been
+        // selected while the save was in progress.
+        if (mySavingDocument == &myDocumentManager->getCurrentDocument())
+            updateWindowTitle();
 
-        // Update window title and tab bar.
-        updateWindowTitle();
         const QString filename = info.fileName();
-        myTabWidget->setTabText(myTabWidget->currentIndex(), filename);
-        myTabWidget->setTabToolTip(myTabWidget->currentIndex(), filename);
+        for (int i = 0; i < myTabWidget->count(); ++i)
+        {
+            if (&myDocumentManager->getDocument(i) == mySavingDocument)
+            {
+                myTabWidget->setTabText(i, filename);
+                myTabWidget->setTabToolTip(i, filename);
+            }
+        }
 
         // Add to the recent files list and update the last used directory.
         myRecentFiles->add(path);
         setPreviousDirectory(path);
 
-        // Mark the file as being in an unmodified state.
-        myUndoManager->setClean();
+        // Mark the file as being in an unmodified state, unless it was
+        // edited while the save was in progress.
+        if (mySavingUndoStack->index() == mySavingUndoIndex)
+            mySavingUndoStack->setClean();
     }
 
+    statusBar()->showMessage(tr("Saved %1").arg(info.fileName()), 2000);
     return true;
 }
 
-bool PowerTabEditor::saveFileAs()
+PowerTabEditor::SaveResult PowerTabEditor::saveFileAs()
 {
     const QString filter =
         QString::fromStdString(myFileFormatManager->exportFileFilter());
@@ -433,7 +887,7 @@ bool PowerTabEditor::saveFileAs()
     {
         QString path = dialog.selectedFiles().first();
         if (path.isEmpty())
-            return false;
+            return SaveResult::Failed;
 
         // Add a suitable file extension if necessary.
         QFileInfo info(path);
@@ -442,7 +896,7 @@ bool PowerTabEditor::saveFileAs()
             const QString file_filter = dialog.selectedNameFilter();
             QRegExp regex("\\*.(\\w+)");
             if (regex.indexIn(file_filter, 0) < 0)
-                return false;
+                return SaveResult::Failed;
 
             const QString extension = regex.cap(1);
             path += ".";
@@ -452,7 +906,7 @@ bool PowerTabEditor::saveFileAs()
         return saveFile(path);
     }
     else
-        return false;
+        return SaveResult::Failed;
 }
 
 void PowerTabEditor::updateModified(bool clean)
@@ -818,7 +1272,7 @@ void PowerTabEditor::gotoRehearsalSign()
 
 void PowerTabEditor::editChordName()
 {
-    ScoreLocation &location(getLocation());
+    const ScoreLocation &location = getLocation();
 
     if (!ScoreUtils::findByPosition(location.getSystem().getChords(),
                                     location.getPositionIndex()))
@@ -844,7 +1298,7 @@ void PowerTabEditor::editChordName()
 
 void PowerTabEditor::editTextItem()
 {
-    ScoreLocation &location(getLocation());
+    const ScoreLocation &location = getLocation();
 
     if (!ScoreUtils::findByPosition(location.getSystem().getTextItems(),
                                     location.getPositionIndex()))
@@ -981,7 +1435,7 @@ void PowerTabEditor::changeNoteDuration(bool increase)
 
 void PowerTabEditor::addDot()
 {
-    ScoreLocation &location = getLocation();
+    const ScoreLocation &location = getLocation();
     const Position *pos = location.getPosition();
     Q_ASSERT(pos);
 
@@ -1003,7 +1457,7 @@ void PowerTabEditor::addDot()
 
 void PowerTabEditor::removeDot()
 {
-    ScoreLocation &location = getLocation();
+    const ScoreLocation &location = getLocation();
     const Position *pos = location.getPosition();
     Q_ASSERT(pos);
 
@@ -1025,7 +1479,7 @@ void PowerTabEditor::removeDot()
 
 void PowerTabEditor::editTiedNote()
 {
-    ScoreLocation &location = getLocation();
+    const ScoreLocation &location = getLocation();
     const Voice &voice = location.getVoice();
 
     // If at an empty position, try to insert a new note that's tied to the
@@ -1060,7 +1514,8 @@ void PowerTabEditor::editTiedNote()
         }
         else
         {
-            std::vector<Position *> positions = location.getSelectedPositions();
+            std::vector<const Position *> positions =
+                location.getSelectedPositions();
             // Check that all selected notes can be tied.
             for (const Position *pos : positions)
             {
@@ -1083,8 +1538,9 @@ void PowerTabEditor::editTiedNote()
 
 void PowerTabEditor::editIrregularGrouping(bool setAsTriplet)
 {
-    ScoreLocation &location = getLocation();
-    std::vector<Position *> selectedPositions = location.getSelectedPositions();
+    const ScoreLocation &location = getLocation();
+    std::vector<const Position *> selectedPositions =
+        location.getSelectedPositions();
     Q_ASSERT(!selectedPositions.empty());
 
     if (selectedPositions.size() == 1)
@@ -1129,7 +1585,7 @@ void PowerTabEditor::editIrregularGrouping(bool setAsTriplet)
 
 void PowerTabEditor::addRest()
 {
-    ScoreLocation &location = getLocation();
+    const ScoreLocation &location = getLocation();
     const Position *pos = location.getPosition();
     const Position::DurationType duration =
         pos ? pos->getDurationType() : myActiveDurationType;
@@ -1324,8 +1780,8 @@ void PowerTabEditor::editMusicalDirection()
 
 void PowerTabEditor::editRepeatEnding()
 {
-    ScoreLocation &location(getLocation());
-    AlternateEnding *ending = ScoreUtils::findByPosition(
+    const ScoreLocation &location = getLocation();
+    const AlternateEnding *ending = ScoreUtils::findByPosition(
                 location.getSystem().getAlternateEndings(),
                 location.getPositionIndex());
 
@@ -1351,7 +1807,7 @@ void PowerTabEditor::editRepeatEnding()
 
 void PowerTabEditor::editDynamic()
 {
-    ScoreLocation &location = getLocation();
+    const ScoreLocation &location = getLocation();
     const Dynamic *dynamic = ScoreUtils::findByPosition(
                 location.getStaff().getDynamics(), location.getPositionIndex());
 
@@ -1378,7 +1834,7 @@ void PowerTabEditor::editDynamic()
 
 void PowerTabEditor::editHammerPull()
 {
-    ScoreLocation &location = getLocation();
+    const ScoreLocation &location = getLocation();
     const Voice &voice = location.getVoice();
     const int position = location.getPositionIndex();
     const Note *note = location.getNote();
@@ -1665,7 +2121,7 @@ bool PowerTabEditor::eventFilter(QObject *object, QEvent *event)
         if (keyEvent->key() >= Qt::Key_0 && keyEvent->key() <= Qt::Key_9)
         {
             const int number = keyEvent->key() - Qt::Key_0;
-            ScoreLocation &location = getLocation();
+            const ScoreLocation &location = getLocation();
 
             // Don't allow inserting notes at the same position as a barline,
             // unless it's the first position of the system.
@@ -1696,6 +2152,9 @@ bool PowerTabEditor::eventFilter(QObject *object, QEvent *event)
 
 void PowerTabEditor::closeEvent(QCloseEvent *event)
 {
+    cancelLoad();
+    finishLoad();
+
     while (myTabWidget->currentIndex() != -1)
     {
         if (!closeCurrentTab())
@@ -1787,6 +2246,12 @@ void PowerTabEditor::createCommands()
                                     QKeySequence::Open, this);
     connect(myOpenFileCommand, SIGNAL(triggered()), this, SLOT(openFile()));
 
+    myScoreLibraryCommand = new Command(tr("Score &Library..."),
+                                        "File.ScoreLibrary", QKeySequence(),
+                                        this);
+    connect(myScoreLibraryCommand, SIGNAL(triggered()), this,
+            SLOT(openScoreLibrary()));
+
     myCloseTabCommand = new Command(tr("&Close Tab"), "File.CloseTab",
                                     Qt::CTRL + Qt::Key_W, this);
     connect(myCloseTabCommand, SIGNAL(triggered()), this,
@@ -2640,6 +3105,7 @@ void PowerTabEditor::createMenus()
     myFileMenu = menuBar()->addMenu(tr("&File"));
     myFileMenu->addAction(myNewDocumentCommand);
     myFileMenu->addAction(myOpenFileCommand);
+    myFileMenu->addAction(myScoreLibraryCommand);
     myFileMenu->addAction(myCloseTabCommand);
     myFileMenu->addSeparator();
     myFileMenu->addAction(mySaveCommand);
@@ -2933,6 +3399,7 @@ void PowerTabEditor::setupNewTab()
         updateLocationLabel();
     });
 
+    const Document *document = &doc;
     auto scorearea = new ScoreArea(this);
     scorearea->renderDocument(doc);
     scorearea->installEventFilter(this);
@@ -2941,6 +3408,10 @@ void PowerTabEditor::setupNewTab()
     // to the appropriate event handlers.
     scorearea->getClickPubSub()->subscribe([=](ClickType type,
                                                const ScoreLocation &location) {
+        // The document can't be edited until it has finished loading.
+        if (document == myLoadingDocument)
+            return;
+
         switch (type)
         {
             case ClickType::Barline:
@@ -3035,7 +3506,7 @@ void PowerTabEditor::updateCommands()
     if (myIsPlaying)
         return;
 
-    ScoreLocation location = getLocation();
+    const ScoreLocation &location = getLocation();
     const Score &score = location.getScore();
     if (score.getSystems().empty())
         return;
@@ -3275,9 +3746,29 @@ void PowerTabEditor::enableEditing(bool enable)
     myTabWidget->tabBar()->setEnabled(enable);
 }
 
+void PowerTabEditor::updateLoadingState()
+{
+    // Editing is already disabled during playback.
+    if (myIsPlaying)
+        return;
+
+    const bool loading =
+        myDocumentManager->hasOpenDocuments() &&
+        &myDocumentManager->getCurrentDocument() == myLoadingDocument;
+
+    enableEditing(!loading);
+    myPlayPauseCommand->setEnabled(!loading);
+    myPlaybackWidget->setEnabled(!loading);
+
+    // Other documents can still be viewed and edited during the load.
+    myNextTabCommand->setEnabled(true);
+    myPrevTabCommand->setEnabled(true);
+    myTabWidget->tabBar()->setEnabled(true);
+}
+
 void PowerTabEditor::editRest(Position::DurationType duration)
 {
-    ScoreLocation &location = getLocation();
+    const ScoreLocation &location = getLocation();
     const Position *pos = location.getPosition();
 
     if (pos && pos->isRest())
@@ -3359,7 +3850,8 @@ void PowerTabEditor::editKeySignature(const ScoreLocation &keyLocation)
     location.setSystemIndex(keyLocation.getSystemIndex());
     location.setPositionIndex(keyLocation.getPositionIndex());
 
-    const Barline *barline = location.getBarline();
+    const Barline *barline =
+        const_cast<const ScoreLocation &>(location).getBarline();
     Q_ASSERT(barline);
 
     KeySignatureDialog dialog(this, barline->getKeySignature());
@@ -3376,7 +3868,8 @@ void PowerTabEditor::editTimeSignature(const ScoreLocation &timeLocation)
     location.setSystemIndex(timeLocation.getSystemIndex());
     location.setPositionIndex(timeLocation.getPositionIndex());
 
-    const Barline *barline = location.getBarline();
+    const Barline *barline =
+        const_cast<const ScoreLocation &>(location).getBarline();
     Q_ASSERT(barline);
 
     TimeSignatureDialog dialog(this, barline->getTimeSignature());
@@ -3390,13 +3883,14 @@ void PowerTabEditor::editTimeSignature(const ScoreLocation &timeLocation)
 
 void PowerTabEditor::editBarline(const ScoreLocation &barLocation)
 {
-	ScoreLocation location(getLocation());
+    ScoreLocation location(getLocation());
     location.setSystemIndex(barLocation.getSystemIndex());
     location.setPositionIndex(barLocation.getPositionIndex());
-    System &system = location.getSystem();
+    const System &system =
+        const_cast<const ScoreLocation &>(location).getSystem();
 
-    Barline *barline = ScoreUtils::findByPosition(system.getBarlines(),
-                                                  location.getPositionIndex());
+    const Barline *barline = ScoreUtils::findByPosition(
+        system.getBarlines(), location.getPositionIndex());
 
     if (barline)
     {
@@ -3432,7 +3926,8 @@ void PowerTabEditor::editClef(int system, int staff)
     location.setSystemIndex(system);
     location.setStaffIndex(staff);
 
-    const Staff &currentStaff = location.getStaff();
+    const Staff &currentStaff =
+        const_cast<const ScoreLocation &>(location).getStaff();
     Staff::ClefType newClef = currentStaff.getClefType() == Staff::TrebleClef
                                   ? Staff::BassClef
                                   : Staff::TrebleClef;
@@ -3445,8 +3940,9 @@ void PowerTabEditor::editClef(int system, int staff)
 void PowerTabEditor::editSimplePositionProperty(Command *command,
                                                 Position::SimpleProperty property)
 {
-    ScoreLocation &location = getLocation();
-    std::vector<Position *> selectedPositions = location.getSelectedPositions();
+    const ScoreLocation &location = getLocation();
+    std::vector<const Position *> selectedPositions =
+        location.getSelectedPositions();
     if (selectedPositions.empty())
         return;
 
@@ -3476,8 +3972,8 @@ void PowerTabEditor::editSimplePositionProperty(Command *command,
 void PowerTabEditor::editSimpleNoteProperty(Command *command,
                                             Note::SimpleProperty property)
 {
-    ScoreLocation &location = getLocation();
-    std::vector<Note *> selectedNotes = location.getSelectedNotes();
+    const ScoreLocation &location = getLocation();
+    std::vector<const Note *> selectedNotes = location.getSelectedNotes();
     if (selectedNotes.empty())
         return;
 
@@ -3514,7 +4010,8 @@ void PowerTabEditor::insertStaff(int index)
 {
     StaffDialog dialog(this);
 
-    const Staff &current_staff = getLocation().getStaff();
+    const ScoreLocation &location = getLocation();
+    const Staff &current_staff = location.getStaff();
     dialog.setStringCount(current_staff.getStringCount());
 
     if (dialog.exec() == QDialog::Accepted)
@@ -3523,8 +4020,8 @@ void PowerTabEditor::insertStaff(int index)
         staff.setStringCount(dialog.getStringCount());
         staff.setClefType(dialog.getClefType());
 
-        myUndoManager->push(new AddStaff(getLocation(), staff, index),
-                            getLocation().getSystemIndex());
+        myUndoManager->push(new AddStaff(location, staff, index),
+                            location.getSystemIndex());
     }
 }
 
@@ -3536,7 +4033,8 @@ void PowerTabEditor::editStaff(int system, int staff)
 
     StaffDialog dialog(this);
 
-    const Staff &currentStaff = location.getStaff();
+    const Staff &currentStaff =
+        const_cast<const ScoreLocation &>(location).getStaff();
     dialog.setStringCount(currentStaff.getStringCount());
     dialog.setClefType(currentStaff.getClefType());
 
@@ -3559,6 +4057,12 @@ ScoreArea *PowerTabEditor::getScoreArea()
     return dynamic_cast<ScoreArea *>(myTabWidget->currentWidget());
 }
 
+ScoreArea *PowerTabEditor::getScoreArea(const Document &doc)
+{
+    return dynamic_cast<ScoreArea *>(
+        myTabWidget->widget(myDocumentManager->findDocument(doc)));
+}
+
 Caret &PowerTabEditor::getCaret()
 {
     return myDocumentManager->getCurrentDocument().getCaret();
@@ -24,19 +24,28 @@
 #include <app/pubsub/playerpubsub.h>
 #include <memory>
 #include <score/position.h>
+#include <set>
 #include <string>
 #include <vector>
 
 class Caret;
 class Command;
+class Document;
+class DocumentLoader;
 class DocumentManager;
+class DocumentSaver;
 class FileFormatManager;
 class InstrumentPanel;
 class MidiPlayer;
 class Mixer;
 class PlaybackWidget;
 class QActionGroup;
+class QLockFile;
+class QProgressBar;
+class QPushButton;
+class QUndoStack;
 class RecentFiles;
+class ScoreLibrary;
 class ScoreArea;
 class ScoreLocation;
 class SettingsManager;
@@ -54,6 +63,24 @@ public:
     /// Opens the given list of files.
     void openFiles(const QStringList &files);
 
+    /// Offers to restore any documents that still had unsaved changes when
+    /// the program last exited (e.g. because it crashed). The journals of
+    /// other instances that are still running are ignored, and the journals
+    /// are kept if the user declines to recover them.
+    void recoverDocuments();
+
+private:
+    /// The outcome of starting to save a document.
+    enum class SaveResult
+    {
+        /// Nothing will be saved, due to an error or because the user
+        /// cancelled.
+        Failed,
+        /// The file is being written in the background. finishSave() waits
+        /// for it and reports whether it succeeded.
+        Pending
+    };
+
 private slots:
     /// Creates a new (blank) document.
     void createNewDocument();
@@ -62,6 +89,9 @@ private slots:
     /// to select a filename.
     void openFile(QString filename = "");
 
+    /// Shows a dialog to search the score library for files to open.
+    void openScoreLibrary();
+
     /// Handle when the active tab is changed.
     void switchTab(int index);
 
@@ -73,13 +103,11 @@ private slots:
     /// @return True if the document was closed successfully.
     bool closeCurrentTab();
 
-    /// Saves the current document.
-    /// @return True if the file was successfully saved.
-    bool saveFile();
+    /// Saves the current document in the background.
+    SaveResult saveFile();
 
-    /// Saves the current document to a new filename.
-    /// @return True if the file was successfully saved.
-    bool saveFileAs();
+    /// Saves the current document to a new filename in the background.
+    SaveResult saveFileAs();
 
     /// Prints the current document.
     void printDocument();
@@ -327,11 +355,23 @@ private:
     void setPreviousDirectory(const QString &fileName);
     /// Sets up the UI for the current document after it has been opened.
     void setupNewTab();
+    /// Displays the systems that have been loaded in the background. The
+    /// document's tab is created as soon as the first systems are available,
+    /// but can't be edited until the file has finished loading.
+    void addImportedSystems();
+    /// Asks the file that is being loaded in the background to stop loading.
+    void cancelLoad();
+    /// Waits for any file that is being loaded, and then enables editing of
+    /// the document or reports the error.
+    void finishLoad();
     /// Updates whether menu items are enabled, checked, etc. depending on the
     /// current location.
     void updateCommands();
     /// Enables or disables all editing commands.
     void enableEditing(bool enable);
+    /// Disables editing and playback if the current document is still being
+    /// loaded, and enables them otherwise.
+    void updateLoadingState();
 
     /// Moves the caret back to the start, and restarts playback if necessary.
     void rewindPlaybackToStart();
@@ -348,9 +388,32 @@ private:
     /// Updates the playback widget with the caret's current location.
     void updateLocationLabel();
 
-    /// Saves the current document to the specified path.
-    /// @return True if the file was successfully saved.
-    bool saveFile(QString path);
+    /// Saves the current document to the specified path. A snapshot of the
+    /// score is exported in the background, and finishSave() is called when
+    /// it completes.
+    SaveResult saveFile(QString path);
+    /// Saves the current document and waits for the file to be written.
+    /// @return True if the file was saved.
+    bool saveFileAndWait();
+    /// Waits for any save that is in progress, and then updates the document
+    /// (filename, clean state, etc) or reports the error.
+    /// @return True if there was no save in progress, or it succeeded.
+    bool finishSave();
+
+    /// Notes the systems that were modified by an undo command, so that they
+    /// can be written to the document's recovery journal.
+    void recordSystemEdit(int system);
+    void recordScoreEdit();
+    /// Writes the pending edits to the current document's recovery journal,
+    /// once the undo command has been committed.
+    void writeJournal();
+    /// Returns the directory for this instance's recovery journals, which is
+    /// locked the first time that it is used.
+    /// @throw std::exception if the directory can't be locked.
+    const std::string &getRecoveryDirectory();
+    /// Deletes the current document's recovery journal when the document no
+    /// longer has any unsaved changes.
+    void discardJournal(bool clean);
 
     /// Adds or removes a rest at the current location.
     void editRest(Position::DurationType duration);
@@ -381,17 +444,41 @@ private:
 
     /// Returns the score area for the active document.
     ScoreArea *getScoreArea();
+    /// Returns the score area that displays the given document.
+    ScoreArea *getScoreArea(const Document &doc);
     /// Returns the caret for the active document.
     Caret &getCaret();
     /// Returns the location of the caret within the active document.
     ScoreLocation &getLocation();
 
     std::unique_ptr<SettingsManager> mySettingsManager;
+    /// Held while this instance may be writing recovery journals, so that
+    /// other instances don't treat them as orphaned. It is released after
+    /// the documents (and their journals) are destroyed.
+    std::unique_ptr<QLockFile> myRecoveryLock;
+    std::string myRecoveryDirectory;
     std::unique_ptr<DocumentManager> myDocumentManager;
     std::unique_ptr<FileFormatManager> myFileFormatManager;
     std::unique_ptr<UndoManager> myUndoManager;
     std::unique_ptr<MidiPlayer> myMidiPlayer;
     std::unique_ptr<TuningDictionary> myTuningDictionary;
+    /// The index of the user's scores, which is loaded when it is first used.
+    std::unique_ptr<ScoreLibrary> myScoreLibrary;
+    /// The file that is currently being loaded in the background, if any.
+    std::unique_ptr<DocumentLoader> myDocumentLoader;
+    /// The document being loaded, once its first systems have been displayed.
+    Document *myLoadingDocument;
+    /// The save that is currently running in the background, if any.
+    std::unique_ptr<DocumentSaver> myDocumentSaver;
+    /// The document being saved, and the state of its undo stack when the
+    /// snapshot was taken. The document is only marked as clean if it hasn't
+    /// been edited since then.
+    Document *mySavingDocument;
+    QUndoStack *mySavingUndoStack;
+    int mySavingUndoIndex;
+    /// The edits that haven't been written to the recovery journal yet.
+    std::set<int> myJournalSystems;
+    bool myJournalScoreChanged;
     PlayerEditPubSub myPlayerEditPubSub;
     PlayerRemovePubSub myPlayerRemovePubSub;
     InstrumentEditPubSub myInstrumentEditPubSub;
@@ -410,10 +497,14 @@ private:
     QDockWidget *myInstrumentDockWidget;
     PlaybackWidget *myPlaybackWidget;
     QWidget *myPlaybackArea;
+    QProgressBar *mySaveProgressBar;
+    QProgressBar *myLoadProgressBar;
+    QPushButton *myCancelLoadButton;
 
     QMenu *myFileMenu;
     Command *myNewDocumentCommand;
     Command *myOpenFileCommand;
+    Command *myScoreLibraryCommand;
     Command *myCloseTabCommand;
     Command *mySaveCommand;
     Command *mySaveAsCommand;
@@ -18,8 +18,8 @@
 #include "recentfiles.h"
 
 #include <app/settings.h>
-#include <app/settingsmanager.h>
 #include <QMenu>
+#include <util/settingsmanager.h>
 #ifdef _WIN32
 #include <QDir>
 #include <shlobj.h>
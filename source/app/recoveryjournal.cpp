@@ -0,0 +1,347 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "recoveryjournal.h"
+
+#include <algorithm>
+#include <boost/filesystem/operations.hpp>
+#include <chrono>
+#include <memory>
+#include <score/binaryserialization.h>
+#include <score/score.h>
+#include <sstream>
+#include <stdexcept>
+#include <util/atomicfile.h>
+
+namespace fs = boost::filesystem;
+
+static const char *theSnapshotFilename = "snapshot";
+static const char *theSegmentPrefix = "segment-";
+
+/// Segments are compacted once they are larger than this, or larger than the
+/// last snapshot if it is bigger.
+static const uint64_t theMinCompactionSize = 1024 * 1024;
+
+namespace
+{
+/// The contents of a snapshot file.
+struct JournalSnapshot
+{
+    explicit JournalSnapshot(Score &score)
+        : segment(0), undoIndex(0), score(score)
+    {
+    }
+
+    template <class Archive>
+    void serialize(Archive &ar, const FileVersion /*version*/)
+    {
+        ar("segment", segment);
+        ar("undo_index", undoIndex);
+        ar("filename", filename);
+        ar("score", score);
+    }
+
+    /// The first segment to replay onto the snapshot.
+    int64_t segment;
+    int undoIndex;
+    std::string filename;
+    Score &score;
+};
+
+/// A modified system, which is stored in a segment.
+struct JournalRecord
+{
+    explicit JournalRecord(System &system)
+        : undoIndex(0), systemIndex(0), system(system)
+    {
+    }
+
+    template <class Archive>
+    void serialize(Archive &ar, const FileVersion /*version*/)
+    {
+        ar("undo_index", undoIndex);
+        ar("system_index", systemIndex);
+        ar("system", system);
+    }
+
+    int undoIndex;
+    int systemIndex;
+    System &system;
+};
+}
+
+/// Computes a 64-bit FNV-1a hash, to detect partially written records.
+static uint64_t hashRecord(const std::string &data)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : data)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+static void writeFixed(std::ostream &os, uint64_t value, int num_bytes)
+{
+    for (int i = 0; i < num_bytes; ++i)
+        os.put(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+static bool readFixed(std::istream &is, uint64_t &value, int num_bytes)
+{
+    value = 0;
+    for (int i = 0; i < num_bytes; ++i)
+    {
+        const int c = is.get();
+        if (c == std::char_traits<char>::eof())
+            return false;
+
+        value |= static_cast<uint64_t>(c) << (8 * i);
+    }
+
+    return true;
+}
+
+static fs::path getSegmentPath(const fs::path &dir, int64_t segment)
+{
+    return dir / (theSegmentPrefix + std::to_string(segment));
+}
+
+/// Reads the records in a segment and applies them to the score.
+/// @return False if the segment ended with an incomplete or invalid record.
+static bool replaySegment(std::istream &input, Score &score,
+                          RecoveredDocument &document)
+{
+    while (input.peek() != std::char_traits<char>::eof())
+    {
+        uint64_t size, hash;
+        if (!readFixed(input, size, 4) || !readFixed(input, hash, 8))
+            return false;
+
+        std::string data(size, '\0');
+        if (!input.read(&data[0], size) || hashRecord(data) != hash)
+            return false;
+
+        std::istringstream stream(data);
+        auto system = std::make_shared<System>();
+        JournalRecord record(*system);
+        ScoreUtils::loadBinary(stream, "record", record);
+
+        if (record.systemIndex < 0 ||
+            record.systemIndex >= static_cast<int>(score.getSystems().size()))
+        {
+            return false;
+        }
+
+        score.setSystem(record.systemIndex, std::move(system));
+        document.undoIndex = record.undoIndex;
+        ++document.numEdits;
+    }
+
+    return true;
+}
+
+RecoveredDocument::RecoveredDocument() : undoIndex(0), numEdits(0)
+{
+}
+
+RecoveryJournal::RecoveryJournal(const std::string &dir)
+    : myDirectory(dir), mySegment(-1), mySegmentSize(0), mySnapshotSize(0)
+{
+}
+
+RecoveryJournal::~RecoveryJournal()
+{
+    if (mySnapshotTask.valid())
+        mySnapshotTask.wait();
+}
+
+void RecoveryJournal::setFilename(const std::string &filename)
+{
+    myFilename = filename;
+}
+
+void RecoveryJournal::recordSystem(const Score &score, int system_index,
+                                   int undo_index)
+{
+    // The first edit needs a snapshot to be replayed onto.
+    if (mySegment < 0)
+    {
+        startSnapshot(score, undo_index, false);
+        return;
+    }
+
+    std::ostringstream stream;
+    {
+        // The system is only read from when saving, and the rest of the
+        // score isn't touched.
+        JournalRecord record(
+            const_cast<System &>(score.getSystems()[system_index]));
+        record.undoIndex = undo_index;
+        record.systemIndex = system_index;
+        ScoreUtils::saveBinary(stream, "record", record);
+    }
+    const std::string data = stream.str();
+
+    writeFixed(mySegmentFile, data.size(), 4);
+    writeFixed(mySegmentFile, hashRecord(data), 8);
+    mySegmentFile.write(data.data(), data.size());
+    // Pass the record to the OS, so that it survives if the program crashes.
+    mySegmentFile.flush();
+    if (!mySegmentFile)
+        throw std::runtime_error("Error writing to the recovery journal.");
+
+    mySegmentSize += 12 + data.size();
+
+    // Periodically compact the journal, unless the previous snapshot is still
+    // being written.
+    if (mySegmentSize > std::max<uint64_t>(theMinCompactionSize,
+                                           mySnapshotSize) &&
+        (!mySnapshotTask.valid() ||
+         mySnapshotTask.wait_for(std::chrono::seconds(0)) ==
+             std::future_status::ready))
+    {
+        startSnapshot(score, undo_index, true);
+    }
+}
+
+void RecoveryJournal::recordScore(const Score &score, int undo_index)
+{
+    startSnapshot(score, undo_index, false);
+}
+
+void RecoveryJournal::flush()
+{
+    if (mySnapshotTask.valid())
+        mySnapshotTask.get();
+}
+
+void RecoveryJournal::clear()
+{
+    if (mySnapshotTask.valid())
+        mySnapshotTask.wait();
+    mySnapshotTask = std::future<void>();
+
+    mySegmentFile.close();
+    mySegment = -1;
+    mySegmentSize = 0;
+
+    boost::system::error_code error;
+    fs::remove_all(myDirectory, error);
+}
+
+void RecoveryJournal::startSnapshot(const Score &score, int undo_index,
+                                    bool continues)
+{
+    // Report any errors from the previous snapshot.
+    flush();
+
+    const fs::path dir(myDirectory);
+    if (mySegment < 0)
+        fs::create_directories(dir);
+
+    // Edits are recorded in a new segment while the snapshot is written.
+    // The segment notes whether its records can also be replayed after the
+    // previous segment, in case the snapshot is never written.
+    mySegmentFile.close();
+    ++mySegment;
+    mySegmentFile.open(getSegmentPath(dir, mySegment),
+                       std::ios::binary | std::ios::trunc);
+    mySegmentFile.put(continues ? 1 : 0);
+    mySegmentFile.flush();
+    if (!mySegmentFile)
+        throw std::runtime_error("Error writing to the recovery journal.");
+    mySegmentSize = 0;
+
+    std::shared_ptr<Score> snapshot(score.clone());
+    const int64_t segment = mySegment;
+    const std::string filename = myFilename;
+    std::atomic<uint64_t> &snapshot_size = mySnapshotSize;
+
+    mySnapshotTask = std::async(std::launch::async, [=, &snapshot_size]() {
+        const fs::path path = dir / theSnapshotFilename;
+        Util::writeFileAtomically(
+            path.string(), [&](const std::string &temp_path) {
+                fs::ofstream output(temp_path, std::ios::binary);
+
+                JournalSnapshot data(*snapshot);
+                data.segment = segment;
+                data.undoIndex = undo_index;
+                data.filename = filename;
+                ScoreUtils::saveBinary(output, "snapshot", data);
+
+                output.flush();
+                if (!output)
+                    throw std::runtime_error("Error writing snapshot.");
+            });
+        snapshot_size = fs::file_size(path);
+
+        // The older segments are no longer needed.
+        for (int64_t i = segment - 1; i >= 0; --i)
+        {
+            const fs::path segment_path = getSegmentPath(dir, i);
+            if (!fs::exists(segment_path))
+                break;
+
+            fs::remove(segment_path);
+        }
+    });
+}
+
+RecoveredDocument RecoveryJournal::recover(const std::string &dir,
+                                           Score &score)
+{
+    fs::ifstream input(fs::path(dir) / theSnapshotFilename, std::ios::binary);
+    if (!input)
+        throw std::runtime_error("The recovery journal has no snapshot.");
+
+    JournalSnapshot snapshot(score);
+    ScoreUtils::loadBinary(input, "snapshot", snapshot);
+
+    RecoveredDocument document;
+    document.filename = snapshot.filename;
+    document.undoIndex = snapshot.undoIndex;
+
+    for (int64_t segment = snapshot.segment;; ++segment)
+    {
+        fs::ifstream segment_input(getSegmentPath(dir, segment),
+                                   std::ios::binary);
+        if (!segment_input)
+            break;
+
+        // A segment that was started by an edit to the whole score can't be
+        // replayed without its snapshot.
+        const int continues = segment_input.get();
+        if (continues == std::char_traits<char>::eof() ||
+            (segment != snapshot.segment && !continues))
+        {
+            break;
+        }
+
+        if (!replaySegment(segment_input, score, document))
+            break;
+    }
+
+    return document;
+}
+
+bool RecoveryJournal::exists(const std::string &dir)
+{
+    return fs::exists(fs::path(dir) / theSnapshotFilename);
+}
@@ -0,0 +1,123 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef APP_RECOVERYJOURNAL_H
+#define APP_RECOVERYJOURNAL_H
+
+#include <atomic>
+#include <boost/filesystem/fstream.hpp>
+#include <cstdint>
+#include <future>
+#include <string>
+
+class Score;
+
+/// Information about a document that was restored by
+/// RecoveryJournal::recover().
+struct RecoveredDocument
+{
+    RecoveredDocument();
+
+    /// The file that the document was opened from, if any.
+    std::string filename;
+    /// The undo stack index after the last edit that was recovered.
+    int undoIndex;
+    /// The number of edits that were replayed onto the snapshot.
+    size_t numEdits;
+};
+
+/// A write-ahead log of the edits made to a document, so that unsaved
+/// changes can be recovered after a crash without periodically saving the
+/// entire score.
+///
+/// The journal's directory holds a snapshot of the score and a series of
+/// numbered segments. Each record in a segment contains a system that was
+/// modified and the undo stack index after the edit, so recording an edit
+/// only depends on the size of that system. Edits that may affect the whole
+/// score (e.g. adding a system or a player) instead start a new snapshot,
+/// which is also done periodically to keep the segments small. Snapshots are
+/// written in the background, after which the older segments are deleted.
+class RecoveryJournal
+{
+public:
+    /// Creates a journal in the given directory, which should not be shared
+    /// with any other documents. Nothing is written until an edit is
+    /// recorded.
+    explicit RecoveryJournal(const std::string &dir);
+    /// Waits for any snapshot that is being written. The journal is left on
+    /// disk unless clear() was called.
+    ~RecoveryJournal();
+
+    RecoveryJournal(const RecoveryJournal &) = delete;
+    RecoveryJournal &operator=(const RecoveryJournal &) = delete;
+
+    const std::string &getDirectory() const { return myDirectory; }
+
+    /// Sets the file that the document was opened from or saved to, which is
+    /// stored with the next snapshot.
+    void setFilename(const std::string &filename);
+
+    /// Records an edit that only modified the given system.
+    /// @throw std::exception if the journal can't be written.
+    void recordSystem(const Score &score, int system_index, int undo_index);
+
+    /// Records an edit that may have modified any part of the score, by
+    /// starting a new snapshot.
+    /// @throw std::exception if the journal can't be written.
+    void recordScore(const Score &score, int undo_index);
+
+    /// Waits for any snapshot that is being written.
+    /// @throw std::exception if the snapshot couldn't be written.
+    void flush();
+
+    /// Deletes the journal, e.g. once the document has been saved or closed.
+    /// The next edit that is recorded starts a new snapshot.
+    void clear();
+
+    /// Restores a document from a journal that was left behind (e.g. after a
+    /// crash), by replaying the edits onto the most recent snapshot. Any
+    /// edits after a partially written record are discarded.
+    /// @throw std::exception if the journal has no valid snapshot.
+    static RecoveredDocument recover(const std::string &dir, Score &score);
+
+    /// Returns whether the directory contains a journal that can be
+    /// recovered.
+    static bool exists(const std::string &dir);
+
+private:
+    /// Starts a new segment, and writes a snapshot of the score in the
+    /// background.
+    /// @param continues Whether the new segment continues from the previous
+    /// one, i.e. the score hasn't been changed since the last record.
+    void startSnapshot(const Score &score, int undo_index, bool continues);
+
+    const std::string myDirectory;
+    std::string myFilename;
+
+    /// The current segment, or -1 if a snapshot hasn't been started.
+    int64_t mySegment;
+    boost::filesystem::ofstream mySegmentFile;
+    uint64_t mySegmentSize;
+
+    /// The snapshot that is being written in the background.
+    std::future<void> mySnapshotTask;
+    /// The size of the last snapshot, which is used to decide when to
+    /// compact the journal.
+    std::atomic<uint64_t> mySnapshotSize;
+};
+
+#endif
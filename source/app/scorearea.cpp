@@ -51,6 +51,7 @@ void ScoreArea::renderDocument(const Document &document)
 {
     myScene.clear();
     myRenderedSystems.clear();
+    mySystemHandles.clear();
     myDocument = document;
 
     const Score &score = document.getScore();
@@ -67,7 +68,10 @@ void ScoreArea::renderDocument(const Document &document)
 
     myRenderedSystems.reserve(score.getSystems().size());
     for (unsigned int i = 0; i < score.getSystems().size(); ++i)
+    {
         myRenderedSystems.append(nullptr);
+        mySystemHandles.push_back(score.getSystemHandle(i));
+    }
 
 #if 0
     const int num_threads = std::thread::hardware_concurrency();
@@ -89,7 +93,7 @@ void ScoreArea::renderDocument(const Document &document)
             for (int i = left; i < right; ++i)
             {
                 SystemRenderer render(this, score, document.getViewOptions());
-                myRenderedSystems[i] = render(score.getSystems()[i], i);
+                myRenderedSystems[i] = render(*mySystemHandles[i], i);
             }
         }, left, right));
     }
@@ -112,6 +116,8 @@ void ScoreArea::renderDocument(const Document &document)
         myCaretPainter->addSystemRect(system->sceneBoundingRect());
     }
 
+    // Keep the caret above any systems that are added later.
+    myCaretPainter->setZValue(1);
     myScene.addItem(myCaretPainter);
 
     auto end = std::chrono::high_resolution_clock::now();
@@ -121,6 +127,36 @@ void ScoreArea::renderDocument(const Document &document)
     qDebug() << "Rendered " << myScene.items().size() << "items";
 }
 
+void ScoreArea::renderNewSystems()
+{
+    const Score &score = myDocument->getScore();
+    const int numSystems = static_cast<int>(score.getSystems().size());
+    if (numSystems == myRenderedSystems.size())
+        return;
+
+    if (myRenderedSystems.empty())
+    {
+        renderDocument(*myDocument);
+        return;
+    }
+
+    double height = myRenderedSystems.back()->sceneBoundingRect().bottom() +
+                    SYSTEM_SPACING;
+
+    SystemRenderer render(this, score, myDocument->getViewOptions());
+    for (int i = myRenderedSystems.size(); i < numSystems; ++i)
+    {
+        mySystemHandles.push_back(score.getSystemHandle(i));
+        QGraphicsItem *system = render(*mySystemHandles.back(), i);
+        system->setPos(0, height);
+        myScene.addItem(system);
+        height += system->boundingRect().height() + SYSTEM_SPACING;
+
+        myCaretPainter->addSystemRect(system->sceneBoundingRect());
+        myRenderedSystems.append(system);
+    }
+}
+
 void ScoreArea::redrawSystem(int index)
 {
     // Delete and remove the system from the scene.
@@ -128,7 +164,8 @@ void ScoreArea::redrawSystem(int index)
 
     const Score &score = myDocument->getScore();
     SystemRenderer render(this, score, myDocument->getViewOptions());
-    QGraphicsItem *newSystem = render(score.getSystems()[index], index);
+    mySystemHandles[index] = score.getSystemHandle(index);
+    QGraphicsItem *newSystem = render(*mySystemHandles[index], index);
 
     double height = 0;
     if (index > 0)
@@ -22,12 +22,15 @@
 #include <memory>
 #include <QGraphicsScene>
 #include <QGraphicsView>
+#include <score/score.h>
 #include <score/staff.h>
+#include <vector>
 
 class CaretPainter;
 class ClickPubSub;
 class Document;
 class QPrinter;
+class System;
 
 /// The visual display of the score.
 class ScoreArea : public QGraphicsView
@@ -46,6 +49,10 @@ public:
 
     void renderDocument(const Document &document);
 
+    /// Renders any systems that have been added to the end of the score since
+    /// it was drawn, e.g. while the rest of the file is still being loaded.
+    void renderNewSystems();
+
     void refreshZoom();
 
     void print(QPrinter &printer);
@@ -68,6 +75,10 @@ private:
     boost::optional<const Document &> myDocument;
     QGraphicsItem *myScoreInfoBlock;
     QList<QGraphicsItem *> myRenderedSystems;
+    /// The systems that were rendered. The painters refer to the systems, so
+    /// they are kept alive until they are redrawn even if the score replaces
+    /// them (e.g. by modifying a system that is shared with a snapshot).
+    std::vector<Score::SystemHandle> mySystemHandles;
     CaretPainter *myCaretPainter;
 
     std::shared_ptr<ClickPubSub> myClickPubSub;
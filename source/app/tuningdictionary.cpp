@@ -55,7 +55,9 @@ void TuningDictionary::save() const
         throw std::runtime_error("Error opening file for writing.");
 
     ensureLoaded();
-    ScoreUtils::save(file, "tunings", myTunings);
+    // Keep the user's tuning file readable, since it can be edited by hand.
+    ScoreUtils::save(file, "tunings", myTunings,
+                     ScoreUtils::JsonFormat::Pretty);
 }
 
 void TuningDictionary::loadInBackground()
@@ -17,21 +17,165 @@
   
 #include "midiplayer.h"
 
-#include <app/settingsmanager.h>
 #include <audio/midioutputdevice.h>
 #include <audio/settings.h>
+#include <algorithm>
 #include <boost/rational.hpp>
 #include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <map>
 #include <midi/midifile.h>
+#include <midi/settings.h>
+#include <QDebug>
 #include <score/generalmidi.h>
 #include <score/score.h>
+#include <string>
+#include <util/settingsmanager.h>
 
 #ifdef _WIN32
 #include <boost/scope_exit.hpp>
 #include <objbase.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #endif
 
 static const int METRONOME_CHANNEL = 9;
+/// Events that are sent more than this long after their scheduled time are
+/// counted as being late.
+static const int LATE_EVENT_THRESHOLD_US = 1000;
+
+/// Attempt to give the current thread real-time priority, so that it isn't
+/// preempted by other work such as rendering.
+static bool enableRealtimeScheduling(std::string &error)
+{
+#ifdef _WIN32
+    if (SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL))
+        return true;
+
+    error = "SetThreadPriority failed with error code " +
+            std::to_string(GetLastError());
+    return false;
+#else
+    for (int policy : { SCHED_FIFO, SCHED_RR })
+    {
+        const int min_priority = sched_get_priority_min(policy);
+        const int max_priority = sched_get_priority_max(policy);
+
+        sched_param param;
+        param.sched_priority = min_priority + (max_priority - min_priority) / 2;
+
+        const int result = pthread_setschedparam(pthread_self(), policy, &param);
+        if (result == 0)
+            return true;
+
+        error = std::strerror(result);
+    }
+
+    return false;
+#endif
+}
+
+/// A range of addresses, from the start of its first page to its end.
+typedef std::pair<uintptr_t, uintptr_t> MemoryRange;
+
+static uintptr_t getPageSize()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    return static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+/// Find the memory used by the events, including the data for each message,
+/// and merge it into as few ranges as possible so that it can be locked with
+/// a small number of system calls.
+static std::vector<MemoryRange> getEventMemory(const MidiEventList &events)
+{
+    const uintptr_t page_mask = ~(getPageSize() - 1);
+
+    std::vector<MemoryRange> ranges;
+    auto addRange = [&](const void *data, size_t size) {
+        if (size == 0)
+            return;
+
+        const uintptr_t address = reinterpret_cast<uintptr_t>(data);
+        ranges.push_back(MemoryRange(address & page_mask, address + size));
+    };
+
+    if (events.size())
+        addRange(&*events.begin(), events.size() * sizeof(MidiEvent));
+    for (const MidiEvent &event : events)
+        addRange(event.getData().data(), event.getData().size());
+
+    std::sort(ranges.begin(), ranges.end());
+
+    // Merge ranges that overlap or are on adjacent pages.
+    std::vector<MemoryRange> merged;
+    for (const MemoryRange &range : ranges)
+    {
+        if (!merged.empty() &&
+            range.first <= ((merged.back().second - 1) | ~page_mask) + 1)
+        {
+            merged.back().second = std::max(merged.back().second, range.second);
+        }
+        else
+            merged.push_back(range);
+    }
+
+    return merged;
+}
+
+static void unlockMemory(const std::vector<MemoryRange> &ranges)
+{
+    for (const MemoryRange &range : ranges)
+    {
+        void *data = reinterpret_cast<void *>(range.first);
+        const size_t size = range.second - range.first;
+#ifdef _WIN32
+        VirtualUnlock(data, size);
+#else
+        munlock(data, size);
+#endif
+    }
+}
+
+/// Lock the memory for the events into RAM so that playback can't be delayed
+/// by page faults.
+static bool lockMemory(const std::vector<MemoryRange> &ranges,
+                       std::string &error)
+{
+    for (auto it = ranges.begin(); it != ranges.end(); ++it)
+    {
+        void *data = reinterpret_cast<void *>(it->first);
+        const size_t size = it->second - it->first;
+#ifdef _WIN32
+        if (!VirtualLock(data, size))
+        {
+            error = "VirtualLock failed with error code " +
+                    std::to_string(GetLastError());
+        }
+#else
+        if (mlock(data, size) != 0)
+            error = std::strerror(errno);
+#endif
+        if (!error.empty())
+        {
+            unlockMemory(std::vector<MemoryRange>(ranges.begin(), it));
+            return false;
+        }
+    }
+
+    return true;
+}
 
 MidiPlayer::MidiPlayer(SettingsManager &settings_manager,
                        const ScoreLocation &start_location, int speed)
@@ -39,7 +183,12 @@ MidiPlayer::MidiPlayer(SettingsManager &settings_manager,
       myScore(start_location.getScore()),
       myStartLocation(start_location),
       myIsPlaying(false),
-      myPlaybackSpeed(speed)
+      myPlaybackSpeed(speed),
+      myStartupLatencyUs(0),
+      myNumEvents(0),
+      myNumLateEvents(0),
+      myMaxLatenessUs(0),
+      myTotalLatenessUs(0)
 {
 }
 
@@ -51,6 +200,9 @@ MidiPlayer::~MidiPlayer()
 
 void MidiPlayer::run()
 {
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point thread_start_time = Clock::now();
+
     // Workaround to fix errors with the Microsoft GS Wavetable Synth on
     // Windows 10 - see http://stackoverflow.com/a/32553208/586978
 #ifdef _WIN32
@@ -75,12 +227,14 @@ void MidiPlayer::run()
     // Load MIDI settings.
     int api;
     int port;
+    bool realtime;
     {
         auto settings = mySettingsManager.getReadHandle();
         myMetronomeEnabled = settings->get(Settings::MetronomeEnabled);
 
         api = settings->get(Settings::MidiApi);
         port = settings->get(Settings::MidiPort);
+        realtime = settings->get(Settings::MidiRealtimePlayback);
 
         options.myMetronomePreset = settings->get(Settings::MetronomePreset) +
                                     Midi::MIDI_PERCUSSION_PRESET_OFFSET;
@@ -90,8 +244,24 @@ void MidiPlayer::run()
         options.myVibratoStrength = settings->get(Settings::MidiVibratoLevel);
         options.myWideVibratoStrength =
             settings->get(Settings::MidiWideVibratoLevel);
+        options.myMaxBendError = settings->get(Settings::MidiBendTolerance);
+    }
+
+    if (realtime)
+    {
+        std::string error;
+        if (!enableRealtimeScheduling(error))
+        {
+            qWarning() << "Unable to enable real-time scheduling for playback:"
+                       << QString::fromStdString(error);
+        }
     }
 
+    // In real-time mode, expand all of the events up front so that nothing
+    // needs to be allocated once playback has started. Otherwise, modulation
+    // events are expanded during playback to save memory.
+    options.myCompactModulation = !realtime;
+
     MidiFile file;
     file.load(myScore, options);
 
@@ -107,7 +277,6 @@ void MidiPlayer::run()
 
     // TODO - since each track is already sorted, an n-way merge should be faster.
     std::stable_sort(events.begin(), events.end());
-    events.convertToDeltaTicks();
 
     // Initialize RtMidi and set the port.
     MidiOutputDevice device;
@@ -117,17 +286,78 @@ void MidiPlayer::run()
         return;
     }
 
+    std::vector<MemoryRange> event_memory;
+    bool memory_locked = false;
+    if (realtime)
+    {
+        std::string error;
+        event_memory = getEventMemory(events);
+        memory_locked = lockMemory(event_memory, error);
+        if (!memory_locked)
+        {
+            qWarning() << "Unable to lock playback events into memory:"
+                       << QString::fromStdString(error);
+        }
+    }
+
     bool started = false;
     int beat_duration = Midi::BEAT_DURATION_120_BPM;
+    int current_tick = 0;
+    Clock::time_point scheduled_time;
     const SystemLocation start_location(myStartLocation.getSystemIndex(),
                                         myStartLocation.getPositionIndex());
     SystemLocation current_location = start_location;
 
+    // Events from modulation descriptors (bends, trills, etc) are only
+    // expanded once playback reaches them, and are then merged in with the
+    // remaining events.
+    std::multimap<int, MidiEvent> pending_events;
+    std::vector<MidiEvent> expanded_events;
+    // Pitch wheel and expanded modulation events from before the start
+    // location, which are clipped once the start tick is known.
+    std::vector<MidiEvent> early_events;
+
+    // Sleep until the time for the given tick. The scheduled time is tracked
+    // separately from the current time, so that delays in sending one event
+    // don't accumulate over the rest of the song.
+    auto waitUntil = [&](int tick) {
+        const int delta = tick - current_tick;
+        assert(delta >= 0);
+
+        const int duration_us = boost::rational_cast<int>(
+            boost::rational<int>(delta, ticks_per_beat) * beat_duration);
+
+        scheduled_time += std::chrono::microseconds(
+            static_cast<int>(duration_us * (100.0 / myPlaybackSpeed)));
+        current_tick = tick;
+
+        const Clock::time_point now = Clock::now();
+        if (scheduled_time > now)
+        {
+            usleep(std::chrono::duration_cast<std::chrono::microseconds>(
+                       scheduled_time - now).count());
+        }
+
+        recordLateness(std::chrono::duration_cast<std::chrono::microseconds>(
+                           Clock::now() - scheduled_time).count());
+    };
+
     for (auto event = events.begin(); event != events.end(); ++event)
     {
         if (!isPlaying())
             break;
 
+        // Send any expanded events that occur before this event.
+        while (!pending_events.empty() &&
+               pending_events.begin()->first <= event->getTicks() &&
+               isPlaying())
+        {
+            const MidiEvent &pending_event = pending_events.begin()->second;
+            waitUntil(pending_event.getTicks());
+            device.sendMessage(pending_event.getData());
+            pending_events.erase(pending_events.begin());
+        }
+
         if (event->isTempoChange())
             beat_duration = event->getTempo();
 
@@ -139,24 +369,57 @@ void MidiPlayer::run()
             {
                 if (event->isProgramChange())
                     device.sendMessage(event->getData());
-
+                else
+                {
+                    // Keep track of the pitch wheel and any bends or trills
+                    // that might still be in progress. In real-time mode the
+                    // modulation has already been expanded, so this also
+                    // handles the individual pitch wheel events.
+                    event->recordSkippedEvent(early_events,
+                                              options.myMaxBendError);
+                }
+
+                current_tick = event->getTicks();
                 continue;
             }
             else
             {
+                myStartupLatencyUs =
+                    std::chrono::duration_cast<std::chrono::microseconds>(
+                        Clock::now() - thread_start_time).count();
+
                 performCountIn(device, event->getLocation(), beat_duration);
 
                 started = true;
+                scheduled_time = Clock::now();
+
+                // Play the remainder of any bends or trills that are in
+                // progress at the start location.
+                MidiEvent::clipModulation(early_events, event->getTicks());
+                for (const MidiEvent &early_event : early_events)
+                {
+                    pending_events.insert(
+                        std::make_pair(early_event.getTicks(), early_event));
+                }
+                early_events.clear();
             }
         }
 
-        const int delta = event->getTicks();
-        assert(delta >= 0);
+        if (event->isModulation())
+        {
+            expanded_events.clear();
+            event->expandModulation(expanded_events, options.myMaxBendError);
 
-        const int duration_us = boost::rational_cast<int>(
-            boost::rational<int>(delta, ticks_per_beat) * beat_duration);
+            for (const MidiEvent &expanded_event : expanded_events)
+            {
+                pending_events.insert(
+                    std::make_pair(expanded_event.getTicks(), expanded_event));
+            }
 
-        usleep(duration_us * (100.0 / myPlaybackSpeed));
+            continue;
+        }
+
+        waitUntil(event->getTicks());
 
         // Don't play metronome events if the metronome is disabled.
         if (event->isNoteOnOff() && event->getChannel() == METRONOME_CHANNEL &&
@@ -184,6 +447,9 @@ void MidiPlayer::run()
             current_location = new_location;
         }
     }
+
+    if (memory_locked)
+        unlockMemory(event_memory);
 }
 
 void MidiPlayer::performCountIn(MidiOutputDevice &device,
@@ -246,3 +512,27 @@ bool MidiPlayer::isPlaying() const
 {
     return myIsPlaying;
 }
+
+void MidiPlayer::recordLateness(int lateness_us)
+{
+    ++myNumEvents;
+    if (lateness_us > LATE_EVENT_THRESHOLD_US)
+        ++myNumLateEvents;
+
+    myTotalLatenessUs += lateness_us;
+    if (lateness_us > myMaxLatenessUs)
+        myMaxLatenessUs = lateness_us;
+}
+
+MidiPlayer::TimingStats MidiPlayer::getTimingStats() const
+{
+    TimingStats stats;
+    stats.myStartupLatencyUs = myStartupLatencyUs;
+    stats.myNumEvents = myNumEvents;
+    stats.myNumLateEvents = myNumLateEvents;
+    stats.myMaxLatenessUs = myMaxLatenessUs;
+    stats.myAverageLatenessUs =
+        stats.myNumEvents ? static_cast<int>(myTotalLatenessUs / stats.myNumEvents)
+                          : 0;
+    return stats;
+}
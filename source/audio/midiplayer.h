@@ -41,6 +41,26 @@ public:
 
     const ScoreLocation &getStartLocation() const { return myStartLocation; }
 
+    /// Timing statistics for playback, which can be used to check how well
+    /// the playback thread is keeping up.
+    struct TimingStats
+    {
+        /// Time from the start of the thread until playback was ready to
+        /// begin (before the count-in).
+        int myStartupLatencyUs;
+        /// Number of events that have been sent.
+        int myNumEvents;
+        /// Number of events that were sent more than 1ms after their
+        /// scheduled time.
+        int myNumLateEvents;
+        /// The maximum and average delay between an event's scheduled time
+        /// and when it was actually sent.
+        int myMaxLatenessUs;
+        int myAverageLatenessUs;
+    };
+
+    TimingStats getTimingStats() const;
+
 signals:
     // These signals are used to move the caret when a position change is
     // necessary
@@ -57,6 +77,8 @@ private:
     void setIsPlaying(bool set);
     bool isPlaying() const;
 
+    void recordLateness(int lateness_us);
+
     SettingsManager &mySettingsManager;
     const Score &myScore;
     ScoreLocation myStartLocation;
@@ -64,6 +86,12 @@ private:
     std::atomic<bool> myMetronomeEnabled;
     /// The current playback speed (percent).
     std::atomic<int> myPlaybackSpeed;
+
+    std::atomic<int> myStartupLatencyUs;
+    std::atomic<int> myNumEvents;
+    std::atomic<int> myNumLateEvents;
+    std::atomic<int> myMaxLatenessUs;
+    std::atomic<long long> myTotalLatenessUs;
 };
 
 #endif
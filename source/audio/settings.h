@@ -20,19 +20,13 @@
 
 #include <util/settingstree.h>
 
-/// Audio-related settings and their default values.
+/// Audio-related settings and their default values. The settings for the
+/// generated MIDI events are in midi/settings.h.
 namespace Settings
 {
     extern const Setting<int> MidiApi;
     extern const Setting<int> MidiPort;
-
-    extern const Setting<int> MidiVibratoLevel;
-    extern const Setting<int> MidiWideVibratoLevel;
-
-    extern const Setting<bool> MetronomeEnabled;
-    extern const Setting<int> MetronomePreset;
-    extern const Setting<int> MetronomeStrongAccent;
-    extern const Setting<int> MetronomeWeakAccent;
+    extern const Setting<bool> MidiRealtimePlayback;
 
     extern const Setting<bool> CountInEnabled;
     extern const Setting<int> CountInPreset;
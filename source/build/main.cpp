@@ -19,7 +19,6 @@
 #include <app/paths.h>
 #include <app/powertabeditor.h>
 #include <app/settings.h>
-#include <app/settingsmanager.h>
 #include <boost/program_options.hpp>
 #include <csignal>
 #include <dialogs/crashdialog.h>
@@ -30,6 +29,7 @@
 #include <QLocalServer>
 #include <QLocalSocket>
 #include <string>
+#include <util/settingsmanager.h>
 #include <withershins.hpp>
 
 #ifdef _WIN32
@@ -261,6 +261,7 @@ int main(int argc, char *argv[])
 
     // Launch the application.
     program.show();
+    program.recoverDocuments();
     program.openFiles(filesToOpen);
 
     return a.exec();
@@ -0,0 +1,182 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <exception>
+#include <formats/batchconverter.h>
+#include <iostream>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <string>
+#include <util/settingsmanager.h>
+#include <vector>
+
+typedef rapidjson::Writer<rapidjson::StringBuffer> JsonWriter;
+
+/// Writes a JSON object on a single line of the output.
+template <typename Func>
+static void writeRecord(const Func &func)
+{
+    rapidjson::StringBuffer buffer;
+    JsonWriter writer(buffer);
+
+    writer.StartObject();
+    func(writer);
+    writer.EndObject();
+
+    std::cout << buffer.GetString() << std::endl;
+}
+
+static void writeString(JsonWriter &writer, const char *key,
+                        const std::string &value)
+{
+    writer.Key(key);
+    writer.String(value.c_str(),
+                  static_cast<rapidjson::SizeType>(value.size()));
+}
+
+static void writeResult(JsonWriter &writer, const ConversionResult &result)
+{
+    writeString(writer, "type", "file");
+    writeString(writer, "input", result.job.inputFile);
+    writeString(writer, "output", result.job.outputFile);
+    writer.Key("success");
+    writer.Bool(result.success);
+    if (!result.success)
+        writeString(writer, "error", result.error);
+
+    writer.Key("bytes");
+    writer.Uint64(result.bytes);
+    writer.Key("seconds");
+    writer.Double(result.seconds);
+
+    writer.Key("timings");
+    writer.StartObject();
+    for (const PhaseTiming &timing : result.timings)
+    {
+        writer.Key(timing.name.c_str());
+        writer.Double(timing.seconds);
+    }
+    writer.EndObject();
+}
+
+int main(int argc, char *argv[])
+{
+    namespace po = boost::program_options;
+    po::options_description desc(
+        "Usage: ptconvert [options] inputs...\nConverts files, directories, or "
+        "wildcard patterns (e.g. \"songs/*.gp5\") to another format.\nOne "
+        "JSON object is written per line for each file, followed by a "
+        "summary.\n\nOptions");
+
+    std::string format;
+    std::string output_dir;
+    unsigned int num_threads = 0;
+    std::vector<std::string> inputs;
+
+    try
+    {
+        desc.add_options()
+            ("help,h", "Displays this help.")
+            ("format,f", po::value<std::string>(&format)->default_value("pt2"),
+             "The format to convert to (pt2 or mid).")
+            ("output-dir,o", po::value<std::string>(&output_dir),
+             "The directory to write the converted files to. By default, "
+             "each file is written alongside the original.")
+            ("jobs,j", po::value<unsigned int>(&num_threads),
+             "The number of files to convert in parallel. Defaults to the "
+             "number of cores.")
+            ("inputs", po::value<std::vector<std::string>>(&inputs),
+             "The files to convert.");
+        po::positional_options_description p;
+        p.add("inputs", -1);
+        po::variables_map vm;
+        po::store(po::command_line_parser(argc, argv)
+                      .options(desc)
+                      .positional(p)
+                      .run(),
+                  vm);
+        po::notify(vm);
+
+        if (vm.count("help") || inputs.empty())
+        {
+            std::cout << desc << std::endl;
+            return vm.count("help") ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << desc << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    size_t num_files = 0;
+    size_t num_failures = 0;
+    uintmax_t total_bytes = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+
+    try
+    {
+        // The default settings are used, e.g. for the MIDI export options.
+        SettingsManager settings_manager;
+        BatchConverter converter(settings_manager, format);
+
+        std::vector<ConversionJob> jobs =
+            converter.findJobs(inputs, output_dir);
+
+        converter.convert(jobs, num_threads,
+                          [&](const ConversionResult &result) {
+            ++num_files;
+            total_bytes += result.bytes;
+            if (!result.success)
+                ++num_failures;
+
+            writeRecord([&](JsonWriter &writer) {
+                writeResult(writer, result);
+            });
+        });
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    const double seconds = std::chrono::duration<double>(end - start).count();
+
+    writeRecord([&](JsonWriter &writer) {
+        writeString(writer, "type", "summary");
+        writer.Key("files");
+        writer.Uint64(num_files);
+        writer.Key("failures");
+        writer.Uint64(num_failures);
+        writer.Key("bytes");
+        writer.Uint64(total_bytes);
+        writer.Key("seconds");
+        writer.Double(seconds);
+        writer.Key("files_per_second");
+        writer.Double(seconds > 0 ? num_files / seconds : 0);
+        writer.Key("megabytes_per_second");
+        writer.Double(seconds > 0 ? total_bytes / (1024.0 * 1024.0) / seconds
+                                  : 0);
+    });
+
+    return num_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,62 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "libraryupdater.h"
+
+LibraryUpdater::LibraryUpdater(const SettingsManager &settings_manager,
+                               const ScoreLibrary &library)
+    : mySettingsManager(settings_manager),
+      myLibrary(library),
+      myCancelled(false),
+      mySucceeded(false)
+{
+}
+
+LibraryUpdater::~LibraryUpdater()
+{
+    cancel();
+    wait();
+}
+
+void LibraryUpdater::cancel()
+{
+    myCancelled = true;
+}
+
+void LibraryUpdater::run()
+{
+    try
+    {
+        myResult = myLibrary.update(mySettingsManager, this);
+        mySucceeded = !myResult.cancelled;
+    }
+    catch (const std::exception &e)
+    {
+        myErrorMessage = e.what();
+    }
+}
+
+void LibraryUpdater::filesChecked(size_t numChecked, size_t numFiles)
+{
+    emit progressChanged(static_cast<int>(numChecked),
+                         static_cast<int>(numFiles));
+}
+
+bool LibraryUpdater::isCancelled() const
+{
+    return myCancelled;
+}
@@ -0,0 +1,77 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DIALOGS_LIBRARYUPDATER_H
+#define DIALOGS_LIBRARYUPDATER_H
+
+#include <atomic>
+#include <formats/scorelibrary.h>
+#include <QThread>
+#include <string>
+
+class SettingsManager;
+
+/// Updates a copy of a score library on a background thread, so that the
+/// original can still be searched until the update has finished.
+class LibraryUpdater : public QThread, private LibraryUpdateListener
+{
+    Q_OBJECT
+
+public:
+    LibraryUpdater(const SettingsManager &settings_manager,
+                   const ScoreLibrary &library);
+    /// Cancels the update if it is still running.
+    ~LibraryUpdater();
+
+    /// Asks the update to stop as soon as possible.
+    void cancel();
+    bool wasCancelled() const { return myCancelled; }
+
+    /// Returns whether the update succeeded. This is only valid after the
+    /// thread has finished.
+    bool succeeded() const { return mySucceeded; }
+    /// Returns the reason that the update failed.
+    const std::string &getErrorMessage() const { return myErrorMessage; }
+
+    /// Returns a summary of the changes. This is only valid after the thread
+    /// has finished successfully.
+    const LibraryUpdateResult &getResult() const { return myResult; }
+    /// Returns the updated library. This is only valid after the thread has
+    /// finished successfully.
+    ScoreLibrary &getLibrary() { return myLibrary; }
+
+signals:
+    /// Emitted from the update threads after each file has been checked.
+    void progressChanged(int numChecked, int numFiles);
+
+private:
+    virtual void run() override;
+
+    virtual void filesChecked(size_t numChecked, size_t numFiles) override;
+    virtual bool isCancelled() const override;
+
+    const SettingsManager &mySettingsManager;
+    /// The library being updated, which is only accessed by the update thread
+    /// until it has finished.
+    ScoreLibrary myLibrary;
+    std::atomic<bool> myCancelled;
+    bool mySucceeded;
+    std::string myErrorMessage;
+    LibraryUpdateResult myResult;
+};
+
+#endif
@@ -19,12 +19,14 @@
 #include "ui_preferencesdialog.h"
 
 #include <app/settings.h>
-#include <app/settingsmanager.h>
 #include <audio/midioutputdevice.h>
 #include <audio/settings.h>
 #include <boost/lexical_cast.hpp>
 #include <dialogs/tuningdialog.h>
+#include <formats/settings.h>
+#include <midi/settings.h>
 #include <score/generalmidi.h>
+#include <util/settingsmanager.h>
 
 typedef std::pair<int, int> MidiApiAndPort;
 Q_DECLARE_METATYPE(MidiApiAndPort)
@@ -70,6 +72,8 @@ PreferencesDialog::PreferencesDialog(QWidget *parent,
 
     ui->countInVolumeSpinBox->setRange(0, 127);
 
+    ui->compressionLevelSpinBox->setRange(0, 9);
+
     loadCurrentSettings();
 }
 
@@ -122,6 +126,12 @@ void PreferencesDialog::loadCurrentSettings()
     ui->openInNewWindowCheckBox->setChecked(
         settings->get(Settings::OpenFilesInNewWindow));
 
+    ui->saveAsBinaryCheckBox->setChecked(
+        settings->get(Settings::SavePowerTabAsBinary));
+
+    ui->compressionLevelSpinBox->setValue(
+        settings->get(Settings::PowerTabCompressionLevel));
+
     ui->defaultInstrumentNameLineEdit->setText(
         QString::fromStdString(settings->get(Settings::DefaultInstrumentName)));
     ui->defaultPresetComboBox->setCurrentIndex(
@@ -173,6 +183,12 @@ void PreferencesDialog::accept()
     settings->set(Settings::OpenFilesInNewWindow,
                   ui->openInNewWindowCheckBox->isChecked());
 
+    settings->set(Settings::SavePowerTabAsBinary,
+                  ui->saveAsBinaryCheckBox->isChecked());
+
+    settings->set(Settings::PowerTabCompressionLevel,
+                  ui->compressionLevelSpinBox->value());
+
     settings->set(Settings::DefaultInstrumentName,
                   ui->defaultInstrumentNameLineEdit->text().toStdString());
 
@@ -0,0 +1,407 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "scorelibrarydialog.h"
+
+#include <algorithm>
+#include <boost/lexical_cast.hpp>
+#include <formats/scorelibrary.h>
+#include "libraryupdater.h"
+#include <map>
+#include <QComboBox>
+#include <QDialogButtonBox>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QMessageBox>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+static QString getTimeSignatureText(const TimeSignature &time)
+{
+    return QString("%1/%2").arg(time.getBeatsPerMeasure())
+                           .arg(time.getBeatValue());
+}
+
+/// Replaces the items in a filter's combo box, keeping the current choice if
+/// it is still available.
+static void setFilterItems(QComboBox *combo, const QStringList &items)
+{
+    const QString current = combo->currentText();
+
+    combo->blockSignals(true);
+    combo->clear();
+    combo->addItem(QObject::tr("Any"));
+    combo->addItems(items);
+    combo->setCurrentIndex(std::max(0, combo->findText(current)));
+    combo->blockSignals(false);
+}
+
+ScoreLibraryDialog::ScoreLibraryDialog(QWidget *parent, ScoreLibrary &library,
+                                       const SettingsManager &settings_manager)
+    : QDialog(parent),
+      myLibrary(library),
+      mySettingsManager(settings_manager)
+{
+    setWindowTitle(tr("Score Library"));
+    setModal(true);
+    resize(700, 600);
+
+    auto mainLayout = new QVBoxLayout(this);
+
+    // The directories that are indexed.
+    auto directoryLayout = new QHBoxLayout();
+    myDirectoryList = new QListWidget(this);
+    myDirectoryList->setMaximumHeight(80);
+    directoryLayout->addWidget(myDirectoryList);
+
+    auto directoryButtons = new QVBoxLayout();
+    myAddButton = new QPushButton(tr("Add Folder..."), this);
+    connect(myAddButton, SIGNAL(clicked()), this, SLOT(addDirectory()));
+    directoryButtons->addWidget(myAddButton);
+
+    myRemoveButton = new QPushButton(tr("Remove Folder"), this);
+    connect(myRemoveButton, SIGNAL(clicked()), this, SLOT(removeDirectory()));
+    directoryButtons->addWidget(myRemoveButton);
+
+    myRescanButton = new QPushButton(tr("Rescan"), this);
+    connect(myRescanButton, SIGNAL(clicked()), this, SLOT(rescan()));
+    directoryButtons->addWidget(myRescanButton);
+    directoryButtons->addStretch();
+    directoryLayout->addLayout(directoryButtons);
+    mainLayout->addLayout(directoryLayout);
+
+    // The search criteria.
+    auto searchLayout = new QFormLayout();
+    myTextEdit = new QLineEdit(this);
+    myTextEdit->setPlaceholderText(tr("Title, artist, filename, etc"));
+    connect(myTextEdit, SIGNAL(textChanged(QString)), this, SLOT(search()));
+    searchLayout->addRow(tr("Search:"), myTextEdit);
+
+    myTuningComboBox = new QComboBox(this);
+    connect(myTuningComboBox, SIGNAL(currentIndexChanged(int)), this,
+            SLOT(search()));
+    searchLayout->addRow(tr("Tuning:"), myTuningComboBox);
+
+    // A tempo of zero means that there is no limit.
+    auto tempoLayout = new QHBoxLayout();
+    myMinTempoSpinBox = new QSpinBox(this);
+    myMaxTempoSpinBox = new QSpinBox(this);
+    for (QSpinBox *spinBox : { myMinTempoSpinBox, myMaxTempoSpinBox })
+    {
+        spinBox->setRange(0, 1000);
+        spinBox->setSpecialValueText(tr("Any"));
+        spinBox->setSuffix(tr(" bpm"));
+        connect(spinBox, SIGNAL(valueChanged(int)), this, SLOT(search()));
+    }
+    tempoLayout->addWidget(myMinTempoSpinBox);
+    tempoLayout->addWidget(new QLabel(tr("to"), this));
+    tempoLayout->addWidget(myMaxTempoSpinBox);
+    tempoLayout->addStretch();
+    searchLayout->addRow(tr("Tempo:"), tempoLayout);
+
+    myKeyComboBox = new QComboBox(this);
+    connect(myKeyComboBox, SIGNAL(currentIndexChanged(int)), this,
+            SLOT(search()));
+    searchLayout->addRow(tr("Key Signature:"), myKeyComboBox);
+
+    myTimeSignatureComboBox = new QComboBox(this);
+    connect(myTimeSignatureComboBox, SIGNAL(currentIndexChanged(int)), this,
+            SLOT(search()));
+    searchLayout->addRow(tr("Time Signature:"), myTimeSignatureComboBox);
+    mainLayout->addLayout(searchLayout);
+
+    // The matching files.
+    myResultsList = new QTreeWidget(this);
+    myResultsList->setHeaderLabels({ tr("Title"), tr("Artist"), tr("File") });
+    myResultsList->setRootIsDecorated(false);
+    myResultsList->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    myResultsList->header()->setSectionResizeMode(QHeaderView::Stretch);
+    connect(myResultsList, SIGNAL(itemDoubleClicked(QTreeWidgetItem *, int)),
+            this, SLOT(accept()));
+    mainLayout->addWidget(myResultsList);
+
+    auto statusLayout = new QHBoxLayout();
+    myStatusLabel = new QLabel(this);
+    statusLayout->addWidget(myStatusLabel, 1);
+
+    myProgressBar = new QProgressBar(this);
+    myProgressBar->hide();
+    statusLayout->addWidget(myProgressBar);
+
+    myCancelButton = new QPushButton(tr("Cancel"), this);
+    myCancelButton->hide();
+    connect(myCancelButton, SIGNAL(clicked()), this, SLOT(cancelRescan()));
+    statusLayout->addWidget(myCancelButton);
+    mainLayout->addLayout(statusLayout);
+
+    auto buttonBox =
+        new QDialogButtonBox(QDialogButtonBox::Open | QDialogButtonBox::Close);
+    QPushButton *openButton = buttonBox->button(QDialogButtonBox::Open);
+    openButton->setEnabled(false);
+    connect(myResultsList, &QTreeWidget::itemSelectionChanged, [=]() {
+        openButton->setEnabled(!myResultsList->selectedItems().isEmpty());
+    });
+    connect(buttonBox, SIGNAL(accepted()), this, SLOT(accept()));
+    connect(buttonBox, SIGNAL(rejected()), this, SLOT(reject()));
+    mainLayout->addWidget(buttonBox);
+
+    setLayout(mainLayout);
+
+    updateFilters();
+    search();
+}
+
+ScoreLibraryDialog::~ScoreLibraryDialog()
+{
+}
+
+QStringList ScoreLibraryDialog::getSelectedFiles() const
+{
+    QStringList files;
+    for (const QTreeWidgetItem *item : myResultsList->selectedItems())
+        files.append(item->data(0, Qt::UserRole).toString());
+
+    return files;
+}
+
+void ScoreLibraryDialog::addDirectory()
+{
+    const QString dir = QFileDialog::getExistingDirectory(this,
+                                                          tr("Add Folder"));
+    if (dir.isEmpty())
+        return;
+
+    myLibrary.addDirectory(dir.toStdString());
+    rescan();
+}
+
+void ScoreLibraryDialog::removeDirectory()
+{
+    QListWidgetItem *item = myDirectoryList->currentItem();
+    if (!item)
+        return;
+
+    myLibrary.removeDirectory(item->text().toStdString());
+    updateFilters();
+    search();
+}
+
+void ScoreLibraryDialog::rescan()
+{
+    if (myUpdater)
+        return;
+
+    myUpdater.reset(new LibraryUpdater(mySettingsManager, myLibrary));
+    connect(myUpdater.get(), &LibraryUpdater::progressChanged, this,
+            &ScoreLibraryDialog::updateProgress);
+    connect(myUpdater.get(), &QThread::finished, this,
+            &ScoreLibraryDialog::finishRescan);
+
+    setScanning(true);
+    myUpdater->start();
+}
+
+void ScoreLibraryDialog::cancelRescan()
+{
+    if (myUpdater)
+        myUpdater->cancel();
+}
+
+void ScoreLibraryDialog::updateProgress(int numChecked, int numFiles)
+{
+    // The signals may arrive out of order, since the files are checked in
+    // parallel.
+    myProgressBar->setMaximum(numFiles);
+    myProgressBar->setValue(std::max(myProgressBar->value(), numChecked));
+}
+
+void ScoreLibraryDialog::finishRescan()
+{
+    if (!myUpdater)
+        return;
+
+    myUpdater->wait();
+    std::unique_ptr<LibraryUpdater> updater(std::move(myUpdater));
+    setScanning(false);
+
+    if (updater->wasCancelled())
+        return;
+
+    if (!updater->succeeded())
+    {
+        QMessageBox::warning(
+            this, tr("Score Library"),
+            tr("Error scanning folders: %1")
+                .arg(QString::fromStdString(updater->getErrorMessage())));
+        return;
+    }
+
+    myLibrary = std::move(updater->getLibrary());
+    updateFilters();
+    search();
+
+    const LibraryUpdateResult &result = updater->getResult();
+    if (!result.errors.empty())
+    {
+        QString details;
+        for (const std::pair<std::string, std::string> &error : result.errors)
+        {
+            details += QString::fromStdString(error.first) + ": " +
+                       QString::fromStdString(error.second) + "\n";
+        }
+
+        QMessageBox msgBox(this);
+        msgBox.setIcon(QMessageBox::Warning);
+        msgBox.setWindowTitle(tr("Score Library"));
+        msgBox.setText(tr("%n file(s) could not be read.", "",
+                          static_cast<int>(result.errors.size())));
+        msgBox.setDetailedText(details);
+        msgBox.exec();
+    }
+}
+
+void ScoreLibraryDialog::search()
+{
+    LibraryQuery query;
+    query.text = myTextEdit->text().toStdString();
+
+    if (myTuningComboBox->currentIndex() > 0)
+        query.tuning = myTunings.at(myTuningComboBox->currentIndex() - 1);
+    if (myMinTempoSpinBox->value() > 0)
+        query.minTempo = myMinTempoSpinBox->value();
+    if (myMaxTempoSpinBox->value() > 0)
+        query.maxTempo = myMaxTempoSpinBox->value();
+    if (myKeyComboBox->currentIndex() > 0)
+    {
+        query.keySignature =
+            myKeySignatures.at(myKeyComboBox->currentIndex() - 1);
+    }
+    if (myTimeSignatureComboBox->currentIndex() > 0)
+    {
+        query.timeSignature =
+            myTimeSignatures.at(myTimeSignatureComboBox->currentIndex() - 1);
+    }
+
+    myResultsList->clear();
+
+    QList<QTreeWidgetItem *> items;
+    for (const LibraryEntry *entry : myLibrary.search(query))
+    {
+        const ScoreInfo &info = entry->scoreInfo;
+        QString title, artist;
+        if (info.getScoreType() == ScoreInfo::ScoreType::Song)
+        {
+            title = QString::fromStdString(info.getSongData().getTitle());
+            artist = QString::fromStdString(info.getSongData().getArtist());
+        }
+        else
+            title = QString::fromStdString(info.getLessonData().getTitle());
+
+        const QString path = QString::fromStdString(entry->path);
+        auto item = new QTreeWidgetItem(
+            { title, artist, QFileInfo(path).fileName() });
+        item->setData(0, Qt::UserRole, path);
+        item->setToolTip(2, path);
+        items.append(item);
+    }
+
+    myResultsList->addTopLevelItems(items);
+    myStatusLabel->setText(tr("%1 of %2 files")
+                               .arg(items.size())
+                               .arg(static_cast<int>(
+                                   myLibrary.getEntries().size())));
+}
+
+void ScoreLibraryDialog::updateFilters()
+{
+    myDirectoryList->clear();
+    for (const std::string &dir : myLibrary.getDirectories())
+        myDirectoryList->addItem(QString::fromStdString(dir));
+
+    // Find the distinct values in the library, which are sorted by the text
+    // that is displayed (or by the meter, for time signatures).
+    std::map<std::string, Tuning> tunings;
+    std::map<std::string, KeySignature> keys;
+    std::map<std::pair<int, int>, TimeSignature> time_signatures;
+
+    for (const LibraryEntry &entry : myLibrary.getEntries())
+    {
+        for (const Tuning &tuning : entry.tunings)
+        {
+            tunings.insert(
+                { boost::lexical_cast<std::string>(tuning), tuning });
+        }
+
+        for (const KeySignature &key : entry.keySignatures)
+            keys.insert({ boost::lexical_cast<std::string>(key), key });
+
+        for (const TimeSignature &time : entry.timeSignatures)
+        {
+            time_signatures.insert(
+                { { time.getBeatValue(), time.getBeatsPerMeasure() }, time });
+        }
+    }
+
+    QStringList items;
+    myTunings.clear();
+    for (const std::pair<const std::string, Tuning> &tuning : tunings)
+    {
+        items.append(QString::fromStdString(tuning.first));
+        myTunings.push_back(tuning.second);
+    }
+    setFilterItems(myTuningComboBox, items);
+
+    items.clear();
+    myKeySignatures.clear();
+    for (const std::pair<const std::string, KeySignature> &key : keys)
+    {
+        items.append(QString::fromStdString(key.first));
+        myKeySignatures.push_back(key.second);
+    }
+    setFilterItems(myKeyComboBox, items);
+
+    items.clear();
+    myTimeSignatures.clear();
+    for (const std::pair<const std::pair<int, int>, TimeSignature> &time :
+         time_signatures)
+    {
+        items.append(getTimeSignatureText(time.second));
+        myTimeSignatures.push_back(time.second);
+    }
+    setFilterItems(myTimeSignatureComboBox, items);
+}
+
+void ScoreLibraryDialog::setScanning(bool scanning)
+{
+    myAddButton->setEnabled(!scanning);
+    myRemoveButton->setEnabled(!scanning);
+    myRescanButton->setEnabled(!scanning);
+
+    // The progress is unknown until the directories have been searched.
+    myProgressBar->setRange(0, 0);
+    myProgressBar->setVisible(scanning);
+    myCancelButton->setVisible(scanning);
+}
@@ -0,0 +1,102 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DIALOGS_SCORELIBRARYDIALOG_H
+#define DIALOGS_SCORELIBRARYDIALOG_H
+
+#include <memory>
+#include <QDialog>
+#include <score/keysignature.h>
+#include <score/timesignature.h>
+#include <score/tuning.h>
+#include <vector>
+
+class LibraryUpdater;
+class QComboBox;
+class QLabel;
+class QLineEdit;
+class QListWidget;
+class QProgressBar;
+class QPushButton;
+class QSpinBox;
+class QTreeWidget;
+class ScoreLibrary;
+class SettingsManager;
+
+/// Allows the user to choose the directories in the score library, and to
+/// search the library for files to open. The library is rescanned on a
+/// background thread, and closing the dialog cancels a rescan that is still
+/// running.
+class ScoreLibraryDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    ScoreLibraryDialog(QWidget *parent, ScoreLibrary &library,
+                       const SettingsManager &settings_manager);
+    ~ScoreLibraryDialog();
+
+    /// Returns the files that were selected to be opened.
+    QStringList getSelectedFiles() const;
+
+private slots:
+    void addDirectory();
+    void removeDirectory();
+    /// Starts updating the index in the background.
+    void rescan();
+    void cancelRescan();
+    void updateProgress(int numChecked, int numFiles);
+    /// Replaces the index with the updated copy, and reports any files that
+    /// couldn't be read.
+    void finishRescan();
+    /// Displays the files that match the current search criteria.
+    void search();
+
+private:
+    /// Fills in the directory list and the choices for each search filter
+    /// from the contents of the library.
+    void updateFilters();
+    /// Shows the progress of a rescan, and disables the buttons that would
+    /// change the directories while it is running.
+    void setScanning(bool scanning);
+
+    ScoreLibrary &myLibrary;
+    const SettingsManager &mySettingsManager;
+    std::unique_ptr<LibraryUpdater> myUpdater;
+
+    QListWidget *myDirectoryList;
+    QPushButton *myAddButton;
+    QPushButton *myRemoveButton;
+    QPushButton *myRescanButton;
+    QLineEdit *myTextEdit;
+    QComboBox *myTuningComboBox;
+    QSpinBox *myMinTempoSpinBox;
+    QSpinBox *myMaxTempoSpinBox;
+    QComboBox *myKeyComboBox;
+    QComboBox *myTimeSignatureComboBox;
+    QTreeWidget *myResultsList;
+    QLabel *myStatusLabel;
+    QProgressBar *myProgressBar;
+    QPushButton *myCancelButton;
+
+    /// The choices for each filter, after the "Any" item.
+    std::vector<Tuning> myTunings;
+    std::vector<KeySignature> myKeySignatures;
+    std::vector<TimeSignature> myTimeSignatures;
+};
+
+#endif
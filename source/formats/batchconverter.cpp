@@ -0,0 +1,350 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "batchconverter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <exception>
+#include <formats/fileformatmanager.h>
+#include <future>
+#include <mutex>
+#include <score/score.h>
+#include <set>
+#include <thread>
+#include <util/parallel.h>
+
+namespace fs = boost::filesystem;
+
+static std::string getExtension(const fs::path &path)
+{
+    std::string extension = path.extension().string();
+    if (!extension.empty())
+        extension.erase(0, 1); // Remove the leading '.'
+
+    return boost::algorithm::to_lower_copy(extension);
+}
+
+static bool isPattern(const std::string &filename)
+{
+    return filename.find_first_of("*?") != std::string::npos;
+}
+
+/// Matches a filename against a pattern containing the '*' and '?' wildcards.
+static bool matchesPattern(const std::string &pattern,
+                           const std::string &filename)
+{
+    size_t p = 0, f = 0;
+    size_t star = std::string::npos, star_match = 0;
+
+    while (f < filename.size())
+    {
+        if (p < pattern.size() &&
+            (pattern[p] == '?' || pattern[p] == filename[f]))
+        {
+            ++p;
+            ++f;
+        }
+        else if (p < pattern.size() && pattern[p] == '*')
+        {
+            star = p++;
+            star_match = f;
+        }
+        else if (star != std::string::npos)
+        {
+            // Let the last '*' match one more character and try again.
+            p = star + 1;
+            f = ++star_match;
+        }
+        else
+            return false;
+    }
+
+    while (p < pattern.size() && pattern[p] == '*')
+        ++p;
+
+    return p == pattern.size();
+}
+
+/// Returns the path of a file relative to a directory that contains it.
+static fs::path getRelativePath(const fs::path &dir, const fs::path &path)
+{
+    auto it = path.begin();
+    for (auto dir_it = dir.begin(); dir_it != dir.end() && it != path.end();
+         ++dir_it, ++it)
+    {
+    }
+
+    fs::path relative;
+    for (; it != path.end(); ++it)
+        relative /= *it;
+
+    return relative;
+}
+
+static FileFormat findOutputFormat(const SettingsManager &settings_manager,
+                                   const std::string &extension)
+{
+    FileFormatManager manager(settings_manager);
+    boost::optional<FileFormat> format =
+        manager.findExportFormat(boost::algorithm::to_lower_copy(extension));
+    if (!format)
+        throw std::runtime_error("Unsupported output format: " + extension);
+
+    return *format;
+}
+
+BatchConverter::BatchConverter(const SettingsManager &settings_manager,
+                               const std::string &output_extension)
+    : mySettingsManager(settings_manager),
+      myOutputExtension(boost::algorithm::to_lower_copy(output_extension)),
+      myOutputFormat(findOutputFormat(settings_manager, output_extension))
+{
+}
+
+std::vector<ConversionJob> BatchConverter::findJobs(
+    const std::vector<std::string> &inputs,
+    const std::string &output_dir) const
+{
+    FileFormatManager manager(mySettingsManager);
+
+    // The files to convert, and their paths relative to the output directory.
+    std::vector<std::pair<fs::path, fs::path>> files_found;
+    std::set<fs::path> input_files;
+
+    auto addFile = [&](const fs::path &path, const fs::path &relative_path) {
+        // Skip files that were matched by more than one input.
+        if (input_files.insert(path).second)
+            files_found.emplace_back(path, relative_path);
+    };
+
+    auto isSupported = [&](const fs::path &path) {
+        return fs::is_regular_file(path) &&
+               manager.findFormat(getExtension(path));
+    };
+
+    for (const std::string &input : inputs)
+    {
+        const fs::path input_path(input);
+        std::vector<fs::path> files;
+
+        if (isPattern(input_path.filename().string()))
+        {
+            fs::path dir = input_path.parent_path();
+            if (dir.empty())
+                dir = ".";
+
+            const std::string pattern = input_path.filename().string();
+            for (fs::directory_iterator it(dir), end; it != end; ++it)
+            {
+                const fs::path &path = it->path();
+                if (matchesPattern(pattern, path.filename().string()) &&
+                    isSupported(path))
+                {
+                    files.push_back(path);
+                }
+            }
+
+            std::sort(files.begin(), files.end());
+            for (const fs::path &path : files)
+                addFile(path, path.filename());
+        }
+        else if (fs::is_directory(input_path))
+        {
+            for (fs::recursive_directory_iterator it(input_path), end;
+                 it != end; ++it)
+            {
+                if (isSupported(it->path()))
+                    files.push_back(it->path());
+            }
+
+            std::sort(files.begin(), files.end());
+            for (const fs::path &path : files)
+                addFile(path, getRelativePath(input_path, path));
+        }
+        else
+        {
+            // Files that were explicitly requested are always included, so
+            // that any problems with them are reported.
+            addFile(input_path, input_path.filename());
+        }
+    }
+
+    // If several files have the same name (e.g. "song.gp5" and "song.ptb"),
+    // keep the original extension so that they don't overwrite each other or
+    // any of the input files.
+    std::set<fs::path> output_files = input_files;
+    std::vector<ConversionJob> jobs;
+
+    for (const std::pair<fs::path, fs::path> &file : files_found)
+    {
+        const fs::path output_path =
+            output_dir.empty() ? file.first : fs::path(output_dir) / file.second;
+
+        fs::path unique_path = output_path;
+        unique_path.replace_extension(myOutputExtension);
+        if (output_files.count(unique_path))
+        {
+            unique_path = output_path;
+            unique_path += "." + myOutputExtension;
+        }
+        output_files.insert(unique_path);
+
+        ConversionJob job;
+        job.inputFile = file.first.string();
+        job.outputFile = unique_path.string();
+        jobs.push_back(job);
+    }
+
+    return jobs;
+}
+
+static ConversionResult convertFile(FileFormatManager &manager,
+                                    const ConversionJob &job,
+                                    const FileFormat &output_format)
+{
+    ConversionResult result(job);
+    auto start = std::chrono::high_resolution_clock::now();
+
+    try
+    {
+        const fs::path input_path(job.inputFile);
+        const fs::path output_path(job.outputFile);
+
+        if (fs::absolute(input_path) == fs::absolute(output_path))
+        {
+            throw FileFormatException(
+                "The output file would replace the input file");
+        }
+
+        boost::optional<FileFormat> format =
+            manager.findFormat(getExtension(input_path));
+        if (!format)
+            throw FileFormatException("Unsupported file type");
+
+        result.bytes = fs::file_size(input_path);
+
+        Score score;
+        result.timings.push_back(timePhase("Import", [&]() {
+            manager.importFile(score, job.inputFile, *format);
+        }));
+
+        if (output_path.has_parent_path())
+            fs::create_directories(output_path.parent_path());
+
+        result.timings.push_back(timePhase("Export", [&]() {
+            manager.exportFile(score, job.outputFile, output_format);
+        }));
+
+        result.success = true;
+    }
+    catch (const std::exception &e)
+    {
+        result.error = e.what();
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    return result;
+}
+
+void BatchConverter::convert(const std::vector<ConversionJob> &jobs,
+                             unsigned int num_threads,
+                             const ResultCallback &callback) const
+{
+    if (jobs.empty())
+        return;
+
+    if (num_threads == 0)
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    num_threads = static_cast<unsigned int>(
+        std::min<size_t>(num_threads, jobs.size()));
+
+    // Start with the largest files, so that a large file isn't left until the
+    // end while the other threads are idle.
+    std::vector<std::pair<uintmax_t, size_t>> order;
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        boost::system::error_code error;
+        uintmax_t size = fs::file_size(jobs[i].inputFile, error);
+        order.emplace_back(error ? 0 : size, i);
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [](const std::pair<uintmax_t, size_t> &a,
+                        const std::pair<uintmax_t, size_t> &b) {
+                         return a.first > b.first;
+                     });
+
+    std::atomic<size_t> next_job(0);
+    std::atomic<bool> cancelled(false);
+    std::mutex callback_mutex;
+
+    auto worker = [&]() {
+        // Each file already has a thread to itself when converting several
+        // files at once, so don't start more threads for each file.
+        Util::SerialScope serial(num_threads > 1);
+
+        // The importers are not thread-safe, so each thread has its own.
+        FileFormatManager manager(mySettingsManager);
+
+        while (!cancelled)
+        {
+            const size_t i = next_job++;
+            if (i >= order.size())
+                return;
+
+            ConversionResult result =
+                convertFile(manager, jobs[order[i].second], myOutputFormat);
+
+            std::lock_guard<std::mutex> lock(callback_mutex);
+            try
+            {
+                callback(result);
+            }
+            catch (...)
+            {
+                cancelled = true;
+                throw;
+            }
+        }
+    };
+
+    std::vector<std::future<void>> tasks;
+    for (unsigned int i = 1; i < num_threads; ++i)
+        tasks.push_back(std::async(std::launch::async, worker));
+
+    std::exception_ptr error;
+    try
+    {
+        worker();
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+
+    // Wait for all of the threads to finish before rethrowing any errors.
+    for (std::future<void> &task : tasks)
+        task.wait();
+    if (error)
+        std::rethrow_exception(error);
+    for (std::future<void> &task : tasks)
+        task.get();
+}
@@ -0,0 +1,94 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FORMATS_BATCHCONVERTER_H
+#define FORMATS_BATCHCONVERTER_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "fileformat.h"
+
+class SettingsManager;
+
+/// A file to be converted, and the path to write the result to.
+struct ConversionJob
+{
+    std::string inputFile;
+    std::string outputFile;
+};
+
+/// The outcome of converting a single file.
+struct ConversionResult
+{
+    explicit ConversionResult(const ConversionJob &job)
+        : job(job), success(false), bytes(0), seconds(0)
+    {
+    }
+
+    ConversionJob job;
+    bool success;
+    /// The reason for the failure, if the conversion was unsuccessful.
+    std::string error;
+    /// The size of the input file.
+    uintmax_t bytes;
+    /// The total time taken to convert the file.
+    double seconds;
+    /// The time taken to import and export the file.
+    std::vector<PhaseTiming> timings;
+};
+
+/// Converts many files to a single output format, without requiring the GUI.
+class BatchConverter
+{
+public:
+    typedef std::function<void(const ConversionResult &)> ResultCallback;
+
+    /// @param output_extension The extension of the format to export to,
+    /// e.g. "pt2" or "mid".
+    /// @throw std::runtime_error if no exporter supports the extension.
+    BatchConverter(const SettingsManager &settings_manager,
+                   const std::string &output_extension);
+
+    /// Expands the given files, directories (recursively), and wildcard
+    /// patterns (e.g. "songs/*.gp5") into the list of files that can be
+    /// imported.
+    /// If an output directory is given, the converted files are placed there
+    /// (preserving the layout of any directories that were searched).
+    /// Otherwise, each file is converted alongside the original.
+    std::vector<ConversionJob> findJobs(const std::vector<std::string> &inputs,
+                                        const std::string &output_dir) const;
+
+    /// Converts the files using the given number of threads (or one per core
+    /// if zero). Each thread takes the next unconverted file once it is
+    /// finished with its current one, so at most one score per thread is in
+    /// memory at a time. When there are several threads, each file is
+    /// imported and exported serially on its thread.
+    /// The callback is invoked once for each file as soon as it has been
+    /// converted, and is never called concurrently.
+    void convert(const std::vector<ConversionJob> &jobs,
+                 unsigned int num_threads,
+                 const ResultCallback &callback) const;
+
+private:
+    const SettingsManager &mySettingsManager;
+    const std::string myOutputExtension;
+    const FileFormat myOutputFormat;
+};
+
+#endif
@@ -18,6 +18,7 @@
 #include "fileformat.h"
 
 #include <algorithm>
+#include <chrono>
 
 FileFormat::FileFormat(const std::string &name,
                        const std::vector<std::string> &fileExtensions)
@@ -32,6 +33,11 @@ bool FileFormat::operator==(const FileFormat &format) const
            myFileExtensions == format.myFileExtensions;
 }
 
+const std::string &FileFormat::name() const
+{
+    return myName;
+}
+
 std::string FileFormat::fileFilter() const
 {
     return myName + " (" + allExtensions() + ")";
@@ -57,8 +63,22 @@ bool FileFormat::contains(const std::string &extension) const
                      extension) != myFileExtensions.end();
 }
 
+PhaseTiming timePhase(const char *name, const std::function<void()> &phase)
+{
+    typedef std::chrono::high_resolution_clock Clock;
+    const auto start = Clock::now();
+    phase();
+    return { name, std::chrono::duration<double>(Clock::now() - start).count(),
+             0 };
+}
+
+ImportListener::~ImportListener()
+{
+}
+
 FileFormatImporter::FileFormatImporter(const FileFormat &format) :
-    myFormat(format)
+    myFormat(format),
+    myListener(nullptr)
 {
 }
 
@@ -66,16 +86,54 @@ FileFormatImporter::~FileFormatImporter()
 {
 }
 
+bool FileFormatImporter::readScoreInfo(const uint8_t *, size_t,
+                                       ScoreInfo &) const
+{
+    return false;
+}
+
 FileFormat FileFormatImporter::fileFormat() const
 {
     return myFormat;
 }
 
+const std::vector<PhaseTiming> &FileFormatImporter::getTimings() const
+{
+    return myTimings;
+}
+
+void FileFormatImporter::setListener(ImportListener *listener)
+{
+    myListener = listener;
+}
+
+bool FileFormatImporter::hasListener() const
+{
+    return myListener != nullptr;
+}
+
+void FileFormatImporter::publishSystem(const Score &score, int index) const
+{
+    if (myListener)
+        myListener->systemImported(score, index);
+}
+
+void FileFormatImporter::checkCancelled() const
+{
+    if (myListener && myListener->isCancelled())
+        throw ImportCancelledException();
+}
+
 FileFormatException::FileFormatException(const std::string& error)
     : std::runtime_error(error)
 {
 }
 
+ImportCancelledException::ImportCancelledException()
+    : FileFormatException("The import was cancelled")
+{
+}
+
 
 FileFormatExporter::FileFormatExporter(const FileFormat &format)
     : myFormat(format)
@@ -18,11 +18,15 @@
 #ifndef FORMATS_FILEFORMAT_H
 #define FORMATS_FILEFORMAT_H
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
 class Score;
+class ScoreInfo;
 
 class FileFormat
 {
@@ -32,6 +36,8 @@ public:
 
     bool operator==(const FileFormat &format) const;
 
+    const std::string &name() const;
+
     /// Returns a correctly formatted file filter for a Qt file dialog.
     /// e.g. "FileType (*.ext1 *.ext2)".
     std::string fileFilter() const;
@@ -47,6 +53,37 @@ private:
     std::vector<std::string> myFileExtensions;
 };
 
+/// The time taken by one step of importing a document.
+struct PhaseTiming
+{
+    std::string name;
+    double seconds;
+    /// The number of items (e.g. MIDI events) processed by the step, or 0 if
+    /// the step does not count them.
+    size_t count;
+};
+
+/// Runs one step of an import, and returns the time that it took.
+PhaseTiming timePhase(const char *name, const std::function<void()> &phase);
+
+/// Receives the systems of a score while it is being imported, so that e.g.
+/// the start of a large score can be displayed before the rest of the file
+/// has been read. The methods are called from the thread running the import.
+class ImportListener
+{
+public:
+    virtual ~ImportListener();
+
+    /// Called once the system at the given index (and every system before it)
+    /// will no longer be modified by the import. The score information,
+    /// players, instruments, and view filters are complete before the first
+    /// system is published.
+    virtual void systemImported(const Score &score, int index) = 0;
+
+    /// Returns whether the import should be abandoned.
+    virtual bool isCancelled() const = 0;
+};
+
 /// Base class for all file format importers.
 class FileFormatImporter
 {
@@ -58,11 +95,47 @@ public:
     /// @throw FileFormatException
     virtual void load(const std::string &filename, Score &score) = 0;
 
+    /// Returns whether the start of a file (typically only the first few
+    /// bytes) contains this format's signature.
+    virtual bool matchesSignature(const uint8_t *data,
+                                  size_t length) const = 0;
+
+    /// Reads the score information (title, artist, etc) from the header at
+    /// the start of a file, without loading the rest of the file.
+    /// Returns false if the format does not store this in a header.
+    /// @throw std::exception if the header is invalid.
+    virtual bool readScoreInfo(const uint8_t *data, size_t length,
+                               ScoreInfo &info) const;
+
     /// Returns the file format corresponding to this importer.
     FileFormat fileFormat() const;
 
+    /// Returns the time taken by each step of the last call to load(), such
+    /// as reading the file and formatting the score.
+    const std::vector<PhaseTiming> &getTimings() const;
+
+    /// Sets the listener to notify as systems are imported by load(), or
+    /// nullptr if no one is interested.
+    void setListener(ImportListener *listener);
+
+protected:
+    /// Returns whether systems should be published as soon as they are
+    /// complete, rather than after the entire score has been imported.
+    bool hasListener() const;
+
+    /// Notifies the listener (if any) that the system at the given index is
+    /// complete.
+    void publishSystem(const Score &score, int index) const;
+
+    /// @throw ImportCancelledException if the listener has cancelled the
+    /// import.
+    void checkCancelled() const;
+
+    std::vector<PhaseTiming> myTimings;
+
 private:
     const FileFormat myFormat;
+    ImportListener *myListener;
 };
 
 /// Base class for all file format exporters.
@@ -91,4 +164,11 @@ public:
     FileFormatException(const std::string &error);
 };
 
+/// Exception used when an import is abandoned at the listener's request.
+class ImportCancelledException : public FileFormatException
+{
+public:
+    ImportCancelledException();
+};
+
 #endif
@@ -17,12 +17,62 @@
   
 #include "fileformatmanager.h"
 
+#include <algorithm>
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <formats/gpx/gpximporter.h>
 #include <formats/guitar_pro/guitarproimporter.h>
 #include <formats/midi/midiexporter.h>
+#include <formats/midi/midiimporter.h>
 #include <formats/powertab/powertabimporter.h>
 #include <formats/powertab/powertabexporter.h>
 #include <formats/powertab_old/powertaboldimporter.h>
+#include <util/atomicfile.h>
+
+namespace
+{
+/// A read-only, memory-mapped view of a file.
+class FileView
+{
+public:
+    explicit FileView(const std::string &filename)
+    {
+        // Empty files cannot be mapped.
+        boost::system::error_code error;
+        if (boost::filesystem::file_size(filename, error) == 0 && !error)
+            return;
+
+        try
+        {
+            myFile.open(filename);
+        }
+        catch (const std::exception &)
+        {
+            throw FileFormatException("Could not open file: " + filename);
+        }
+    }
+
+    const uint8_t *data() const
+    {
+        return myFile.is_open()
+                   ? reinterpret_cast<const uint8_t *>(myFile.data())
+                   : nullptr;
+    }
+
+    size_t size() const
+    {
+        return myFile.is_open() ? myFile.size() : 0;
+    }
+
+private:
+    boost::iostreams::mapped_file_source myFile;
+};
+}
+
+FileProbe::FileProbe(const FileFormat &format) : format(format)
+{
+}
 
 FileFormatManager::FileFormatManager(const SettingsManager &settings_manager)
 {
@@ -30,8 +80,9 @@ FileFormatManager::FileFormatManager(const SettingsManager &settings_manager)
     myImporters.emplace_back(new PowerTabOldImporter());
     myImporters.emplace_back(new GuitarProImporter());
     myImporters.emplace_back(new GpxImporter());
+    myImporters.emplace_back(new MidiImporter());
 
-    myExporters.emplace_back(new PowerTabExporter());
+    myExporters.emplace_back(new PowerTabExporter(settings_manager));
     myExporters.emplace_back(new MidiExporter(settings_manager));
 }
 
@@ -53,6 +104,73 @@ boost::optional<FileFormat> FileFormatManager::findFormat(
     return boost::none;
 }
 
+boost::optional<FileFormat> FileFormatManager::findExportFormat(
+        const std::string &extension) const
+{
+    for (auto &exporter : myExporters)
+    {
+        if (exporter->fileFormat().contains(extension))
+            return exporter->fileFormat();
+    }
+
+    return boost::none;
+}
+
+boost::optional<FileProbe> FileFormatManager::probeFile(
+        const std::string &filename) const
+{
+    const FileView file(filename);
+
+    std::string extension =
+        boost::filesystem::path(filename).extension().string();
+    if (!extension.empty())
+        extension.erase(0, 1);
+    const boost::optional<FileFormat> preferred = findFormat(extension);
+
+    const FileFormatImporter *importer = findImporter(
+        file.data(), file.size(), preferred ? preferred.get_ptr() : nullptr);
+    if (!importer)
+        return boost::none;
+
+    FileProbe probe(importer->fileFormat());
+    try
+    {
+        ScoreInfo info;
+        if (importer->readScoreInfo(file.data(), file.size(), info))
+            probe.scoreInfo = info;
+    }
+    catch (const std::exception &)
+    {
+        // The error will be reported if the file is imported.
+    }
+
+    return probe;
+}
+
+FileFormatImporter *FileFormatManager::findImporter(
+        const uint8_t *data, size_t length, const FileFormat *preferred) const
+{
+    if (preferred)
+    {
+        for (auto &importer : myImporters)
+        {
+            if (importer->fileFormat() == *preferred &&
+                importer->matchesSignature(data, length))
+            {
+                return importer.get();
+            }
+        }
+    }
+
+    for (auto &importer : myImporters)
+    {
+        if (importer->matchesSignature(data, length))
+            return importer.get();
+    }
+
+    return nullptr;
+}
+
 std::string FileFormatManager::importFileFilter() const
 {
     std::string filterAll = "All Supported Formats (";
@@ -74,18 +192,41 @@ std::string FileFormatManager::importFileFilter() const
 }
 
 void FileFormatManager::importFile(Score &score, const std::string &filename,
-                                   const FileFormat &format)
+                                   const FileFormat &format,
+                                   ImportListener *listener)
 {
-    for (auto &importer : myImporters)
+    auto it = std::find_if(
+        myImporters.begin(), myImporters.end(),
+        [&](const std::unique_ptr<FileFormatImporter> &importer) {
+            return importer->fileFormat() == format;
+        });
+    if (it == myImporters.end())
+        throw std::runtime_error("Unknown file format");
+
+    // Check the start of the file before attempting a full import.
+    FileFormatImporter *importer = nullptr;
     {
-        if (importer->fileFormat() == format)
-        {
-            importer->load(filename, score);
-            return;
-        }
+        const FileView file(filename);
+        importer = findImporter(file.data(), file.size(), &format);
     }
 
-    throw std::runtime_error("Unknown file format");
+    if (!importer)
+    {
+        throw FileFormatException("The file is not a valid " + format.name() +
+                                  " file");
+    }
+
+    importer->setListener(listener);
+    try
+    {
+        importer->load(filename, score);
+    }
+    catch (...)
+    {
+        importer->setListener(nullptr);
+        throw;
+    }
+    importer->setListener(nullptr);
 }
 
 std::string FileFormatManager::exportFileFilter() const
@@ -105,13 +246,16 @@ std::string FileFormatManager::exportFileFilter() const
 
 void FileFormatManager::exportFile(const Score &score,
                                    const std::string &filename,
-                                   const FileFormat &format)
+                                   const FileFormat &format) const
 {
     for (auto &exporter : myExporters)
     {
         if (exporter->fileFormat() == format)
         {
-            exporter->save(filename, score);
+            // Avoid truncating an existing file if the export fails.
+            Util::writeFileAtomically(filename, [&](const std::string &path) {
+                exporter->save(path, score);
+            });
             return;
         }
     }
@@ -20,6 +20,7 @@
 
 #include <boost/optional/optional.hpp>
 #include <memory>
+#include <score/scoreinfo.h>
 #include <vector>
 #include "fileformat.h"
 
@@ -28,6 +29,18 @@ class FileFormatExporter;
 class Score;
 class SettingsManager;
 
+/// Information about a file that is read from the start of the file, without
+/// importing it.
+struct FileProbe
+{
+    explicit FileProbe(const FileFormat &format);
+
+    /// The format of the file, based on its contents.
+    FileFormat format;
+    /// The score information, if the format stores it in the file's header.
+    boost::optional<ScoreInfo> scoreInfo;
+};
+
 /// An interface for import/export of various file formats.
 class FileFormatManager
 {
@@ -37,24 +50,49 @@ public:
     /// Returns the file format corresponding to the given extension.
     boost::optional<FileFormat> findFormat(const std::string &extension) const;
 
+    /// Returns the file format that can be exported to for the given
+    /// extension. This may differ from findFormat() when the importer and
+    /// exporter of a format support different sets of extensions.
+    boost::optional<FileFormat> findExportFormat(
+        const std::string &extension) const;
+
+    /// Identifies the format of a file from its contents rather than its
+    /// extension, and reads the score information from the file's header
+    /// where possible. Only the start of the file is read.
+    /// Returns boost::none if the file is not in a supported format.
+    /// @throws FileFormatException if the file could not be opened.
+    boost::optional<FileProbe> probeFile(const std::string &filename) const;
+
     /// Returns a correctly formatted file filter for a Qt file dialog.
     /// e.g. "FileType (*.ext1 *.ext2);;FileType2 (*.ext3)".
     std::string importFileFilter() const;
 
-    /// Imports a file into the given score.
+    /// Imports a file into the given score. The contents of the file are
+    /// checked first, so a file with the wrong extension is imported using
+    /// the correct format, and an unrecognized file fails immediately.
+    /// If a listener is given, it is notified as each system is imported
+    /// (for formats that support this) and can cancel the import.
     /// @throws std::exception
     void importFile(Score &score, const std::string &filename,
-                    const FileFormat &format);
+                    const FileFormat &format,
+                    ImportListener *listener = nullptr);
 
     /// Returns a correctly formatted file filter for a Qt file dialog.
     std::string exportFileFilter() const;
 
-    /// Exports the given score to a file.
+    /// Exports the given score to a file. The file is written to a temporary
+    /// location first and then renamed, so an existing file is never left
+    /// half-written.
     /// @throws std::exception
     void exportFile(const Score &score, const std::string &filename,
-                    const FileFormat &format);
+                    const FileFormat &format) const;
 
 private:
+    /// Returns the importer whose signature matches the start of the file,
+    /// checking the preferred format first.
+    FileFormatImporter *findImporter(const uint8_t *data, size_t length,
+                                     const FileFormat *preferred) const;
+
     template <typename Importer>
     void registerImporter();
 
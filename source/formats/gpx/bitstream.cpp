@@ -17,63 +17,121 @@
   
 #include "bitstream.h"
 
+#include <array>
 #include <cassert>
-#include <istream>
-#include "util.h"
 
 static const uint32_t BYTE_LENGTH = 8;
+static const int BUFFER_LENGTH = 64;
 
-Gpx::BitStream::BitStream(std::istream &stream)
-    : myPosition(0)
+/// Lookup table for reversing the bits in a byte.
+static std::array<uint8_t, 256> createReversedBytes()
 {
-    // Copy data from the stream into an internal buffer.
-    stream.seekg(0, std::ios::end);
-    myBytes.resize(stream.tellg());
+    std::array<uint8_t, 256> table;
+    for (int i = 0; i < 256; ++i)
+    {
+        uint8_t reversed = 0;
+        for (uint32_t bit = 0; bit < BYTE_LENGTH; ++bit)
+        {
+            if (i & (1 << bit))
+                reversed |= 1 << (BYTE_LENGTH - 1 - bit);
+        }
+        table[i] = reversed;
+    }
 
-    stream.seekg(0, std::ios::beg);
-    stream.read(reinterpret_cast<char *>(&myBytes[0]), myBytes.size());
+    return table;
 }
 
-uint32_t Gpx::BitStream::readInt()
+static const std::array<uint8_t, 256> theReversedBytes = createReversedBytes();
+
+/// Reverses the order of the lowest n bits.
+static uint32_t reverseBits(uint32_t value, int n)
 {
-    assert(myPosition % BYTE_LENGTH == 0);
+    const uint32_t reversed = (theReversedBytes[value & 0xff] << 24) |
+                              (theReversedBytes[(value >> 8) & 0xff] << 16) |
+                              (theReversedBytes[(value >> 16) & 0xff] << 8) |
+                              theReversedBytes[value >> 24];
+    return reversed >> (32 - n);
+}
 
-    const uint32_t value = Gpx::Util::readUInt(myBytes,
-                                               myPosition / BYTE_LENGTH);
-    myPosition += sizeof(uint32_t) * BYTE_LENGTH;
-    return value;
+Gpx::BitStream::BitStream(const uint8_t *data, size_t length)
+    : myBegin(data),
+      myEnd(data + length),
+      myNext(data),
+      myPosition(0),
+      myBuffer(0),
+      myBufferSize(0)
+{
 }
 
-bool Gpx::BitStream::readBit()
+void Gpx::BitStream::refill()
 {
-    if (myPosition / BYTE_LENGTH >= myBytes.size())
-        return 0;
+    if (myEnd - myNext >= 8)
+    {
+        // Load a full big-endian word. Any bits that don't fit in the buffer
+        // are loaded again by the next refill.
+        const uint64_t word =
+            (static_cast<uint64_t>(myNext[0]) << 56) |
+            (static_cast<uint64_t>(myNext[1]) << 48) |
+            (static_cast<uint64_t>(myNext[2]) << 40) |
+            (static_cast<uint64_t>(myNext[3]) << 32) |
+            (static_cast<uint64_t>(myNext[4]) << 24) |
+            (static_cast<uint64_t>(myNext[5]) << 16) |
+            (static_cast<uint64_t>(myNext[6]) << 8) |
+            static_cast<uint64_t>(myNext[7]);
 
-    char byte = myBytes[myPosition / BYTE_LENGTH];
-    byte >>= ((BYTE_LENGTH - 1) - (myPosition % BYTE_LENGTH));
-    byte &= 0x01;
+        myBuffer |= word >> myBufferSize;
+        const int numBytes = (BUFFER_LENGTH - 1 - myBufferSize) / BYTE_LENGTH;
+        myNext += numBytes;
+        myBufferSize += numBytes * BYTE_LENGTH;
+    }
+    else
+    {
+        while (myNext != myEnd &&
+               myBufferSize <= BUFFER_LENGTH - static_cast<int>(BYTE_LENGTH))
+        {
+            myBuffer |= static_cast<uint64_t>(*myNext++)
+                        << (BUFFER_LENGTH - BYTE_LENGTH - myBufferSize);
+            myBufferSize += BYTE_LENGTH;
+        }
+    }
+}
 
-    ++myPosition;
+uint32_t Gpx::BitStream::readInt()
+{
+    assert(myPosition % BYTE_LENGTH == 0);
+
+    // The integer is stored in little-endian order.
+    const uint32_t n1 = readBits(8);
+    const uint32_t n2 = readBits(8);
+    const uint32_t n3 = readBits(8);
+    const uint32_t n4 = readBits(8);
+
+    return n1 | (n2 << 8) | (n3 << 16) | (n4 << 24);
+}
 
-    return byte != 0;
+bool Gpx::BitStream::readBit()
+{
+    return readBits(1) != 0;
 }
 
 int32_t Gpx::BitStream::readBits(int n, BitOrder order)
 {
-    int32_t value = 0;
+    assert(n >= 0 && n <= 32);
+    if (n == 0)
+        return 0;
+
+    if (myBufferSize < n)
+        refill();
+
+    uint32_t value = static_cast<uint32_t>(myBuffer >> (BUFFER_LENGTH - n));
+    myBuffer <<= n;
+    myBufferSize = (myBufferSize > n) ? myBufferSize - n : 0;
+    myPosition += n;
 
     if (order == Reversed)
-    {
-        for (int i = 0; i < n; ++i)
-            value |= (readBit() << i);
-    }
-    else
-    {
-        for (int i = n - 1; i >= 0; --i)
-            value |= (readBit() << i);
-    }
+        value = reverseBits(value, n);
 
-    return value;
+    return static_cast<int32_t>(value);
 }
 
 size_t Gpx::BitStream::getLocation() const
@@ -83,5 +141,5 @@ size_t Gpx::BitStream::getLocation() const
 
 bool Gpx::BitStream::isAtEnd() const
 {
-    return getLocation() >= (myBytes.size() - 1);
+    return getLocation() + 1 >= static_cast<size_t>(myEnd - myBegin);
 }
@@ -18,15 +18,17 @@
 #ifndef FORMATS_GPX_BITSTREAM_H
 #define FORMATS_GPX_BITSTREAM_H
 
+#include <cstddef>
 #include <cstdint>
-#include <iosfwd>
-#include <vector>
 
 namespace Gpx
 {
 
 /// Provides the ability to read individual bits from a stream.
 /// This is required for the compression scheme used in .gpx files.
+/// The input is not copied, so it must outlive the bit stream (e.g. a
+/// memory-mapped file). Bits are extracted from a 64-bit buffer that is
+/// refilled a word at a time.
 class BitStream
 {
 public:
@@ -36,7 +38,7 @@ public:
         Reversed
     };
 
-    BitStream(std::istream &stream);
+    BitStream(const uint8_t *data, size_t length);
 
     /// Reads a 32-bit unsigned integer from the stream. This assumes that the
     /// stream position is exactly on the start of a byte.
@@ -45,7 +47,8 @@ public:
     /// Reads the next bit from the stream.
     bool readBit();
 
-    /// Reads the next n bits from the stream into an integer.
+    /// Reads the next n bits (at most 32) from the stream into an integer.
+    /// Any bits past the end of the stream are read as zero.
     int32_t readBits(int n, BitOrder = Normal);
 
     /// Returns the position in the stream (measured in bytes).
@@ -55,10 +58,20 @@ public:
     bool isAtEnd() const;
 
 private:
+    /// Loads as many bytes as possible into the bit buffer.
+    void refill();
+
+    /// The compressed data being read.
+    const uint8_t *myBegin;
+    const uint8_t *myEnd;
+    /// The next byte to be loaded into the bit buffer.
+    const uint8_t *myNext;
     /// The current position in the input (measured in bits).
     size_t myPosition;
-    /// The compressed data being read.
-    std::vector<uint8_t> myBytes;
+    /// Buffered bits, starting from the most significant bit.
+    uint64_t myBuffer;
+    /// The number of valid bits in the buffer.
+    int myBufferSize;
 };
 
 }
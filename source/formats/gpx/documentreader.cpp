@@ -17,37 +17,58 @@
   
 #include "documentreader.h"
 
+#include <algorithm>
 #include <boost/date_time/gregorian/gregorian_types.hpp>
+#include <cerrno>
+#include <cstdlib>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <iterator>
 #include <score/generalmidi.h>
 #include <score/score.h>
 #include <sstream>
 #include <stdexcept>
+#include <util/parallel.h>
 
 static const int POSITIONS_PER_SYSTEM = 35;
 
 using namespace pugi;
 
-/// Utility function for parsing a string of space-separated values.
-template <typename T>
-static void convertStringToList(const std::string &source, std::vector<T> &dest)
+/// Utility function for parsing a string of space-separated integers. The
+/// destination is cleared first, so it can be reused.
+static void convertStringToList(const char *source, std::vector<int> &dest)
 {
-    std::stringstream ss(source);
-    T item;
     dest.clear();
 
-    while (ss >> item)
+    char *end = nullptr;
+    for (const char *pos = source;; pos = end)
     {
-        dest.push_back(item);
+        errno = 0;
+        const long item = std::strtol(pos, &end, 10);
+        if (end == pos || errno == ERANGE)
+            break;
+
+        dest.push_back(static_cast<int>(item));
     }
 
     if (dest.empty())
         std::cerr << "Parsing of list failed!!" << std::endl;
 }
 
-Gpx::DocumentReader::DocumentReader(const std::string &xml)
+/// Returns the number of child elements, which is used to size the id tables.
+static size_t countChildren(const xml_node &node)
 {
-    xml_parse_result result = myXmlData.load(xml.c_str());
+    return static_cast<size_t>(std::distance(node.begin(), node.end()));
+}
+
+Gpx::DocumentReader::DocumentReader(std::string xml)
+    : myXmlBuffer(std::move(xml))
+{
+    xml_parse_result result = myXmlData.load_buffer_inplace(
+        &myXmlBuffer[0], myXmlBuffer.size(), parse_default, encoding_utf8);
 
     if (result.status != pugi::status_ok)
         throw std::runtime_error(result.description());
@@ -56,18 +77,52 @@ Gpx::DocumentReader::DocumentReader(const std::string &xml)
     myFile = myXmlData.first_child();
 }
 
+typedef std::chrono::high_resolution_clock Clock;
+
 void Gpx::DocumentReader::readScore(Score &score)
 {
-    readHeader(score);
-    readTracks(score);
-    readBars();
-    readVoices();
-    readBeats();
-    readRhythms();
-    readNotes();
-    readAutomations();
-
-    readMasterBars(score);
+    myTimings.clear();
+    const auto start = Clock::now();
+
+    // Each section is stored in a different child of the GPIF node and is
+    // read into a separate table, so the sections can be parsed in parallel.
+    // The xml document is not modified while this is happening.
+    std::vector<std::future<PhaseTiming>> tasks;
+    auto runTask = [&](const char *name, std::function<void()> phase) {
+        tasks.push_back(std::async(Util::launchPolicy(), [=]() {
+            return timePhase(name, phase);
+        }));
+    };
+
+    runTask("Header and tracks", [&]() {
+        readHeader(score);
+        readTracks(score);
+    });
+    runTask("Bars", [this]() { readBars(); });
+    runTask("Voices", [this]() { readVoices(); });
+    runTask("Beats", [this]() { readBeats(); });
+    runTask("Rhythms", [this]() { readRhythms(); });
+    runTask("Notes", [this]() { readNotes(); });
+    runTask("Automations", [this]() { readAutomations(); });
+
+    // Wait for all of the tasks to finish before rethrowing any errors.
+    for (std::future<PhaseTiming> &task : tasks)
+        task.wait();
+    for (std::future<PhaseTiming> &task : tasks)
+        myTimings.push_back(task.get());
+
+    myTimings.push_back(timePhase("Master bars", [&]() {
+        readMasterBars(score);
+    }));
+
+    myTimings.push_back(
+        { "Total", std::chrono::duration<double>(Clock::now() - start).count(),
+          0 });
+}
+
+const std::vector<PhaseTiming> &Gpx::DocumentReader::getTimings() const
+{
+    return myTimings;
 }
 
 void Gpx::DocumentReader::readHeader(Score &score)
@@ -145,31 +200,40 @@ void Gpx::DocumentReader::readTracks(Score &score)
 
 void Gpx::DocumentReader::readBars()
 {
-    for (xml_node currentBar : myFile.child("Bars"))
+    xml_node bars = myFile.child("Bars");
+    myBars.reset(countChildren(bars));
+
+    for (xml_node currentBar : bars)
     {
         Gpx::Bar bar;
         bar.id = currentBar.attribute("id").as_int();
         convertStringToList(currentBar.child_value("Voices"), bar.voiceIds);
 
-        myBars[bar.id] = bar;
+        myBars[bar.id] = std::move(bar);
     }
 }
 
 void Gpx::DocumentReader::readVoices()
 {
-    for (xml_node currentVoice : myFile.child("Voices"))
+    xml_node voices = myFile.child("Voices");
+    myVoices.reset(countChildren(voices));
+
+    for (xml_node currentVoice : voices)
     {
         Gpx::Voice voice;
         voice.id = currentVoice.attribute("id").as_int();
         convertStringToList(currentVoice.child_value("Beats"), voice.beatIds);
 
-        myVoices[voice.id] = voice;
+        myVoices[voice.id] = std::move(voice);
     }
 }
 
 void Gpx::DocumentReader::readBeats()
 {
-    for (xml_node currentBeat : myFile.child("Beats"))
+    xml_node beats = myFile.child("Beats");
+    myBeats.reset(countChildren(beats));
+
+    for (xml_node currentBeat : beats)
     {
         Gpx::Beat beat;
         beat.id = currentBeat.attribute("id").as_int();
@@ -193,28 +257,37 @@ void Gpx::DocumentReader::readBeats()
             }
         }
 
-        myBeats[beat.id] = beat;
+        myBeats[beat.id] = std::move(beat);
     }
 }
 
 void Gpx::DocumentReader::readRhythms()
 {
-    for (xml_node currentRhythm : myFile.child("Rhythms"))
+    xml_node rhythms = myFile.child("Rhythms");
+    myRhythms.reset(countChildren(rhythms));
+
+    for (xml_node currentRhythm : rhythms)
     {
         Gpx::Rhythm rhythm;
         rhythm.id = currentRhythm.attribute("id").as_int();
 
         // Convert duration to PowerTab format.
-        const std::string noteValueStr = currentRhythm.child_value("NoteValue");
-
-        std::map<std::string, int> noteValuesToInt = {
-			{ "Whole", 1 }, { "Half", 2 }, { "Quarter", 4 },
-			{ "Eighth", 8 }, { "16th", 16 }, { "32nd", 32 },
-			{ "64th", 64 }
-		};
-
-        assert(noteValuesToInt.find(noteValueStr) != noteValuesToInt.end());
-        rhythm.noteValue = noteValuesToInt.find(noteValueStr)->second;
+        const char *noteValueStr = currentRhythm.child_value("NoteValue");
+
+        static const std::pair<const char *, int> noteValuesToInt[] = {
+            { "Whole", 1 }, { "Half", 2 }, { "Quarter", 4 },
+            { "Eighth", 8 }, { "16th", 16 }, { "32nd", 32 },
+            { "64th", 64 }
+        };
+
+        auto noteValue = std::find_if(
+            std::begin(noteValuesToInt), std::end(noteValuesToInt),
+            [=](const std::pair<const char *, int> &value) {
+                return std::strcmp(value.first, noteValueStr) == 0;
+            });
+        if (noteValue == std::end(noteValuesToInt))
+            throw std::runtime_error("Invalid note value");
+        rhythm.noteValue = noteValue->second;
 
         // Handle dotted/double dotted notes
         int numDots = currentRhythm.child("AugmentationDot").attribute(
@@ -229,7 +302,10 @@ void Gpx::DocumentReader::readRhythms()
 
 void Gpx::DocumentReader::readNotes()
 {
-    for (xml_node currentNote : myFile.child("Notes"))
+    xml_node notes = myFile.child("Notes");
+    myNotes.reset(countChildren(notes));
+
+    for (xml_node currentNote : notes)
     {
         Gpx::TabNote note;
         note.id = currentNote.attribute("id").as_int();
@@ -244,12 +320,15 @@ void Gpx::DocumentReader::readNotes()
         note.letRing = !currentNote.child("LetRing").empty();
         note.trillNote = currentNote.child("Trill").text().as_int(-1);
 
-        myNotes[note.id] = note;
+        myNotes[note.id] = std::move(note);
     }
 }
 
 void Gpx::DocumentReader::readAutomations()
 {
+    // Automations are stored by bar index.
+    myAutomations.reset(countChildren(myFile.child("MasterBars")));
+
     for (xpath_node node :
          myFile.select_nodes("./MasterTrack/Automations/Automation"))
     {
@@ -268,7 +347,7 @@ void Gpx::DocumentReader::readAutomations()
 
         // TODO - this code doesn't support having multiple automations in a
         // bar.
-        myAutomations[gpxAutomation.bar] = gpxAutomation;
+        myAutomations[gpxAutomation.bar] = std::move(gpxAutomation);
     }
 }
 
@@ -286,6 +365,7 @@ void Gpx::DocumentReader::readMasterBars(Score &score)
 
     int barIndex = 0;
     int startPos = 0;
+    std::vector<int> barIds;
     for (xml_node masterBar : myFile.child("MasterBars"))
     {
         if (masterBar.name() != std::string("MasterBar"))
@@ -306,18 +386,17 @@ void Gpx::DocumentReader::readMasterBars(Score &score)
 
         Barline barline;
 
-        if (myAutomations.find(barIndex) != myAutomations.end())
+        if (const Automation *automation = myAutomations.find(barIndex))
         {
-            const Automation automation = myAutomations.find(barIndex)->second;
-            if (automation.type == "Tempo")
+            if (automation->type == "Tempo")
             {
-                if (automation.value.size() != 2)
+                if (automation->value.size() != 2)
                     throw std::runtime_error("Invalid tempo");
 
                 TempoMarker marker(startPos);
                 marker.setBeatsPerMinute(
-                    automation.value[0] *
-                    static_cast<int>(automation.value[1] / 2.0));
+                    automation->value[0] *
+                    static_cast<int>(automation->value[1] / 2.0));
                 system.insertTempoMarker(marker);
             }
         }
@@ -332,7 +411,6 @@ void Gpx::DocumentReader::readMasterBars(Score &score)
         readTimeSignature(masterBar, time);
         barline.setTimeSignature(time);
 
-        std::vector<int> barIds;
         convertStringToList(masterBar.child_value("Bars"), barIds);
 
         int nextPos = startPos;
@@ -343,11 +421,14 @@ void Gpx::DocumentReader::readMasterBars(Score &score)
             Staff &staff = system.getStaves()[i];
             int currentPos = (startPos != 0) ? startPos + 1 : 0;
 
+            const Gpx::Bar &bar = myBars.at(barIds[i]);
+            if (bar.voiceIds.empty())
+                throw FileFormatException("Bar has no voices");
+
             // TODO - import multiple voices.
-            for (int beatId :
-                 myVoices[myBars[barIds[i]].voiceIds.at(0)].beatIds)
+            for (int beatId : myVoices.at(bar.voiceIds[0]).beatIds)
             {
-                const Gpx::Beat &beat = myBeats[beatId];
+                const Gpx::Beat &beat = myBeats.at(beatId);
 
                 // Create text item at this position if necessary.
                 if (!beat.freeText.empty())
@@ -475,7 +556,7 @@ void Gpx::DocumentReader::readTimeSignature(const xml_node &masterBar,
 Note Gpx::DocumentReader::convertNote(int noteId, Position &position,
                                       const Tuning &tuning) const
 {
-    Gpx::TabNote gpxNote = myNotes.at(noteId);
+    const Gpx::TabNote &gpxNote = myNotes.at(noteId);
     Note ptbNote;
 
     ptbNote.setProperty(Note::Tied, gpxNote.tied);
@@ -18,9 +18,11 @@
 #ifndef FORMATS_GPX_DOCUMENTREADER_H
 #define FORMATS_GPX_DOCUMENTREADER_H
 
-#include <map>
+#include <formats/fileformat.h>
 #include <pugixml.hpp>
 #include <score/note.h>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 class Barline;
@@ -87,13 +89,90 @@ struct Automation
     std::vector<int> value;
 };
 
+/// Stores objects by id. The ids in a .gpif file are normally small
+/// consecutive integers, so the objects are stored directly in a vector.
+/// Ids that are too large to store compactly (relative to the number of
+/// objects in the file) are kept in a hash map instead.
+template <typename T>
+class IdTable
+{
+public:
+    IdTable() : myMaxDenseId(0)
+    {
+    }
+
+    /// Removes all objects, and prepares for the given number of objects.
+    void reset(size_t count)
+    {
+        myItems.clear();
+        myItems.reserve(count);
+        myValidIds.clear();
+        mySparseItems.clear();
+        myMaxDenseId = count * MAX_DENSE_RATIO;
+    }
+
+    /// Returns the object with the given id, creating it if necessary.
+    T &operator[](int id)
+    {
+        if (id < 0 || static_cast<size_t>(id) >= myMaxDenseId)
+            return mySparseItems[id];
+
+        if (static_cast<size_t>(id) >= myItems.size())
+        {
+            myItems.resize(id + 1);
+            myValidIds.resize(id + 1, false);
+        }
+
+        myValidIds[id] = true;
+        return myItems[id];
+    }
+
+    /// Returns the object with the given id, or nullptr if there is none.
+    const T *find(int id) const
+    {
+        if (id >= 0 && static_cast<size_t>(id) < myItems.size())
+            return myValidIds[id] ? &myItems[id] : nullptr;
+
+        auto it = mySparseItems.find(id);
+        return it != mySparseItems.end() ? &it->second : nullptr;
+    }
+
+    /// Returns the object with the given id.
+    /// @throw FileFormatException if there is no object with that id.
+    const T &at(int id) const
+    {
+        const T *item = find(id);
+        if (!item)
+            throw FileFormatException("Missing id: " + std::to_string(id));
+
+        return *item;
+    }
+
+private:
+    /// Ids below this multiple of the number of objects are stored in the
+    /// vector, which bounds the memory used for unusual ids.
+    static const size_t MAX_DENSE_RATIO = 4;
+
+    std::vector<T> myItems;
+    std::vector<bool> myValidIds;
+    std::unordered_map<int, T> mySparseItems;
+    size_t myMaxDenseId;
+};
+
 class DocumentReader
 {
 public:
-    DocumentReader(const std::string &xml);
+    /// Parses the xml data in place, without making a copy.
+    DocumentReader(std::string xml);
 
+    /// Reads the document into the score. The sections of the document
+    /// (tracks, bars, voices, etc) are parsed concurrently, and are then
+    /// assembled into bars.
     void readScore(Score &score);
 
+    /// Returns the time taken by each step of the last call to readScore().
+    const std::vector<PhaseTiming> &getTimings() const;
+
 private:
     /// Loads the header information (song title, artist, etc).
     void readHeader(Score &score);
@@ -114,15 +193,20 @@ private:
                            TimeSignature &timeSignature);
     Note convertNote(int noteId, Position &position, const Tuning &tuning) const;
 
+    /// The xml text, which the parsed document refers to.
+    std::string myXmlBuffer;
     pugi::xml_document myXmlData;
     pugi::xml_node myFile;
 
-    std::map<int, Gpx::Bar> myBars;
-    std::map<int, Gpx::Voice> myVoices;
-    std::map<int, Gpx::Beat> myBeats;
-    std::map<int, Gpx::Rhythm> myRhythms;
-    std::map<int, Gpx::TabNote> myNotes;
-    std::map<int, Gpx::Automation> myAutomations;
+    IdTable<Gpx::Bar> myBars;
+    IdTable<Gpx::Voice> myVoices;
+    IdTable<Gpx::Beat> myBeats;
+    IdTable<Gpx::Rhythm> myRhythms;
+    IdTable<Gpx::TabNote> myNotes;
+    /// Automations, indexed by bar.
+    IdTable<Gpx::Automation> myAutomations;
+
+    std::vector<PhaseTiming> myTimings;
 };
 }
 
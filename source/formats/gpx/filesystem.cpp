@@ -17,9 +17,11 @@
   
 #include "filesystem.h"
 
+#include <algorithm>
 #include "bitstream.h"
 #include <boost/algorithm/clamp.hpp>
 #include <cassert>
+#include <cstring>
 #include <formats/fileformat.h>
 #include "util.h"
 
@@ -30,11 +32,12 @@ enum ChunkHeader
 };
 
 static const uint32_t SECTOR_SIZE = 0x1000;
+static const size_t HEADER_SIZE = 4;
 
-Gpx::FileSystem::FileSystem(std::istream &stream)
+Gpx::FileSystem::FileSystem(const uint8_t *data, size_t length)
 {
     // Decompress the input file and return the filesystem.
-    Gpx::BitStream input(stream);
+    Gpx::BitStream input(data, length);
 
     const uint32_t BCFS_HEADER = 0x53464342;
     const uint32_t BCFZ_HEADER = 0x5a464342;
@@ -45,12 +48,12 @@ Gpx::FileSystem::FileSystem(std::istream &stream)
     if (header != BCFZ_HEADER)
         throw FileFormatException("Invalid header");
 
-    const uint32_t length = input.readInt();
-    std::vector<uint8_t> output;
-    output.reserve(length);
+    const uint32_t outputLength = input.readInt();
+    std::vector<uint8_t> &output = myData;
+    output.reserve(outputLength);
 
     // We now have a succession of compressed and uncompressed chunks.
-    while (!input.isAtEnd() && input.getLocation() < length)
+    while (!input.isAtEnd() && input.getLocation() < outputLength)
     {
         const ChunkHeader chunkHeader = static_cast<ChunkHeader>(input.readBit());
 
@@ -71,82 +74,107 @@ Gpx::FileSystem::FileSystem(std::istream &stream)
         {
             const int32_t p = input.readBits(4);
             const int32_t offset = input.readBits(p, Gpx::BitStream::Reversed);
+            if (static_cast<size_t>(offset) > output.size())
+                throw FileFormatException("Invalid GPX Format");
             const size_t startPos = output.size() - offset;
 
+            // Since the length is at most the offset, the source and
+            // destination never overlap and the data can be copied in bulk.
             const int32_t length = boost::algorithm::clamp<int32_t>(
                 input.readBits(p, Gpx::BitStream::Reversed), 0, offset);
 
-            std::copy(output.begin() + startPos,
-                      output.begin() + startPos + length,
-                      std::back_inserter(output));
+            if (length > 0)
+            {
+                output.resize(output.size() + length);
+                std::memcpy(&output[output.size() - length], &output[startPos],
+                            length);
+            }
         }
     }
 
     // The data we just read should now have a header indicating that it's
     // uncompressed!
-    const uint32_t newHeader = Gpx::Util::readUInt(output, 0);
-    if (newHeader != BCFS_HEADER)
+    if (output.size() < HEADER_SIZE ||
+        Gpx::Util::readUInt(output, 0) != BCFS_HEADER)
+    {
         throw FileFormatException("Invalid GPX Format");
+    }
 
-    readUncompressedData(output);
+    readDirectory();
 }
 
-const std::string &Gpx::FileSystem::getFileContents(
-        const std::string &filename) const
+std::string Gpx::FileSystem::getFileContents(const std::string &filename) const
 {
-    std::map<std::string, std::string>::const_iterator file = myFiles.find(filename);
-
+    auto file = myFiles.find(filename);
     if (file == myFiles.end())
         throw FileFormatException("Invalid filename");
-    else
-        return file->second;
+
+    const FileEntry &entry = file->second;
+    const uint8_t *sectors = myData.data() + HEADER_SIZE;
+    const size_t size = myData.size() - HEADER_SIZE;
+
+    std::string contents(entry.mySize, '\0');
+    size_t copied = 0;
+    for (uint32_t sector : entry.mySectors)
+    {
+        const size_t offset = static_cast<size_t>(sector) * SECTOR_SIZE;
+        const size_t length = std::min<size_t>(
+            std::min<size_t>(SECTOR_SIZE, size - offset),
+            contents.size() - copied);
+        std::memcpy(&contents[copied], sectors + offset, length);
+        copied += length;
+    }
+
+    return contents;
 }
 
-void Gpx::FileSystem::readUncompressedData(std::vector<uint8_t> &data)
+void Gpx::FileSystem::readDirectory()
 {
-    // Remove the BCFS header.
-    data.erase(data.begin(), data.begin() + 4);
+    // Skip the BCFS header.
+    const size_t size = myData.size() - HEADER_SIZE;
+    auto readUInt = [this](size_t index) {
+        return Util::readUInt(myData, HEADER_SIZE + index);
+    };
+
     size_t offset = 0;
 
-    // Read all files from the file system.
-    while ( (offset = (offset + SECTOR_SIZE)) + 3 < data.size())
+    // Find all files in the file system.
+    while ( (offset = (offset + SECTOR_SIZE)) + 3 < size)
     {
-        if (Util::readUInt(data, offset) == 2)
+        if (readUInt(offset) == 2)
         {
             const size_t fileNameIndex = offset + 4;
-            const size_t fileSizeIndex= offset + 0x8C;
-            const size_t blockIndex= offset + 0x94;
+            const size_t fileSizeIndex = offset + 0x8C;
+            const size_t blockIndex = offset + 0x94;
 
-            int block = 0;
+            uint32_t block = 0;
             int blockCount = 0;
-            std::vector<uint8_t> fileData;
+            size_t availableSize = 0;
+            FileEntry entry;
 
-            // Read the file data.
-            while ((block = Util::readUInt(data,
-                                           blockIndex + 4 * blockCount)) != 0)
+            // Find the sectors containing the file data.
+            while ((block = readUInt(blockIndex + 4 * blockCount)) != 0)
             {
-                offset = block * SECTOR_SIZE;
-                std::copy(data.begin() + offset,
-                          data.begin() +
-                          boost::algorithm::clamp<size_t>(offset + SECTOR_SIZE,
-                                                          0, data.size()),
-                          std::back_inserter(fileData));
+                offset = static_cast<size_t>(block) * SECTOR_SIZE;
+                if (offset < size)
+                {
+                    entry.mySectors.push_back(block);
+                    availableSize += std::min<size_t>(SECTOR_SIZE,
+                                                      size - offset);
+                }
                 ++blockCount;
             }
 
             // Read the file name and save the file.
-            const uint32_t fileSize = Util::readUInt(data, fileSizeIndex);
-            if (fileData.size() >= fileSize)
+            entry.mySize = readUInt(fileSizeIndex);
+            if (availableSize >= entry.mySize)
             {
-                std::string fileName;
-                std::copy(data.begin() + fileNameIndex,
-                          data.begin() + fileNameIndex + 127,
-                          std::back_inserter(fileName));
+                const char *name = reinterpret_cast<const char *>(
+                    myData.data() + HEADER_SIZE + fileNameIndex);
                 // Trim extra NULL characters.
-                fileName.erase(fileName.find_last_not_of('\0') + 1);
+                std::string fileName(name, std::find(name, name + 127, '\0'));
 
-                std::string file(fileData.begin(), fileData.begin() + fileSize);
-                myFiles[fileName] = file;
+                myFiles[fileName] = std::move(entry);
             }
         }
     }
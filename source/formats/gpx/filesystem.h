@@ -18,8 +18,8 @@
 #ifndef FORMATS_GPX_FILESYSTEM_H
 #define FORMATS_GPX_FILESYSTEM_H
 
+#include <cstddef>
 #include <cstdint>
-#include <iosfwd>
 #include <map>
 #include <string>
 #include <vector>
@@ -30,18 +30,33 @@ namespace Gpx
 /// The uncompressed *.gpx file is essentially a filesystem containing several
 /// xml files.
 /// This class handles the extraction of information from that filesystem.
+/// Only the directory is built when the file is opened. The contents of a
+/// file are copied out of the decompressed data when requested.
 class FileSystem
 {
 public:
-    FileSystem(std::istream &stream);
+    /// Decompresses the contents of a .gpx file.
+    FileSystem(const uint8_t *data, size_t length);
 
-    const std::string &getFileContents(const std::string &filename) const;
+    /// Returns the contents of a file.
+    /// @throw FileFormatException if the file does not exist.
+    std::string getFileContents(const std::string &filename) const;
 
 private:
-    void readUncompressedData(std::vector<uint8_t> &data);
+    /// Location of a file's data within the decompressed buffer.
+    struct FileEntry
+    {
+        /// The sectors that the file is stored in, in order.
+        std::vector<uint32_t> mySectors;
+        uint32_t mySize;
+    };
 
-    /// Maps filenames to file contents.
-    std::map<std::string, std::string> myFiles;
+    void readDirectory();
+
+    /// The decompressed data, including the BCFS header.
+    std::vector<uint8_t> myData;
+    /// Maps filenames to their location in myData.
+    std::map<std::string, FileEntry> myFiles;
 };
 
 }
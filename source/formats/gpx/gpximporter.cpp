@@ -19,7 +19,10 @@
 
 #include "filesystem.h"
 #include "documentreader.h"
-#include <fstream>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <chrono>
+#include <cstring>
+#include <memory>
 #include <score/score.h>
 #include <score/utils/scorepolisher.h>
 
@@ -31,12 +34,42 @@ GpxImporter::GpxImporter()
 void GpxImporter::load(const std::string &filename, Score &score)
 {
     // Load the data, decompress, and open as XML document.
-    std::ifstream file(filename.c_str(), std::ios::binary | std::ios::in);
-    Gpx::FileSystem fs(file);
+    boost::iostreams::mapped_file_source file;
+    try
+    {
+        file.open(filename);
+    }
+    catch (const std::exception &)
+    {
+        throw FileFormatException("Could not open file: " + filename);
+    }
 
-    Gpx::DocumentReader reader(fs.getFileContents("score.gpif"));
-    reader.readScore(score);
+    typedef std::chrono::high_resolution_clock Clock;
+    myTimings.clear();
+    const auto start = Clock::now();
 
-    ScoreUtils::polishScore(score);
+    std::unique_ptr<Gpx::FileSystem> fs;
+    myTimings.push_back(timePhase("Decompress", [&]() {
+        fs.reset(new Gpx::FileSystem(
+            reinterpret_cast<const uint8_t *>(file.data()), file.size()));
+    }));
+
+    // A more detailed breakdown is available from the document reader.
+    Gpx::DocumentReader reader(fs->getFileContents("score.gpif"));
+    myTimings.push_back(
+        timePhase("Read", [&]() { reader.readScore(score); }));
+
+    myTimings.push_back(
+        timePhase("Polish", [&]() { ScoreUtils::polishScore(score); }));
     ScoreUtils::addStandardFilters(score);
+
+    myTimings.push_back(
+        { "Total",
+          std::chrono::duration<double>(Clock::now() - start).count() });
+}
+
+bool GpxImporter::matchesSignature(const uint8_t *data, size_t length) const
+{
+    // Only compressed files are supported.
+    return length >= 4 && std::memcmp(data, "BCFZ", 4) == 0;
 }
@@ -26,6 +26,11 @@ public:
     GpxImporter();
 
     virtual void load(const std::string &filename, Score &score) override;
+
+    /// The score information can't be read without decompressing the entire
+    /// file, so only the signature is checked when probing.
+    virtual bool matchesSignature(const uint8_t *data,
+                                  size_t length) const override;
 };
 
 #endif
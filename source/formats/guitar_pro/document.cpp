@@ -242,7 +242,7 @@ void Header::load(InputStream &stream)
         for (int i = 0; i < 11; ++i)
         {
             stream.skip(4);
-            stream.readFixedLengthString(0);
+            stream.readFixedLengthStringView(0);
         }
     }
 }
@@ -642,7 +642,7 @@ void Beat::loadChordDiagram(InputStream &stream)
     if (stream.version == Version3)
     {
         stream.skip(25);
-        stream.readFixedLengthString(34); // Chord name.
+        stream.readFixedLengthStringView(34); // Chord name.
         stream.read<uint32_t>(); // Top fret of chord.
 
         // Strings that are used.
@@ -664,7 +664,7 @@ void Beat::loadChordDiagram(InputStream &stream)
     stream.read<uint32_t>(); // diminished/augmented
     stream.read<uint8_t>(); // "add" chord
 
-    stream.readFixedLengthString(DIAGRAM_DESCRIPTION_LENGTH);
+    stream.readFixedLengthStringView(DIAGRAM_DESCRIPTION_LENGTH);
 
     // more blank bytes for backwards compatibility
     stream.skip(2);
@@ -703,7 +703,7 @@ void Beat::loadChordDiagram(InputStream &stream)
 
 void Beat::loadOldChordDiagram(InputStream &stream)
 {
-    stream.readString(); // chord diagram name
+    stream.readStringView(); // chord diagram name
 
     const uint32_t baseFret = stream.read<uint32_t>();
 
@@ -816,7 +816,7 @@ void Beat::loadMixTableChangeEvent(InputStream &stream)
     int8_t tremolo = stream.read<uint8_t>(); // tremolo
 
     if (stream.version > Version4)
-        stream.readString(); // TODO - tempo name?
+        stream.readStringView(); // TODO - tempo name?
 
     // New tempo.
     int32_t tempo = stream.read<int32_t>();
@@ -861,8 +861,8 @@ void Beat::loadMixTableChangeEvent(InputStream &stream)
         if (stream.version == Version5_1)
         {
             // TODO - determine what these strings represent.
-            stream.readString();
-            stream.readString();
+            stream.readStringView();
+            stream.readStringView();
         }
     }
 }
@@ -1031,8 +1031,8 @@ void Track::load(InputStream &stream)
     else if (stream.version == Version5_1)
     {
         stream.skip(49);
-        stream.readString();
-        stream.readString();
+        stream.readStringView();
+        stream.readStringView();
     }
 }
 
@@ -1041,6 +1041,14 @@ Document::Document() : myStartTempo(0), myInitialKey(0), myOctave8va(false)
 }
 
 void Document::load(InputStream &stream)
+{
+    loadMetadata(stream);
+
+    for (Measure &measure : myMeasures)
+        measure.loadStaves(stream, static_cast<int>(myTracks.size()));
+}
+
+void Document::loadMetadata(InputStream &stream)
 {
     myHeader.load(stream);
     myStartTempo = stream.read<int32_t>();
@@ -1098,9 +1106,6 @@ void Document::load(InputStream &stream)
         stream.skip(2);
     else if (stream.version == Version5_1)
         stream.skip(1);
-
-    for (int i = 0; i < numMeasures; ++i)
-        myMeasures[i].loadStaves(stream, numTracks);
 }
 
 }
@@ -223,6 +223,11 @@ struct Document
     Document();
     void load(InputStream &stream);
 
+    /// Loads everything except the contents of the measures, which are stored
+    /// at the end of the file. They can then be read one measure at a time
+    /// with Measure::loadStaves().
+    void loadMetadata(InputStream &stream);
+
     Header myHeader;
     int myStartTempo;
     int myInitialKey;
@@ -18,7 +18,8 @@
 #include "guitarproimporter.h"
 
 #include <boost/date_time/gregorian/gregorian_types.hpp>
-#include <fstream>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <chrono>
 
 #include <formats/guitar_pro/document.h>
 #include <formats/guitar_pro/inputstream.h>
@@ -36,25 +37,77 @@ GuitarProImporter::GuitarProImporter()
 
 void GuitarProImporter::load(const std::string &filename, Score &score)
 {
-    std::ifstream in(filename, std::ios::binary | std::ios::in);
-    Gp::InputStream stream(in);
+    boost::iostreams::mapped_file_source file;
+    try
+    {
+        file.open(filename);
+    }
+    catch (const std::exception &)
+    {
+        throw FileFormatException("Could not open file: " + filename);
+    }
 
-    Gp::Document document;
-    document.load(stream);
+    typedef std::chrono::high_resolution_clock Clock;
+    myTimings.clear();
+    const auto start = Clock::now();
 
-    ScoreInfo info;
-    convertHeader(document.myHeader, info);
-    score.setScoreInfo(info);
+    Gp::InputStream stream(reinterpret_cast<const uint8_t *>(file.data()),
+                           file.size());
 
-    convertPlayers(document, score);
-    convertScore(document, score);
-    ScoreUtils::addStandardFilters(score);
+    myTimings.push_back(timePhase("Read", [&]() {
+        // Only load the metadata up front. The contents of each measure are
+        // converted as they are read, rather than building the entire
+        // document in memory first.
+        Gp::Document document;
+        document.loadMetadata(stream);
 
-    // Automatically set the rehearsal sign letters to "A", "B", etc.
-    ScoreUtils::adjustRehearsalSigns(score);
+        ScoreInfo info;
+        convertHeader(document.myHeader, info);
+        score.setScoreInfo(info);
+
+        convertPlayers(document, score);
+        ScoreUtils::addStandardFilters(score);
+        convertScore(document, stream, score);
+    }));
+
+    // Format the score, unless each system was already formatted when it was
+    // published.
+    if (!hasListener())
+    {
+        myTimings.push_back(
+            timePhase("Polish", [&]() { ScoreUtils::polishScore(score); }));
+    }
+
+    myTimings.push_back(
+        { "Total",
+          std::chrono::duration<double>(Clock::now() - start).count() });
+}
+
+bool GuitarProImporter::matchesSignature(const uint8_t *data,
+                                         size_t length) const
+{
+    // The file begins with a version string, such as
+    // "FICHIER GUITAR PRO v5.00".
+    try
+    {
+        Gp::InputStream stream(data, length);
+        return true;
+    }
+    catch (const FileFormatException &)
+    {
+        return false;
+    }
+}
+
+bool GuitarProImporter::readScoreInfo(const uint8_t *data, size_t length,
+                                      ScoreInfo &info) const
+{
+    Gp::InputStream stream(data, length);
+    Gp::Header header;
+    header.load(stream);
 
-    // Format the score.
-    ScoreUtils::polishScore(score);
+    convertHeader(header, info);
+    return true;
 }
 
 void GuitarProImporter::convertHeader(const Gp::Header &header, ScoreInfo &info)
@@ -291,9 +344,12 @@ void GuitarProImporter::convertIrregularGroupings(
     }
 }
 
-void GuitarProImporter::convertScore(const Gp::Document &doc, Score &score)
+void GuitarProImporter::convertScore(Gp::Document &doc,
+                                     Gp::InputStream &stream,
+                                     Score &score) const
 {
     System system;
+    std::string rehearsalLetters;
     KeySignature lastKeySig;
     TimeSignature lastTimeSig;
 
@@ -321,13 +377,17 @@ void GuitarProImporter::convertScore(const Gp::Document &doc, Score &score)
     int startPos = 0;
     for (size_t m = 0; m < doc.myMeasures.size(); ++m)
     {
-        const Gp::Measure &measure = doc.myMeasures[m];
+        checkCancelled();
+
+        Gp::Measure &measure = doc.myMeasures[m];
+        measure.loadStaves(stream, static_cast<int>(doc.myTracks.size()));
 
         // Try to create a new system every so often.
         if (startPos > POSITIONS_PER_SYSTEM)
         {
             system.getBarlines().back().setPosition(startPos + 1);
             score.insertSystem(system);
+            finishSystem(score, rehearsalLetters);
             system = System();
 
             // Add a staff for each player.
@@ -375,6 +435,9 @@ void GuitarProImporter::convertScore(const Gp::Document &doc, Score &score)
         // Check for alternate endings.
         convertAlternateEndings(measure, system, startPos);
 
+        // The notes are no longer needed.
+        measure.myStaves.clear();
+
         startPos = nextPos;
     }
 
@@ -385,6 +448,23 @@ void GuitarProImporter::convertScore(const Gp::Document &doc, Score &score)
         lastBar.setBarType(Barline::DoubleBarFine);
 
     score.insertSystem(system);
+    finishSystem(score, rehearsalLetters);
+}
+
+void GuitarProImporter::finishSystem(Score &score,
+                                     std::string &rehearsalLetters) const
+{
+    const int index = static_cast<int>(score.getSystems().size()) - 1;
+    System &system = score.getSystems()[index];
+
+    // Automatically set the rehearsal sign letters to "A", "B", etc.
+    ScoreUtils::adjustRehearsalSigns(system, rehearsalLetters);
+
+    if (hasListener())
+    {
+        ScoreUtils::polishSystem(system);
+        publishSystem(score, index);
+    }
 }
 
 int GuitarProImporter::convertBeat(const Gp::Beat &beat, System &system,
@@ -25,6 +25,7 @@ namespace Gp
     struct Beat;
     struct Document;
     struct Header;
+    class InputStream;
     struct Measure;
 }
 
@@ -42,6 +43,12 @@ public:
 
     virtual void load(const std::string &filename, Score &score) override;
 
+    virtual bool matchesSignature(const uint8_t *data,
+                                  size_t length) const override;
+
+    virtual bool readScoreInfo(const uint8_t *data, size_t length,
+                               ScoreInfo &info) const override;
+
 private:
     static void convertHeader(const Gp::Header &header, ScoreInfo &info);
     static void convertPlayers(const Gp::Document &doc, Score &score);
@@ -57,7 +64,14 @@ private:
     static void convertIrregularGroupings(const std::vector<Gp::Beat> &beats,
                                           const std::vector<int> &positions,
                                           Voice &voice);
-    static void convertScore(const Gp::Document &doc, Score &score);
+    /// Reads the contents of each measure from the stream and converts it,
+    /// one measure at a time.
+    void convertScore(Gp::Document &doc, Gp::InputStream &stream,
+                      Score &score) const;
+    /// Called once the last system of the score is complete. The rehearsal
+    /// signs are lettered, and if the system is being published it is also
+    /// formatted.
+    void finishSystem(Score &score, std::string &rehearsalLetters) const;
 };
 
 #endif
@@ -17,7 +17,10 @@
 
 #include "inputstream.h"
 
+#include <algorithm>
 #include <cassert>
+#include <istream>
+#include <iterator>
 #include <map>
 
 #include <formats/fileformat.h>
@@ -31,11 +34,24 @@ const std::map<std::string, Gp::Version> theVersionStrings = {
     { "FICHIER GUITAR PRO v5.10", Gp::Version5_1 }
 };
 
-Gp::InputStream::InputStream(std::istream &stream) : myStream(stream)
+Gp::InputStream::InputStream(const uint8_t *data, size_t length)
+    : myBegin(data), myPos(data), myEnd(data + length)
 {
-    myStream.exceptions(std::istream::failbit | std::istream::badbit |
-                       std::istream::eofbit);
+    readVersion();
+}
 
+Gp::InputStream::InputStream(std::istream &stream)
+    : myBuffer((std::istreambuf_iterator<char>(stream)),
+               std::istreambuf_iterator<char>()),
+      myBegin(myBuffer.data()),
+      myPos(myBegin),
+      myEnd(myBegin + myBuffer.size())
+{
+    readVersion();
+}
+
+void Gp::InputStream::readVersion()
+{
     const std::string versionString = readVersionString();
 
     auto it = theVersionStrings.find(versionString);
@@ -45,54 +61,70 @@ Gp::InputStream::InputStream(std::istream &stream) : myStream(stream)
         throw FileFormatException("Unsupported file version: " + versionString);
 }
 
+void Gp::InputStream::throwEndOfFile()
+{
+    throw FileFormatException("Unexpected end of file");
+}
+
 std::string Gp::InputStream::readVersionString()
 {
-    myStream.seekg(std::ios_base::beg);
+    myPos = myBegin;
 
     // THe version consists of a 30 character string, although not all 30
     // characters may be used.
-    std::string version = readCharacterString<uint8_t>();
+    const std::string version = readCharacterString<uint8_t>().to_string();
 
     // Skip past any unread characters to land at position 0x1f.
-    myStream.seekg(31, std::ios_base::beg);
+    myPos = myBegin;
+    skip(31);
 
     return version;
 }
 
 std::string Gp::InputStream::readString()
+{
+    return readStringView().to_string();
+}
+
+boost::string_ref Gp::InputStream::readStringView()
 {
     const uint32_t size = read<uint32_t>();
 
-    std::string str = readCharacterString<uint8_t>();
+    const boost::string_ref str = readCharacterString<uint8_t>();
     assert(size - 1 == str.length());
+    (void)size;
 
     return str;
 }
 
 std::string Gp::InputStream::readIntString()
 {
-    return readCharacterString<uint32_t>();
+    return readCharacterString<uint32_t>().to_string();
 }
 
 std::string Gp::InputStream::readFixedLengthString(uint32_t maxLength)
 {
-    const uint8_t actualLength = read<uint8_t>();
-
-    std::string str;
-
-    if (maxLength != 0)
-        str.resize(maxLength);
-    else
-        str.resize(actualLength);
+    return readFixedLengthStringView(maxLength).to_string();
+}
 
-    if (str.size() != 0)
-        myStream.read(&str[0], str.size());
+boost::string_ref Gp::InputStream::readFixedLengthStringView(uint32_t maxLength)
+{
+    const uint8_t actualLength = read<uint8_t>();
+    const size_t length = (maxLength != 0) ? maxLength : actualLength;
+    require(length);
 
-    str.resize(actualLength);
+    const boost::string_ref str(reinterpret_cast<const char *>(myPos),
+                                std::min<size_t>(actualLength, length));
+    myPos += length;
     return str;
 }
 
 void Gp::InputStream::skip(int numBytes)
 {
-    myStream.seekg(numBytes, std::ios_base::cur);
-}
\ No newline at end of file
+    if (numBytes < 0 && myPos - myBegin < -numBytes)
+        throwEndOfFile();
+
+    // Like seeking past the end of a std::istream, this is not an error until
+    // the next read. Some files omit the padding byte after the last staff.
+    myPos += std::min<ptrdiff_t>(numBytes, myEnd - myPos);
+}
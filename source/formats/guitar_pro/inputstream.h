@@ -19,8 +19,11 @@
 #define FORMATS_GP_STREAM_H
 
 #include <bitset>
+#include <boost/utility/string_ref.hpp>
 #include <cstdint>
-#include <istream>
+#include <cstring>
+#include <iosfwd>
+#include <type_traits>
 #include <vector>
 
 #include "document.h"
@@ -30,9 +33,15 @@ namespace Gp
 
 typedef std::bitset<8> Flags;
 
+/// Reads data from a Guitar Pro file. The file is read from a block of memory
+/// (e.g. a memory-mapped file) rather than from a std::istream, so reading a
+/// value is just a bounds check and a load.
 class InputStream
 {
 public:
+    /// Reads from a block of memory, which must outlive the stream.
+    InputStream(const uint8_t *data, size_t length);
+    /// Reads the entire contents of the stream into a buffer.
     InputStream(std::istream &stream);
 
     /// Reads simple data (e.g. uint32_t, int16_t) from the input stream.
@@ -43,6 +52,9 @@ public:
     /// representing the size of the stored information + 1, followed by the
     /// length-prefixed string of characters representing the data
     std::string readString();
+    /// Same as readString(), but returns a reference to the input data
+    /// rather than making a copy.
+    boost::string_ref readStringView();
 
     /// Reads a string prefixed with 4 bytes that indicate the length.
     std::string readIntString();
@@ -50,6 +62,9 @@ public:
     /// Reads a fixed length string (any unused characters trailing the string
     /// are skipped).
     std::string readFixedLengthString(uint32_t maxLength);
+    /// Same as readFixedLengthString(), but returns a reference to the input
+    /// data rather than making a copy.
+    boost::string_ref readFixedLengthStringView(uint32_t maxLength);
 
     std::string readVersionString();
 
@@ -62,42 +77,89 @@ public:
     }
 
 private:
+    void readVersion();
+
+    /// Throws an exception if there are fewer than numBytes remaining.
+    void require(size_t numBytes) const
+    {
+        if (static_cast<size_t>(myEnd - myPos) < numBytes)
+            throwEndOfFile();
+    }
+
+    static void throwEndOfFile();
+
     /// Reads a character string.
     /// The string consists of some number of bytes (encoding the length of the
     /// string, n) followed by n characters.  This is templated on the length
     /// prefix type, to allow for strings prefixed with a 2-byte length value,
     /// 4-byte length value, etc
     template <class LengthPrefixType>
-    std::string readCharacterString();
+    boost::string_ref readCharacterString();
 
-    std::istream &myStream;
+    /// Storage for the data, if it was read from a std::istream.
+    std::vector<uint8_t> myBuffer;
+    const uint8_t *myBegin;
+    const uint8_t *myPos;
+    const uint8_t *myEnd;
 };
 
+namespace Detail
+{
+/// Loads a little-endian integer.
+template <class T>
+inline T load(const uint8_t *data, std::true_type /* is_integral */)
+{
+    typedef typename std::make_unsigned<T>::type UnsignedT;
+
+    UnsignedT value = 0;
+    for (size_t i = 0; i < sizeof(T); ++i)
+        value |= static_cast<UnsignedT>(static_cast<UnsignedT>(data[i])
+                                        << (8 * i));
+
+    return static_cast<T>(value);
+}
+
+/// Loads a floating point number.
+template <class T>
+inline T load(const uint8_t *data, std::false_type /* is_integral */)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+}
+
 template <class T>
 inline T InputStream::read()
 {
     static_assert(std::is_arithmetic<T>::value, "T must be an arithmetic type");
-    T data;
-    myStream.read((char *)&data, sizeof(data));
+    require(sizeof(T));
+
+    const T data = Detail::load<T>(
+        myPos, std::integral_constant<bool, std::is_integral<T>::value>());
+    myPos += sizeof(T);
     return data;
 }
 
+template <>
+inline bool InputStream::read<bool>()
+{
+    return read<uint8_t>() != 0;
+}
+
 template <typename LengthPrefixType>
-inline std::string InputStream::readCharacterString()
+inline boost::string_ref InputStream::readCharacterString()
 {
     static_assert(std::is_integral<LengthPrefixType>::value,
                   "LengthPrefixType must be an integral type");
 
-    const LengthPrefixType length = read<LengthPrefixType>();
-
-    std::string str;
-    str.resize(length);
-
-    if (length != 0)
-        myStream.read(&str[0], length);
+    const size_t length = read<LengthPrefixType>();
+    require(length);
 
+    const boost::string_ref str(reinterpret_cast<const char *>(myPos), length);
+    myPos += length;
     return str;
 }
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -17,66 +17,31 @@
 
 #include "midiexporter.h"
 
-#include <app/settingsmanager.h>
-#include <audio/settings.h>
 #include <midi/midifile.h>
+#include <midi/settings.h>
 #include <score/generalmidi.h>
+#include <util/parallel.h>
+#include <util/settingsmanager.h>
 
-#include <array>
 #include <cstdint>
 #include <fstream>
+#include <future>
 
-// For htonl.
-#ifdef _WIN32
-#include <WinSock2.h>
-#else
-#include <arpa/inet.h>
-#endif
-
-static uint32_t toBigEndian(uint32_t val)
-{
-    return htonl(val);
-}
-
-static uint16_t toBigEndian(uint16_t val)
-{
-    return htons(val);
-}
-
-static uint8_t toBigEndian(uint8_t val)
-{
-    return val;
-}
-
+/// Appends a value in big-endian byte order.
 template <typename T>
-static void write(std::ostream &os, T val)
+static void write(std::vector<uint8_t> &buffer, T val)
 {
-    val = toBigEndian(val);
-    os.write(reinterpret_cast<const char *>(&val), sizeof(T));
+    for (int i = sizeof(T) - 1; i >= 0; --i)
+        buffer.push_back(static_cast<uint8_t>(val >> (8 * i)));
 }
 
-static void writeVariableLength(std::ostream &os, uint32_t val)
+/// Overwrites a big-endian 32-bit value at the given offset.
+static void writeAt(std::vector<uint8_t> &buffer, size_t offset, uint32_t val)
 {
-    std::array<uint8_t, 5> bytes;
-    for (int i = 0; i < 5; ++i)
-        bytes[i] = (val >> ((4 - i) * 7)) & 0x7f;
-
-    // Find the first byte that needs to be written.
-    int i = 0;
-    for (i = 0; i < 4; ++i)
-    {
-        if (bytes[i] != 0)
-            break;
-    }
-
-    for (; i < 5; ++i)
-    {
-        // Set the top bit to indicate that more bytes will follow it.
-        if (i < 4)
-            bytes[i] |= 0x80;
-
-        write(os, bytes[i]);
-    }
+    buffer[offset] = static_cast<uint8_t>(val >> 24);
+    buffer[offset + 1] = static_cast<uint8_t>(val >> 16);
+    buffer[offset + 2] = static_cast<uint8_t>(val >> 8);
+    buffer[offset + 3] = static_cast<uint8_t>(val);
 }
 
 MidiExporter::MidiExporter(const SettingsManager &settings_manager)
@@ -87,9 +52,6 @@ MidiExporter::MidiExporter(const SettingsManager &settings_manager)
 
 void MidiExporter::save(const std::string &filename, const Score &score)
 {
-    std::ofstream os(filename, std::ios::out | std::ios::binary);
-    os.exceptions(std::ios::failbit | std::ios::badbit | std::ios::eofbit);
-
     MidiFile::LoadOptions options;
     options.myEnableMetronome = false;
     options.myRecordPositionChanges = false;
@@ -103,54 +65,97 @@ void MidiExporter::save(const std::string &filename, const Score &score)
         options.myVibratoStrength = settings->get(Settings::MidiVibratoLevel);
         options.myWideVibratoStrength =
             settings->get(Settings::MidiWideVibratoLevel);
+        options.myMaxBendError = settings->get(Settings::MidiBendTolerance);
     }
 
     MidiFile file;
     file.load(score, options);
-    writeHeader(os, file);
 
+    std::vector<std::vector<uint8_t>> buffers;
+    buffers.emplace_back();
+    writeHeader(buffers.back(), file);
+
+    // The tracks are independent, so encode them in parallel.
+    std::vector<std::future<std::vector<uint8_t>>> tasks;
     for (const MidiEventList &track : file.getTracks())
-        writeTrack(os, track);
+    {
+        tasks.push_back(std::async(Util::launchPolicy(), [&track]() {
+            std::vector<uint8_t> buffer;
+            writeTrack(buffer, track);
+            return buffer;
+        }));
+    }
+
+    for (auto &&task : tasks)
+        buffers.push_back(task.get());
+
+    std::ofstream os(filename, std::ios::out | std::ios::binary);
+    os.exceptions(std::ios::failbit | std::ios::badbit | std::ios::eofbit);
+
+    for (const std::vector<uint8_t> &buffer : buffers)
+    {
+        os.write(reinterpret_cast<const char *>(buffer.data()),
+                 buffer.size());
+    }
 }
 
-void MidiExporter::writeHeader(std::ostream &os, const MidiFile &file)
+void MidiExporter::writeVariableLength(std::vector<uint8_t> &buffer,
+                                       uint32_t val)
+{
+    // Figure out how many 7-bit groups are needed, and then write out the
+    // groups from most to least significant. The top bit is set to indicate
+    // that more bytes will follow.
+    const int num_bytes = 1 + (val >= (1u << 7)) + (val >= (1u << 14)) +
+                          (val >= (1u << 21)) + (val >= (1u << 28));
+
+    for (int i = num_bytes - 1; i > 0; --i)
+        buffer.push_back(0x80 | ((val >> (7 * i)) & 0x7f));
+
+    buffer.push_back(val & 0x7f);
+}
+
+void MidiExporter::writeHeader(std::vector<uint8_t> &buffer,
+                               const MidiFile &file)
 {
     // Chunk ID for the header chunk.
-    os << "MThd";
+    const char chunk_id[] = "MThd";
+    buffer.insert(buffer.end(), chunk_id, chunk_id + 4);
     // 6 bytes will follow the chunk size.
-    write(os, static_cast<uint32_t>(6));
+    write(buffer, static_cast<uint32_t>(6));
 
     // A format type of 1 indicates that we'll have multiple tracks.
-    write(os, static_cast<uint16_t>(1));
-    write(os, static_cast<uint16_t>(file.getTracks().size()));
+    write(buffer, static_cast<uint16_t>(1));
+    write(buffer, static_cast<uint16_t>(file.getTracks().size()));
 
     // Time division.
-    write(os, static_cast<uint16_t>(file.getTicksPerBeat()));
+    write(buffer, static_cast<uint16_t>(file.getTicksPerBeat()));
 }
 
-void MidiExporter::writeTrack(std::ostream & os, const MidiEventList & events)
+void MidiExporter::writeTrack(std::vector<uint8_t> &buffer,
+                              const MidiEventList &events)
 {
+    // Most events are a short delta time followed by a 3 byte message.
+    buffer.reserve(buffer.size() + 8 + events.size() * 4);
+
     // Chunk ID for a track chunk.
-    os << "MTrk";
+    const char chunk_id[] = "MTrk";
+    buffer.insert(buffer.end(), chunk_id, chunk_id + 4);
 
     // Size in bytes of the track chunk. This will be updated after writing out
     // all of the data.
-    const std::iostream::pos_type chunk_len_pos = os.tellp();
-    write(os, static_cast<uint32_t>(0));
+    const size_t chunk_len_pos = buffer.size();
+    write(buffer, static_cast<uint32_t>(0));
 
     // Write out the MIDI events.
-    const std::iostream::pos_type chunk_start_pos = os.tellp();
+    const size_t chunk_start_pos = buffer.size();
     for (const MidiEvent &event : events)
     {
-        writeVariableLength(os, event.getTicks());
-        os.write(reinterpret_cast<const char *>(event.getData().data()),
-                 event.getData().size());
+        writeVariableLength(buffer, event.getTicks());
+        buffer.insert(buffer.end(), event.getData().begin(),
+                      event.getData().end());
     }
 
-    const std::iostream::pos_type chunk_end_pos = os.tellp();
-
     // Record the size in bytes of the track chunk.
-    os.seekp(chunk_len_pos);
-    write(os, static_cast<uint32_t>(chunk_end_pos - chunk_start_pos));
-    os.seekp(chunk_end_pos);
+    writeAt(buffer, chunk_len_pos,
+            static_cast<uint32_t>(buffer.size() - chunk_start_pos));
 }
@@ -18,7 +18,9 @@
 #ifndef FORMATS_MIDIEXPORTER_H
 #define FORMATS_MIDIEXPORTER_H
 
+#include <cstdint>
 #include <formats/fileformatmanager.h>
+#include <vector>
 
 class MidiEventList;
 class MidiFile;
@@ -30,9 +32,17 @@ public:
 
     virtual void save(const std::string &filename, const Score &score) override;
 
+    /// Appends a variable-length quantity (up to 0x0FFFFFFF).
+    static void writeVariableLength(std::vector<uint8_t> &buffer,
+                                    uint32_t val);
+
+    /// Appends a track chunk containing the events, whose ticks are
+    /// expected to be delta times.
+    static void writeTrack(std::vector<uint8_t> &buffer,
+                           const MidiEventList &events);
+
 private:
-    static void writeHeader(std::ostream &os, const MidiFile &file);
-    static void writeTrack(std::ostream &os, const MidiEventList &events);
+    static void writeHeader(std::vector<uint8_t> &buffer, const MidiFile &file);
 
     const SettingsManager &mySettingsManager;
 };
@@ -0,0 +1,792 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "midiimporter.h"
+
+#include <algorithm>
+#include <array>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <cstring>
+#include <deque>
+#include <midi/midieventlist.h>
+#include <score/generalmidi.h>
+#include <score/score.h>
+#include <score/utils/scorepolisher.h>
+
+static const int POSITIONS_PER_SYSTEM = 35;
+static const int PERCUSSION_CHANNEL = 9;
+/// Notes are quantized to sixteenth notes.
+static const int UNITS_PER_QUARTER = 4;
+
+namespace
+{
+/// Reads big-endian integers and variable-length quantities from a block of
+/// memory, with bounds checking.
+class ByteReader
+{
+public:
+    ByteReader(const uint8_t *begin, const uint8_t *end)
+        : myPos(begin), myEnd(end)
+    {
+    }
+
+    bool atEnd() const { return myPos >= myEnd; }
+    const uint8_t *getPosition() const { return myPos; }
+
+    void require(size_t num_bytes) const
+    {
+        if (static_cast<size_t>(myEnd - myPos) < num_bytes)
+            throw FileFormatException("Unexpected end of file");
+    }
+
+    uint8_t peek() const
+    {
+        require(1);
+        return *myPos;
+    }
+
+    uint8_t readByte()
+    {
+        require(1);
+        return *myPos++;
+    }
+
+    uint32_t readInt(int num_bytes)
+    {
+        require(num_bytes);
+
+        uint32_t val = 0;
+        for (int i = 0; i < num_bytes; ++i)
+            val = (val << 8) | *myPos++;
+        return val;
+    }
+
+    /// Reads a data byte of a channel message, which must not have the top
+    /// bit set.
+    uint8_t readDataByte()
+    {
+        const uint8_t byte = readByte();
+        if (byte & 0x80)
+            throw FileFormatException("Invalid data byte");
+        return byte;
+    }
+
+    uint32_t readVarLen()
+    {
+        uint32_t val = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            const uint8_t byte = readByte();
+            val = (val << 7) | (byte & 0x7f);
+            if (!(byte & 0x80))
+                return val;
+        }
+
+        throw FileFormatException("Invalid variable-length quantity");
+    }
+
+    void skip(size_t num_bytes)
+    {
+        require(num_bytes);
+        myPos += num_bytes;
+    }
+
+private:
+    const uint8_t *myPos;
+    const uint8_t *myEnd;
+};
+
+/// The events from the file that are needed to build the score. Any other
+/// events (controllers, pitch wheel, SysEx, etc) are discarded while parsing,
+/// so memory usage grows with the number of notes rather than with the size
+/// of the file.
+struct MidiData
+{
+    MidiData() : myTicksPerQuarter(0), myNumEvents(0) {}
+
+    int myTicksPerQuarter;
+    /// Tempo and time signature changes from all tracks.
+    MidiEventList myConductorTrack;
+    /// Note and program change events, with a separate list for each
+    /// channel of each track.
+    std::vector<MidiEventList> myTracks;
+    std::vector<std::string> myTrackNames;
+    size_t myNumEvents;
+};
+
+/// A chord (or a rest, if there are no notes) between two grid positions.
+struct Beat
+{
+    Beat(int start, int end) : myStart(start), myEnd(end) {}
+
+    int myStart;
+    int myEnd;
+    std::vector<Note> myNotes;
+};
+
+struct Bar
+{
+    int myStart;
+    int myEnd;
+    int myBeatsPerMeasure;
+    int myBeatValue;
+    int myTempo;
+};
+
+struct DurationInfo
+{
+    int myLength;
+    Position::DurationType myType;
+    bool myDotted;
+};
+
+/// The durations that are used when splitting up a beat, from longest to
+/// shortest (in sixteenth notes).
+const DurationInfo theDurations[] = {
+    { 16, Position::WholeNote, false },  { 12, Position::HalfNote, true },
+    { 8, Position::HalfNote, false },    { 6, Position::QuarterNote, true },
+    { 4, Position::QuarterNote, false }, { 3, Position::EighthNote, true },
+    { 2, Position::EighthNote, false },  { 1, Position::SixteenthNote, false }
+};
+}
+
+static void parseTrack(ByteReader &reader, MidiData &data)
+{
+    // Each channel that is used in the track is imported as a separate
+    // player.
+    std::array<int, Midi::NUM_MIDI_CHANNELS_PER_PORT> lists;
+    lists.fill(-1);
+    const size_t first_list = data.myTracks.size();
+
+    std::string name;
+    int ticks = 0;
+    uint8_t running_status = 0;
+
+    while (!reader.atEnd())
+    {
+        ticks += reader.readVarLen();
+        ++data.myNumEvents;
+
+        uint8_t status = reader.peek();
+        if (status & 0x80)
+            reader.skip(1);
+        else if (running_status)
+            status = running_status;
+        else
+            throw FileFormatException("Invalid running status");
+
+        if (status == MidiEvent::MetaMessage)
+        {
+            const uint8_t type = reader.readByte();
+            const uint32_t length = reader.readVarLen();
+            reader.require(length);
+            const uint8_t *payload = reader.getPosition();
+
+            if (type == 0x51 && length == 3)
+            {
+                data.myConductorTrack.append(MidiEvent::setTempo(
+                    ticks, (payload[0] << 16) | (payload[1] << 8) | payload[2]));
+            }
+            else if (type == 0x58 && length >= 2 && payload[1] < 8)
+            {
+                data.myConductorTrack.append(MidiEvent::timeSignature(
+                    ticks, payload[0], static_cast<uint8_t>(1 << payload[1])));
+            }
+            else if (type == 0x03 && name.empty())
+                name.assign(reinterpret_cast<const char *>(payload), length);
+
+            reader.skip(length);
+            running_status = 0;
+
+            if (type == 0x2f)
+                break;
+        }
+        else if (status == MidiEvent::SysEx || status == 0xf7)
+        {
+            reader.skip(reader.readVarLen());
+            running_status = 0;
+        }
+        else if (status > MidiEvent::SysEx)
+            throw FileFormatException("Invalid status byte");
+        else
+        {
+            running_status = status;
+
+            const uint8_t type = status & 0xf0;
+            const uint8_t channel = status & 0x0f;
+            const uint8_t data1 = reader.readDataByte();
+            // Program change and channel pressure messages only have one
+            // data byte.
+            const uint8_t data2 =
+                (type == MidiEvent::ProgramChange || type == 0xd0)
+                    ? 0
+                    : reader.readDataByte();
+
+            // Percussion can't be represented on a staff.
+            if (channel == PERCUSSION_CHANNEL ||
+                (type != MidiEvent::NoteOn && type != MidiEvent::NoteOff &&
+                 type != MidiEvent::ProgramChange))
+            {
+                continue;
+            }
+
+            int &index = lists[channel];
+            if (index < 0)
+            {
+                index = static_cast<int>(data.myTracks.size());
+                data.myTracks.emplace_back();
+            }
+
+            MidiEventList &list = data.myTracks[index];
+            if (type == MidiEvent::NoteOn)
+            {
+                list.append(MidiEvent::noteOn(ticks, channel, data1, data2,
+                                              SystemLocation()));
+            }
+            else if (type == MidiEvent::NoteOff)
+            {
+                list.append(
+                    MidiEvent::noteOff(ticks, channel, data1, SystemLocation()));
+            }
+            else
+                list.append(MidiEvent::programChange(ticks, channel, data1));
+        }
+    }
+
+    data.myTrackNames.resize(data.myTracks.size());
+    for (size_t i = first_list; i < data.myTracks.size(); ++i)
+        data.myTrackNames[i] = name;
+}
+
+static void parseFile(const uint8_t *begin, size_t length, MidiData &data)
+{
+    ByteReader reader(begin, begin + length);
+
+    reader.require(8);
+    if (std::memcmp(reader.getPosition(), "MThd", 4) != 0)
+        throw FileFormatException("Invalid header");
+    reader.skip(4);
+
+    const uint32_t header_length = reader.readInt(4);
+    if (header_length < 6)
+        throw FileFormatException("Invalid header");
+
+    const int format = reader.readInt(2);
+    const int num_tracks = reader.readInt(2);
+    const int division = reader.readInt(2);
+    reader.skip(header_length - 6);
+
+    if (format > 1)
+    {
+        throw FileFormatException("Unsupported MIDI file type: " +
+                                  std::to_string(format));
+    }
+
+    if (division == 0 || (division & 0x8000))
+        throw FileFormatException("SMPTE time division is not supported");
+    data.myTicksPerQuarter = division;
+
+    int track = 0;
+    while (track < num_tracks && !reader.atEnd())
+    {
+        reader.require(8);
+        const bool is_track =
+            std::memcmp(reader.getPosition(), "MTrk", 4) == 0;
+        reader.skip(4);
+
+        // Unknown chunk types must be ignored.
+        const uint32_t chunk_length = reader.readInt(4);
+        reader.require(chunk_length);
+        if (is_track)
+        {
+            ByteReader chunk(reader.getPosition(),
+                             reader.getPosition() + chunk_length);
+            parseTrack(chunk, data);
+            ++track;
+        }
+
+        reader.skip(chunk_length);
+    }
+
+    // Tempo changes may appear in any track.
+    std::stable_sort(data.myConductorTrack.begin(),
+                     data.myConductorTrack.end());
+}
+
+/// Converts from ticks to sixteenth notes.
+static int quantize(int ticks, int ticks_per_quarter)
+{
+    return static_cast<int>(
+        (static_cast<int64_t>(ticks) * UNITS_PER_QUARTER +
+         ticks_per_quarter / 2) /
+        ticks_per_quarter);
+}
+
+/// Chooses a string and fret for each pitch in a chord, preferring the lowest
+/// fret for the highest pitches. Pitches that can't be played are dropped.
+static std::vector<Note> findFrets(std::vector<uint8_t> pitches,
+                                   const Tuning &tuning)
+{
+    std::sort(pitches.begin(), pitches.end(), std::greater<uint8_t>());
+    pitches.erase(std::unique(pitches.begin(), pitches.end()), pitches.end());
+
+    std::vector<Note> notes;
+    std::vector<bool> used_strings(tuning.getStringCount(), false);
+
+    for (uint8_t pitch : pitches)
+    {
+        int best_string = -1;
+        int best_fret = Note::MAX_FRET_NUMBER + 1;
+
+        for (int string = 0; string < tuning.getStringCount(); ++string)
+        {
+            const int fret = pitch - tuning.getNote(string, false);
+            if (!used_strings[string] && fret >= Note::MIN_FRET_NUMBER &&
+                fret < best_fret)
+            {
+                best_string = string;
+                best_fret = fret;
+            }
+        }
+
+        if (best_string >= 0)
+        {
+            used_strings[best_string] = true;
+            notes.emplace_back(best_string, best_fret);
+        }
+    }
+
+    return notes;
+}
+
+/// Matches up the note on / note off events for a player and groups them into
+/// a contiguous sequence of chords and rests, in sixteenth notes.
+static std::vector<Beat> convertNotes(const MidiEventList &events,
+                                      int ticks_per_quarter,
+                                      const Tuning &tuning)
+{
+    struct QuantizedNote
+    {
+        int myStart;
+        int myEnd;
+        uint8_t myPitch;
+    };
+
+    std::vector<QuantizedNote> notes;
+    std::array<std::deque<size_t>, Midi::NUM_MIDI_NOTES> active_notes;
+    int last_tick = 0;
+
+    for (const MidiEvent &event : events)
+    {
+        if (!event.isNoteOnOff())
+            continue;
+
+        const uint8_t pitch = event.getPitch() & 0x7f;
+        const int tick = quantize(event.getTicks(), ticks_per_quarter);
+        last_tick = std::max(last_tick, tick);
+
+        if (event.isNoteOn())
+        {
+            active_notes[pitch].push_back(notes.size());
+            notes.push_back({ tick, tick + 1, pitch });
+        }
+        else if (!active_notes[pitch].empty())
+        {
+            QuantizedNote &note = notes[active_notes[pitch].front()];
+            note.myEnd = std::max(note.myStart + 1, tick);
+            active_notes[pitch].pop_front();
+        }
+    }
+
+    // Notes that were never stopped last until the end of the track.
+    for (const std::deque<size_t> &indices : active_notes)
+    {
+        for (size_t i : indices)
+            notes[i].myEnd = std::max(notes[i].myEnd, last_tick);
+    }
+
+    std::stable_sort(notes.begin(), notes.end(),
+                     [](const QuantizedNote &a, const QuantizedNote &b) {
+                         return a.myStart < b.myStart;
+                     });
+
+    std::vector<Beat> beats;
+    int current_time = 0;
+    size_t i = 0;
+    while (i < notes.size())
+    {
+        const int start = notes[i].myStart;
+        int end = start;
+        std::vector<uint8_t> pitches;
+
+        for (; i < notes.size() && notes[i].myStart == start; ++i)
+        {
+            pitches.push_back(notes[i].myPitch);
+            end = std::max(end, notes[i].myEnd);
+        }
+
+        // Notes are cut off by the next chord.
+        if (i < notes.size())
+            end = std::min(end, notes[i].myStart);
+
+        if (start > current_time)
+            beats.emplace_back(current_time, start);
+
+        beats.emplace_back(start, end);
+        beats.back().myNotes = findFrets(pitches, tuning);
+        current_time = end;
+    }
+
+    return beats;
+}
+
+/// Lays out the bars according to the time signature and tempo changes.
+static std::vector<Bar> convertBars(const MidiData &data, int end)
+{
+    std::vector<Bar> bars;
+    int beats_per_measure = 4;
+    int beat_value = 4;
+    int tempo = TempoMarker::DEFAULT_BEATS_PER_MINUTE;
+    int start = 0;
+
+    // Time signature and tempo changes are applied at different points, so
+    // each needs its own position in the conductor track.
+    auto time_signature = data.myConductorTrack.begin();
+    auto tempo_change = data.myConductorTrack.begin();
+    const auto events_end = data.myConductorTrack.end();
+
+    do
+    {
+        Bar bar;
+        bar.myStart = start;
+
+        // Time signature changes take effect at the next barline.
+        for (; time_signature != events_end &&
+               quantize(time_signature->getTicks(), data.myTicksPerQuarter) <=
+                   start;
+             ++time_signature)
+        {
+            const MidiEvent &e = *time_signature;
+            if (e.isTimeSignature() &&
+                e.getBeatsPerMeasure() >= TimeSignature::MIN_BEATS_PER_MEASURE &&
+                e.getBeatsPerMeasure() <= TimeSignature::MAX_BEATS_PER_MEASURE &&
+                TimeSignature::isValidBeatValue(e.getBeatValue()))
+            {
+                beats_per_measure = e.getBeatsPerMeasure();
+                beat_value = e.getBeatValue();
+            }
+        }
+
+        bar.myBeatsPerMeasure = beats_per_measure;
+        bar.myBeatValue = beat_value;
+        bar.myEnd =
+            start + std::max(1, beats_per_measure * UNITS_PER_QUARTER * 4 /
+                                    beat_value);
+
+        // Tempo changes are moved to the start of the bar.
+        for (; tempo_change != events_end &&
+               quantize(tempo_change->getTicks(), data.myTicksPerQuarter) <
+                   bar.myEnd;
+             ++tempo_change)
+        {
+            const MidiEvent &e = *tempo_change;
+            if (e.isTempoChange() && e.getTempo() > 0)
+            {
+                tempo = std::max(
+                    TempoMarker::MIN_BEATS_PER_MINUTE,
+                    std::min(TempoMarker::MAX_BEATS_PER_MINUTE,
+                             (60000000 + e.getTempo() / 2) / e.getTempo()));
+            }
+        }
+        bar.myTempo = tempo;
+
+        bars.push_back(bar);
+        start = bar.myEnd;
+    } while (start < end);
+
+    return bars;
+}
+
+static void convertPlayers(const MidiData &data, Score &score,
+                           std::vector<const MidiEventList *> &tracks)
+{
+    for (size_t i = 0; i < data.myTracks.size(); ++i)
+    {
+        const MidiEventList &events = data.myTracks[i];
+        if (std::none_of(events.begin(), events.end(),
+                         [](const MidiEvent &e) { return e.isNoteOn(); }))
+        {
+            continue;
+        }
+
+        Player player;
+        Instrument instrument;
+        Tuning tuning;
+
+        std::string name = data.myTrackNames[i];
+        if (name.empty())
+            name = "Track " + std::to_string(tracks.size() + 1);
+        player.setDescription(name);
+        instrument.setDescription(name);
+
+        auto program = std::find_if(
+            events.begin(), events.end(),
+            [](const MidiEvent &e) { return e.isProgramChange(); });
+        if (program != events.end())
+        {
+            const uint8_t preset = program->getPreset();
+            instrument.setMidiPreset(preset);
+
+            if (preset >= Midi::MIDI_PRESET_ACOUSTIC_BASS &&
+                preset <= Midi::MIDI_PRESET_SYNTH_BASS2)
+            {
+                tuning.setName("Bass - Standard");
+                tuning.setNotes({ Midi::MIDI_NOTE_G2, Midi::MIDI_NOTE_D2,
+                                  Midi::MIDI_NOTE_A1, Midi::MIDI_NOTE_E1 });
+            }
+        }
+
+        player.setTuning(tuning);
+        score.insertPlayer(player);
+        score.insertInstrument(instrument);
+        tracks.push_back(&events);
+    }
+
+    if (tracks.empty())
+        throw FileFormatException("The file does not contain any notes");
+}
+
+/// Inserts positions for the given notes, splitting the duration into
+/// tied notes if necessary.
+static int insertPositions(Voice &voice, int position, int length,
+                           const std::vector<Note> &notes, bool tied)
+{
+    while (length > 0)
+    {
+        const DurationInfo &duration =
+            *std::find_if(std::begin(theDurations), std::end(theDurations),
+                          [=](const DurationInfo &d) {
+                              return d.myLength <= length;
+                          });
+
+        Position pos(position++, duration.myType);
+        if (duration.myDotted)
+            pos.setProperty(Position::Dotted);
+
+        if (notes.empty())
+            pos.setRest();
+
+        for (Note note : notes)
+        {
+            if (tied)
+                note.setProperty(Note::Tied);
+            pos.insertNote(note);
+        }
+
+        voice.insertPosition(pos);
+        length -= duration.myLength;
+        tied = true;
+    }
+
+    return position;
+}
+
+static void convertScore(const MidiData &data, Score &score)
+{
+    std::vector<const MidiEventList *> tracks;
+    convertPlayers(data, score, tracks);
+
+    std::vector<std::vector<Beat>> beats;
+    int end = 0;
+    for (size_t i = 0; i < tracks.size(); ++i)
+    {
+        beats.push_back(convertNotes(*tracks[i], data.myTicksPerQuarter,
+                                     score.getPlayers()[i].getTuning()));
+        if (!beats.back().empty())
+            end = std::max(end, beats.back().back().myEnd);
+    }
+
+    const std::vector<Bar> bars = convertBars(data, end);
+
+    System system;
+    TimeSignature lastTimeSig;
+
+    // Add a staff for each player.
+    for (const Player &player : score.getPlayers())
+        system.insertStaff(Staff(player.getTuning().getStringCount()));
+
+    // Add initial tempo marker.
+    {
+        TempoMarker marker;
+        marker.setPosition(0);
+        marker.setBeatsPerMinute(bars.front().myTempo);
+        system.insertTempoMarker(marker);
+    }
+
+    // Add an initial player change.
+    {
+        PlayerChange change;
+        for (unsigned int i = 0; i < score.getPlayers().size(); ++i)
+            change.insertActivePlayer(i, ActivePlayer(i, i));
+        system.insertPlayerChange(change);
+    }
+
+    std::vector<size_t> beat_indices(tracks.size(), 0);
+    int startPos = 0;
+    for (size_t b = 0; b < bars.size(); ++b)
+    {
+        const Bar &bar = bars[b];
+
+        // Try to create a new system every so often.
+        if (startPos > POSITIONS_PER_SYSTEM)
+        {
+            system.getBarlines().back().setPosition(startPos + 1);
+            score.insertSystem(system);
+            system = System();
+
+            // Add a staff for each player.
+            for (const Player &player : score.getPlayers())
+                system.insertStaff(Staff(player.getTuning().getStringCount()));
+
+            startPos = 0;
+        }
+
+        // For each player, import the notes from the current bar.
+        const int firstPos = (startPos != 0) ? startPos + 1 : 0;
+        int nextPos = startPos;
+        for (size_t i = 0; i < tracks.size(); ++i)
+        {
+            Voice &voice = system.getStaves()[i].getVoices()[0];
+            const std::vector<Beat> &player_beats = beats[i];
+            size_t &index = beat_indices[i];
+
+            int currentPos = firstPos;
+            int time = bar.myStart;
+            while (time < bar.myEnd)
+            {
+                while (index < player_beats.size() &&
+                       player_beats[index].myEnd <= time)
+                {
+                    ++index;
+                }
+
+                if (index < player_beats.size())
+                {
+                    const Beat &beat = player_beats[index];
+                    const int beat_end = std::min(beat.myEnd, bar.myEnd);
+                    currentPos =
+                        insertPositions(voice, currentPos, beat_end - time,
+                                        beat.myNotes, beat.myStart < time);
+                    time = beat_end;
+                }
+                else
+                {
+                    currentPos = insertPositions(voice, currentPos,
+                                                 bar.myEnd - time, {}, false);
+                    time = bar.myEnd;
+                }
+            }
+
+            nextPos = std::max(nextPos, currentPos);
+        }
+
+        Barline barline;
+        barline.setPosition(startPos);
+
+        if (b == 0 || bar.myBeatsPerMeasure != bars[b - 1].myBeatsPerMeasure ||
+            bar.myBeatValue != bars[b - 1].myBeatValue)
+        {
+            TimeSignature time;
+            time.setVisible(true);
+            time.setBeatsPerMeasure(bar.myBeatsPerMeasure);
+            time.setNumPulses(bar.myBeatsPerMeasure);
+            time.setBeatValue(bar.myBeatValue);
+            barline.setTimeSignature(time);
+
+            // Future copies of this time signature should not be shown.
+            time.setVisible(false);
+            lastTimeSig = time;
+        }
+        else
+            barline.setTimeSignature(lastTimeSig);
+
+        if (startPos == 0)
+            system.getBarlines().front() = barline;
+        else
+            system.insertBarline(barline);
+
+        if (b > 0 && bar.myTempo != bars[b - 1].myTempo)
+        {
+            TempoMarker marker(firstPos);
+            marker.setBeatsPerMinute(bar.myTempo);
+            system.insertTempoMarker(marker);
+        }
+
+        startPos = nextPos;
+    }
+
+    // Insert the final system.
+    Barline &lastBar = system.getBarlines().back();
+    lastBar.setPosition(startPos + 1);
+    lastBar.setBarType(Barline::DoubleBarFine);
+
+    score.insertSystem(system);
+}
+
+MidiImporter::MidiImporter()
+    : FileFormatImporter(FileFormat("MIDI File", { "mid", "midi" }))
+{
+}
+
+void MidiImporter::load(const std::string &filename, Score &score)
+{
+    boost::iostreams::mapped_file_source file;
+    try
+    {
+        file.open(filename);
+    }
+    catch (const std::exception &)
+    {
+        throw FileFormatException("Could not open file: " + filename);
+    }
+
+    load(reinterpret_cast<const uint8_t *>(file.data()), file.size(), score);
+}
+
+void MidiImporter::load(const uint8_t *data, size_t length, Score &score)
+{
+    myTimings.clear();
+
+    MidiData midi_data;
+    myTimings.push_back(
+        timePhase("Parse", [&]() { parseFile(data, length, midi_data); }));
+    myTimings.back().count = midi_data.myNumEvents;
+
+    myTimings.push_back(timePhase("Convert", [&]() {
+        convertScore(midi_data, score);
+        ScoreUtils::addStandardFilters(score);
+    }));
+
+    // Format the score.
+    myTimings.push_back(
+        timePhase("Polish", [&]() { ScoreUtils::polishScore(score); }));
+}
+
+bool MidiImporter::matchesSignature(const uint8_t *data, size_t length) const
+{
+    return length >= 4 && std::memcmp(data, "MThd", 4) == 0;
+}
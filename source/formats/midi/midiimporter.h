@@ -0,0 +1,48 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FORMATS_MIDIIMPORTER_H
+#define FORMATS_MIDIIMPORTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <formats/fileformat.h>
+#include <string>
+#include <vector>
+
+class MidiEventList;
+
+/// Imports Standard MIDI Files (type 0 and type 1).
+/// The file is parsed in a single pass over a memory-mapped view, keeping
+/// only the events that are needed to build the score, and the notes are
+/// then quantized to sixteenth notes.
+class MidiImporter : public FileFormatImporter
+{
+public:
+    MidiImporter();
+
+    virtual void load(const std::string &filename, Score &score) override;
+
+    virtual bool matchesSignature(const uint8_t *data,
+                                  size_t length) const override;
+
+    /// Imports a file that has already been loaded into memory.
+    /// @throw FileFormatException
+    void load(const uint8_t *data, size_t length, Score &score);
+};
+
+#endif
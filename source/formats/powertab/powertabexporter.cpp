@@ -18,25 +18,73 @@
 #include "powertabexporter.h"
 
 #include "common.h"
+#include <algorithm>
 #include <boost/iostreams/filtering_streambuf.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
+#include <formats/settings.h>
 #include <fstream>
+#include <score/binaryserialization.h>
 #include <score/score.h>
 #include <score/serialization.h>
+#include <stdexcept>
+#include <util/settingsmanager.h>
+#include <util/threadedstreambuf.h>
 
-PowerTabExporter::PowerTabExporter()
-    : FileFormatExporter(getPowerTabFileFormat())
+/// Smallest buffer size that is used for compression, regardless of the
+/// settings.
+static const int MIN_COMPRESSION_BUFFER_SIZE = 4096;
+
+PowerTabExporter::PowerTabExporter(const SettingsManager &settings_manager)
+    : FileFormatExporter(getPowerTabFileFormat()),
+      mySettingsManager(settings_manager)
 {
 }
 
 void PowerTabExporter::save(const std::string &filename, const Score &score)
 {
+    bool binary;
+    int level;
+    size_t buffer_size;
+    {
+        auto settings = mySettingsManager.getReadHandle();
+        binary = settings->get(Settings::SavePowerTabAsBinary);
+        level = std::min(
+            std::max(settings->get(Settings::PowerTabCompressionLevel),
+                     static_cast<int>(boost::iostreams::gzip::no_compression)),
+            static_cast<int>(boost::iostreams::gzip::best_compression));
+        buffer_size = static_cast<size_t>(
+            std::max(settings->get(Settings::PowerTabCompressionBufferSize),
+                     MIN_COMPRESSION_BUFFER_SIZE));
+    }
+
     // Use gzip to compress the resulting data.
     std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
+    if (!file)
+        throw std::runtime_error("Could not open " + filename);
+
     boost::iostreams::filtering_ostreambuf out;
-    out.push(boost::iostreams::gzip_compressor());
-    out.push(file);
+    out.push(boost::iostreams::gzip_compressor(
+                 boost::iostreams::gzip_params(level), buffer_size),
+             buffer_size);
+    out.push(file, buffer_size);
+
+    // Compress on a separate thread while the score is being serialized.
+    Util::ThreadedOutputStreamBuf pipeline(out, buffer_size);
+    {
+        std::ostream output(&pipeline);
+        if (binary)
+            ScoreUtils::saveBinary(output, "score", score);
+        else
+            ScoreUtils::save(output, "score", score);
+    }
+
+    pipeline.finish();
 
-    std::ostream compressed_output(&out);
-    ScoreUtils::save(compressed_output, "score", score);
+    // Write out the end of the compressed data, and check that all of it
+    // reached the file. Otherwise, errors would be ignored by the
+    // destructors.
+    out.pop();
+    file.close();
+    if (!file)
+        throw std::runtime_error("Error writing to " + filename);
 }
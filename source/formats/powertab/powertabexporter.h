@@ -23,9 +23,20 @@
 class PowerTabExporter : public FileFormatExporter
 {
 public:
-    PowerTabExporter();
+    /// The data is stored either as JSON, which is easy to inspect and diff,
+    /// or in a compact binary format that is faster to load and save,
+    /// depending on Settings::SavePowerTabAsBinary. Both are gzip-compressed,
+    /// and the importer accepts either.
+    PowerTabExporter(const SettingsManager &settings_manager);
 
+    /// JSON data is written in compact form, and is compressed on a separate
+    /// thread while the score is being serialized. The compression level and
+    /// buffer size are taken from Settings::PowerTabCompressionLevel and
+    /// Settings::PowerTabCompressionBufferSize.
     virtual void save(const std::string &filename, const Score &score) override;
+
+private:
+    const SettingsManager &mySettingsManager;
 };
 
 #endif
@@ -18,9 +18,11 @@
 #include "powertabimporter.h"
 
 #include "common.h"
+#include <boost/iostreams/device/array.hpp>
 #include <boost/iostreams/filtering_streambuf.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
 #include <fstream>
+#include <score/binaryserialization.h>
 #include <score/score.h>
 #include <score/serialization.h>
 
@@ -39,5 +41,50 @@ void PowerTabImporter::load(const std::string &filename, Score &score)
     in.push(file);
 
     std::istream compressed_input(&in);
-    ScoreUtils::load(compressed_input, "score", score);
+    if (ScoreUtils::isBinaryArchive(compressed_input))
+        ScoreUtils::loadBinary(compressed_input, "score", score);
+    else
+        ScoreUtils::load(compressed_input, "score", score);
+}
+
+bool PowerTabImporter::matchesSignature(const uint8_t *data,
+                                        size_t length) const
+{
+    // Check for the gzip header.
+    return length >= 2 && data[0] == 0x1f && data[1] == 0x8b;
+}
+
+namespace
+{
+/// The start of a score, which contains the score information.
+struct ScoreHeader
+{
+    template <class Archive>
+    void serialize(Archive &ar, const FileVersion /*version*/)
+    {
+        ar("score_info", myScoreInfo);
+    }
+
+    ScoreInfo myScoreInfo;
+};
+}
+
+bool PowerTabImporter::readScoreInfo(const uint8_t *data, size_t length,
+                                     ScoreInfo &info) const
+{
+    // Only the data that is needed for the header is decompressed.
+    boost::iostreams::filtering_istreambuf in;
+    in.push(boost::iostreams::gzip_decompressor());
+    in.push(boost::iostreams::array_source(
+        reinterpret_cast<const char *>(data), length));
+
+    std::istream compressed_input(&in);
+    ScoreHeader header;
+    if (ScoreUtils::isBinaryArchive(compressed_input))
+        ScoreUtils::loadBinaryPartial(compressed_input, "score", header);
+    else
+        ScoreUtils::loadPartial(compressed_input, "score", header);
+
+    info = header.myScoreInfo;
+    return true;
 }
@@ -0,0 +1,136 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:            objectarena.h
+// Purpose:         Bump allocator for the objects read from a Power Tab file
+// Author:          Cameron White
+// Modified by:
+// Created:         Oct 18, 2017
+// RCS-ID:
+// Copyright:       (c) Cameron White
+// License:         wxWindows license
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef OBJECTARENA_H
+#define OBJECTARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace PowerTabDocument {
+
+/// Allocates the objects of a document (systems, staves, positions, notes,
+/// ...) from large blocks of memory rather than individually from the heap.
+/// Memory is only released when the arena is destroyed.
+///
+/// Objects that are shared (via std::allocate_shared and ArenaAllocator) keep
+/// the arena alive. Positions and notes are placed directly in the arena and
+/// are owned by their staff or position, which destroys them with
+/// ObjectArena::Destroy() rather than delete.
+class ObjectArena
+{
+public:
+    ObjectArena() : m_pos(nullptr), m_end(nullptr)
+    {
+    }
+
+    ObjectArena(const ObjectArena &) = delete;
+    ObjectArena &operator=(const ObjectArena &) = delete;
+
+    void* Allocate(size_t size, size_t alignment)
+    {
+        uintptr_t pos = reinterpret_cast<uintptr_t>(m_pos);
+        pos = (pos + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+
+        if (m_pos == nullptr || pos + size > reinterpret_cast<uintptr_t>(m_end))
+        {
+            AddBlock(size + alignment);
+            return Allocate(size, alignment);
+        }
+
+        m_pos = reinterpret_cast<char*>(pos + size);
+        return reinterpret_cast<void*>(pos);
+    }
+
+    /// Constructs an object in the arena.
+    template <class T>
+    T* Create()
+    {
+        return new (Allocate(sizeof(T), alignof(T))) T();
+    }
+
+    /// Destroys an object that was created with Create(). The memory is
+    /// reclaimed when the arena is destroyed.
+    template <class T>
+    static void Destroy(T* object)
+    {
+        if (object)
+            object->~T();
+    }
+
+private:
+    static const size_t BLOCK_SIZE = 64 * 1024;
+
+    void AddBlock(size_t minSize)
+    {
+        const size_t size = minSize > BLOCK_SIZE ? minSize : BLOCK_SIZE;
+        m_blocks.emplace_back(new char[size]);
+        m_pos = m_blocks.back().get();
+        m_end = m_pos + size;
+    }
+
+    std::vector<std::unique_ptr<char[]> > m_blocks;
+    char* m_pos;
+    char* m_end;
+};
+
+/// Allocator for use with std::allocate_shared, which holds a reference to
+/// the arena so that it outlives any objects allocated from it.
+template <class T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+
+    explicit ArenaAllocator(const std::shared_ptr<ObjectArena>& arena) :
+        m_arena(arena)
+    {
+    }
+
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : m_arena(other.m_arena)
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(m_arena->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t)
+    {
+    }
+
+    template <class U>
+    bool operator==(const ArenaAllocator<U>& other) const
+    {
+        return m_arena == other.m_arena;
+    }
+
+    template <class U>
+    bool operator!=(const ArenaAllocator<U>& other) const
+    {
+        return m_arena != other.m_arena;
+    }
+
+private:
+    template <class U>
+    friend class ArenaAllocator;
+
+    std::shared_ptr<ObjectArena> m_arena;
+};
+
+}
+
+#endif // OBJECTARENA_H
@@ -55,9 +55,10 @@ Position::Position() :
 /// Destructor
 Position::~Position()
 {
+    // Notes are allocated from the input stream's arena.
     for (auto &note : m_noteArray)
     {
-        delete note;
+        ObjectArena::Destroy(note);
     }
 }
 
@@ -13,6 +13,7 @@
 #include "powertabinputstream.h"
 #include "powertaboutputstream.h"
 
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <fstream>
 
 #include "score.h"
@@ -220,8 +221,18 @@ bool Document::Save(const string& fileName) const
 /// @throw std::ifstream::failure
 void Document::Load(const string& fileName)
 {
-    std::ifstream fileStream(fileName.c_str(), std::ifstream::in | std::ifstream::binary);
-    PowerTabInputStream stream(fileStream);
+    boost::iostreams::mapped_file_source file;
+    try
+    {
+        file.open(fileName);
+    }
+    catch (const std::exception&)
+    {
+        throw std::ios_base::failure("Could not open file: " + fileName);
+    }
+
+    PowerTabInputStream stream(reinterpret_cast<const uint8_t*>(file.data()),
+                               file.size());
 
     DeleteContents();
 
@@ -14,15 +14,30 @@
 #include "rect.h"
 #include "macros.h"
 
+#include <ios>
+#include <istream>
+#include <iterator>
+
 namespace PowerTabDocument {
 
 using std::string;
 
+PowerTabInputStream::PowerTabInputStream(const uint8_t* data, size_t length) :
+    m_pos(data), m_end(data + length), m_arena(std::make_shared<ObjectArena>())
+{
+}
+
 PowerTabInputStream::PowerTabInputStream(std::istream& stream) :
-    m_stream(stream)
+    m_buffer((std::istreambuf_iterator<char>(stream)),
+             std::istreambuf_iterator<char>()),
+    m_pos(m_buffer.data()), m_end(m_buffer.data() + m_buffer.size()),
+    m_arena(std::make_shared<ObjectArena>())
 {
-    // ensure that the stream will throw std::ifstream::failure if any errors occur
-    stream.exceptions(std::istream::failbit | std::istream::badbit | std::istream::eofbit);
+}
+
+void PowerTabInputStream::ThrowError(const char* message)
+{
+    throw std::ios_base::failure(message);
 }
 
 // Read Functions
@@ -51,15 +66,11 @@ uint32_t PowerTabInputStream::ReadCount()
 /// @return True if the string was read, false if not
 void PowerTabInputStream::ReadMFCString(string& str)
 {
-    str.clear();
-
     const uint32_t length = ReadMFCStringLength();
-    str.resize(length);
+    Require(length);
 
-	if (length != 0)
-	{
-		m_stream.read(&str[0], length);
-	}
+    str.assign(reinterpret_cast<const char*>(m_pos), length);
+    m_pos += length;
 }
 
 /// Reads a Win32 format COLORREF type from the stream
@@ -129,7 +140,9 @@ void PowerTabInputStream::ReadClassInformation()
 
         *this >> schema;
         *this >> length;
-        m_stream.seekg(length, std::ios_base::cur);
+
+        Require(length);
+        m_pos += length;
     }
 
     // otherwise, existing class index in obj_tag followed by new object
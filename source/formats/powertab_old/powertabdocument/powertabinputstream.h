@@ -14,23 +14,36 @@
 
 #include <array>
 #include <cstdint>
-#include <istream>
+#include <cstring>
+#include <iosfwd>
 #include <memory>
+#include <type_traits>
 #include <vector>
 
+#include "objectarena.h"
+
 namespace PowerTabDocument {
 
 class Rect;
 class Colour;
 
-/// Input stream used to deserialize MFC based Power Tab data
+/// Input stream used to deserialize MFC based Power Tab data.
+/// The data is read from a block of memory (e.g. a memory-mapped file), and
+/// the objects that are read are allocated from an ObjectArena.
 class PowerTabInputStream
 {
     // Member Variables
 private:
-    std::istream& m_stream;
+    /// Storage for the data, if it was read from a std::istream.
+    std::vector<uint8_t> m_buffer;
+    const uint8_t* m_pos;
+    const uint8_t* m_end;
+    std::shared_ptr<ObjectArena> m_arena;
 
 public:
+    /// Reads from a block of memory, which must outlive the stream.
+    PowerTabInputStream(const uint8_t* data, size_t length);
+    /// Reads the entire contents of the stream into a buffer.
     PowerTabInputStream(std::istream& stream);
 
     // Read Functions
@@ -43,6 +56,49 @@ private:
     void ReadClassInformation();
     uint32_t ReadMFCStringLength();
 
+    /// Throws std::ios_base::failure if there are fewer than numBytes
+    /// remaining.
+    void Require(size_t numBytes) const
+    {
+        if (static_cast<size_t>(m_end - m_pos) < numBytes)
+            ThrowError("Unexpected end of file");
+    }
+
+    /// Throws std::ios_base::failure with the given message.
+    static void ThrowError(const char* message);
+
+    /// Copies raw data from the stream.
+    void ReadBytes(void* dest, size_t numBytes)
+    {
+        Require(numBytes);
+        if (numBytes != 0)
+            std::memcpy(dest, m_pos, numBytes);
+        m_pos += numBytes;
+    }
+
+    /// Loads a little-endian integer.
+    template <class T>
+    static T Load(const uint8_t* data, std::true_type /* is_integral */)
+    {
+        typedef typename std::make_unsigned<T>::type UnsignedT;
+
+        UnsignedT value = 0;
+        for (size_t i = 0; i < sizeof(T); ++i)
+            value |= static_cast<UnsignedT>(static_cast<UnsignedT>(data[i])
+                                            << (8 * i));
+
+        return static_cast<T>(value);
+    }
+
+    /// Loads any other plain data.
+    template <class T>
+    static T Load(const uint8_t* data, std::false_type /* is_integral */)
+    {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+    }
+
 public:
 
     template <class T>
@@ -61,11 +117,26 @@ public:
     }
 
     /// Read data from the input stream
-    /// @throw std::ifstream::failure if any errors occur
+    /// @throw std::ios_base::failure if the end of the data is reached
     template<class T>
     inline PowerTabInputStream& operator>>(T& data)
     {
-        m_stream.read(reinterpret_cast<char *>(&data), sizeof(data));
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "T must be a trivially copyable type");
+        Require(sizeof(T));
+
+        data = Load<T>(m_pos,
+                       std::integral_constant<bool, std::is_integral<T>::value &&
+                                              !std::is_same<T, bool>::value>());
+        m_pos += sizeof(T);
+        return *this;
+    }
+
+    inline PowerTabInputStream& operator>>(bool& data)
+    {
+        uint8_t value = 0;
+        *this >> value;
+        data = (value != 0);
         return *this;
     }
 
@@ -78,7 +149,7 @@ public:
         vect.clear();
         vect.resize(size);
 
-        m_stream.read((char*)&vect[0], size * sizeof(T));
+        ReadBytes(vect.data(), size * sizeof(T));
     }
 
     template <class T, size_t N>
@@ -87,25 +158,30 @@ public:
         uint8_t size = 0;
         *this >> size;
 
-        m_stream.read((char*)&array[0], size * sizeof(T));
+        if (size > N)
+            ThrowError("Invalid array size");
+
+        ReadBytes(array.data(), size * sizeof(T));
     }
 
 private:
+    /// Objects that are owned through raw pointers (positions and notes) are
+    /// placed in the arena, and must be released with ObjectArena::Destroy().
     template <class T>
     inline void ReadObject(std::vector<T*>& vect, uint16_t version)
     {
-        std::unique_ptr<T> object(new T());
-        object->Deserialize(*this, version);
-        vect.push_back(object.release());
+        vect.push_back(m_arena->Create<T>());
+        vect.back()->Deserialize(*this, version);
     }
 
     template <class T>
     inline void ReadObject(std::vector<std::shared_ptr<T> >& vect,
                            uint16_t version)
     {
-        std::shared_ptr<T> object(std::make_shared<T>());
+        std::shared_ptr<T> object(
+            std::allocate_shared<T>(ArenaAllocator<T>(m_arena)));
         object->Deserialize(*this, version);
-        vect.push_back(object);
+        vect.push_back(std::move(object));
     }
 };
 
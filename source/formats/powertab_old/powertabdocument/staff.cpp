@@ -68,12 +68,13 @@ Staff::Staff(uint8_t tablatureStaffType, uint8_t clef) :
 
 Staff::~Staff()
 {
+    // Positions are allocated from the input stream's arena.
     for (size_t i = 0; i < positionArrays.size(); i++)
     {
         std::vector<Position*>& positionArray = positionArrays[i];
         for (size_t j = 0; j < positionArray.size(); j++)
         {
-            delete positionArray[j];
+            ObjectArena::Destroy(positionArray[j]);
         }
     }
 }
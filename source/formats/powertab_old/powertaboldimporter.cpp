@@ -17,6 +17,8 @@
 
 #include "powertaboldimporter.h"
 
+#include <chrono>
+#include <future>
 #include <formats/powertab_old/powertabdocument/alternateending.h>
 #include <formats/powertab_old/powertabdocument/barline.h>
 #include <formats/powertab_old/powertabdocument/chordtext.h>
@@ -28,15 +30,17 @@
 #include <formats/powertab_old/powertabdocument/note.h>
 #include <formats/powertab_old/powertabdocument/position.h>
 #include <formats/powertab_old/powertabdocument/powertabdocument.h>
+#include <formats/powertab_old/powertabdocument/powertabinputstream.h>
 #include <formats/powertab_old/powertabdocument/score.h>
 #include <formats/powertab_old/powertabdocument/staff.h>
 #include <formats/powertab_old/powertabdocument/system.h>
 #include <formats/powertab_old/powertabdocument/tempomarker.h>
+#include <formats/powertab_old/scoremerger.h>
 #include <score/generalmidi.h>
 #include <score/score.h>
 #include <score/systemlocation.h>
-#include <score/utils/scoremerger.h>
 #include <score/utils/scorepolisher.h>
+#include <util/parallel.h>
 
 PowerTabOldImporter::PowerTabOldImporter()
     : FileFormatImporter(FileFormat("Power Tab 1.7 Document", { "ptb" }))
@@ -45,8 +49,13 @@ PowerTabOldImporter::PowerTabOldImporter()
 
 void PowerTabOldImporter::load(const std::string &filename, Score &score)
 {
+    typedef std::chrono::high_resolution_clock Clock;
+    myTimings.clear();
+    const auto start = Clock::now();
+
     PowerTabDocument::Document document;
-    document.Load(filename);
+    myTimings.push_back(timePhase("Read", [&]() { document.Load(filename); }));
+    checkCancelled();
 
     // TODO - handle font settings, etc.
     ScoreInfo info;
@@ -57,18 +66,66 @@ void PowerTabOldImporter::load(const std::string &filename, Score &score)
     
     assert(document.GetNumberOfScores() == 2);
 
-    // Convert the guitar score.
+    // Convert the guitar and bass scores in parallel. The document is not
+    // modified while this is happening.
     Score guitarScore;
-    convert(*document.GetScore(0), guitarScore);
-
-    // Convert and then merge the bass score.
     Score bassScore;
-    convert(*document.GetScore(1), bassScore);
-    ScoreMerger::merge(score, guitarScore, bassScore);
+    myTimings.push_back(timePhase("Convert", [&]() {
+        auto bassTask = std::async(Util::launchPolicy(), [&]() {
+            convert(*document.GetScore(1), bassScore);
+        });
+
+        // Wait for the bass score before rethrowing any errors.
+        try
+        {
+            convert(*document.GetScore(0), guitarScore);
+        }
+        catch (...)
+        {
+            bassTask.wait();
+            throw;
+        }
+        bassTask.get();
+    }));
+    checkCancelled();
+
+    myTimings.push_back(timePhase("Merge", [&]() {
+        ScoreMerger::merge(score, guitarScore, bassScore);
+    }));
 
     // Reformat the score, since the guitar and bass score from v1.7 may have
     // had different spacing.
-    ScoreUtils::polishScore(score);
+    myTimings.push_back(
+        timePhase("Polish", [&]() { ScoreUtils::polishScore(score); }));
+
+    myTimings.push_back(
+        { "Total",
+          std::chrono::duration<double>(Clock::now() - start).count() });
+}
+
+bool PowerTabOldImporter::matchesSignature(const uint8_t *data,
+                                           size_t length) const
+{
+    if (length < 4)
+        return false;
+
+    // The file begins with a little-endian marker.
+    const uint32_t marker = data[0] | (data[1] << 8) | (data[2] << 16) |
+                            (static_cast<uint32_t>(data[3]) << 24);
+    return PowerTabDocument::PowerTabFileHeader::IsValidPowerTabFileMarker(
+        marker);
+}
+
+bool PowerTabOldImporter::readScoreInfo(const uint8_t *data, size_t length,
+                                        ScoreInfo &info) const
+{
+    PowerTabDocument::PowerTabInputStream stream(data, length);
+    PowerTabDocument::PowerTabFileHeader header;
+    if (!header.Deserialize(stream))
+        throw FileFormatException("Invalid header");
+
+    convert(header, info);
+    return true;
 }
 
 void PowerTabOldImporter::convert(
@@ -151,12 +208,16 @@ void PowerTabOldImporter::convert(const PowerTabDocument::Score &oldScore,
     for (size_t i = 0; i < oldScore.GetGuitarCount(); ++i)
         convert(*oldScore.GetGuitar(i), score);
 
-    for (size_t i = 0; i < oldScore.GetSystemCount(); ++i)
-    {
-        System system;
-        convert(oldScore, oldScore.GetSystem(i), system);
+    // Each system can be converted independently, so the systems are
+    // converted in parallel and then inserted in order.
+    std::vector<System> systems(oldScore.GetSystemCount());
+    Util::parallelFor(systems.size(), 8, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            convert(oldScore, oldScore.GetSystem(i), systems[i]);
+    });
+
+    for (const System &system : systems)
         score.insertSystem(system);
-    }
 
     // Convert Guitar In's to player changes.
     convertGuitarIns(oldScore, score);
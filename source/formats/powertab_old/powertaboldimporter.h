@@ -63,6 +63,12 @@ public:
     PowerTabOldImporter();
     virtual void load(const std::string &filename, Score &score) override;
 
+    virtual bool matchesSignature(const uint8_t *data,
+                                  size_t length) const override;
+
+    virtual bool readScoreInfo(const uint8_t *data, size_t length,
+                               ScoreInfo &info) const override;
+
 private:
     static void convert(const PowerTabDocument::PowerTabFileHeader &header,
                         ScoreInfo &info);
@@ -17,6 +17,7 @@
 
 #include "scoremerger.h"
 
+#include <algorithm>
 #include <list>
 #include <unordered_set>
 
@@ -74,7 +75,9 @@ public:
 private:
     SystemLocation myLocation;
 
-    /// Multi-bar rest count from the source bar.
+    /// For a multi-bar rest, the number of bars that this entry represents.
+    /// Multi-bar rests are stored as a single run of bars rather than being
+    /// expanded bar by bar.
     int myMultiBarRestCount;
 
     /// Whether this bar was expanded from e.g. a multi-bar rest or a repeated
@@ -133,9 +136,10 @@ static void expandScore(Score &score, ExpandedBarList &expanded_bars)
             alternate_ending = false;
         }
 
-        if (!ScoreUtils::findInRange(system.getAlternateEndings(),
-                                     prev_bar->getPosition(),
-                                     next_bar->getPosition() - 1).empty())
+        if (!ScoreUtils::findInSortedRange(system.getAlternateEndings(),
+                                           prev_bar->getPosition(),
+                                           next_bar->getPosition() - 1)
+                 .empty())
         {
             alternate_ending = true;
         }
@@ -143,14 +147,10 @@ static void expandScore(Score &score, ExpandedBarList &expanded_bars)
         const Position *multibar_rest = score_loc.findMultiBarRest();
         if (multibar_rest)
         {
-            for (int i = multibar_rest->getMultiBarRestCount(); i > 0; --i)
-            {
-                expanded_bars.emplace_back(
-                    location, i != multibar_rest->getMultiBarRestCount(), i,
-                    *prev_bar, remaining_repeats,
-                    next_bar->getBarType() == Barline::RepeatEnd,
-                    alternate_ending);
-            }
+            expanded_bars.emplace_back(
+                location, false, multibar_rest->getMultiBarRestCount(),
+                *prev_bar, remaining_repeats,
+                next_bar->getBarType() == Barline::RepeatEnd, alternate_ending);
         }
         else if (!score_loc.isEmptyBar())
         {
@@ -246,7 +246,7 @@ static int copyNotes(ScoreLocation &dest, const ScoreLocation &src)
     getPositionRange(dest, src, offset, left, right);
 
     auto positions =
-        ScoreUtils::findInRange(src.getVoice().getPositions(), left, right);
+        ScoreUtils::findInSortedRange(src.getVoice().getPositions(), left, right);
 
     if (!positions.empty())
     {
@@ -315,7 +315,7 @@ static int importNotes(
         // rest was expanded.
         if (!is_expanded_bar)
         {
-            for (const Dynamic &dynamic : ScoreUtils::findInRange(
+            for (const Dynamic &dynamic : ScoreUtils::findInSortedRange(
                      src_loc.getStaff().getDynamics(), left, right - 1))
             {
                 Dynamic new_dynamic(dynamic);
@@ -351,7 +351,7 @@ static void copySymbols(
         filled_positions.insert(dest_symbol.getPosition());
 
     for (const Symbol &src_symbol :
-         ScoreUtils::findInRange(src_symbols, left, right - 1))
+         ScoreUtils::findInSortedRange(src_symbols, left, right - 1))
     {
         Symbol symbol(src_symbol);
         symbol.setPosition(src_symbol.getPosition() + offset);
@@ -424,6 +424,43 @@ static int copyContent(ScoreLocation &dest_loc, int &num_guitar_staves,
     }
 }
 
+/// Finds the active players at a location in a source score. This avoids
+/// scanning through all of the previous systems for every bar, as
+/// ScoreUtils::getCurrentPlayers() does.
+class PlayerChangeIndex
+{
+public:
+    explicit PlayerChangeIndex(const Score &score) : myScore(score)
+    {
+        // Record the active player change at the start of each system.
+        const PlayerChange *current = nullptr;
+        for (const System &system : score.getSystems())
+        {
+            myInitialChanges.push_back(current);
+            if (!system.getPlayerChanges().empty())
+                current = &system.getPlayerChanges().back();
+        }
+    }
+
+    const PlayerChange *getCurrentPlayers(int system_index,
+                                          int position_index) const
+    {
+        auto changes = myScore.getSystems()[system_index].getPlayerChanges();
+        auto next_change =
+            std::upper_bound(changes.begin(), changes.end(), position_index,
+                             ScoreUtils::PositionLess());
+
+        if (next_change != changes.begin())
+            return &*boost::prior(next_change);
+        else
+            return myInitialChanges[system_index];
+    }
+
+private:
+    const Score &myScore;
+    std::vector<const PlayerChange *> myInitialChanges;
+};
+
 static const PlayerChange *findPlayerChange(
     const ScoreLocation &dest_loc, const ScoreLocation &src_loc,
     ExpandedBarList::const_iterator src_bar,
@@ -435,7 +472,7 @@ static const PlayerChange *findPlayerChange(
     int offset, left, right;
     getPositionRange(dest_loc, src_loc, offset, left, right);
 
-    auto changes = ScoreUtils::findInRange(
+    auto changes = ScoreUtils::findInSortedRange(
         src_loc.getSystem().getPlayerChanges(), left, right - 1);
 
     return changes.empty() ? nullptr : &changes.front();
@@ -443,7 +480,9 @@ static const PlayerChange *findPlayerChange(
 
 static void mergePlayerChanges(ScoreLocation &dest_loc,
                                const ScoreLocation &guitar_loc,
+                               const PlayerChangeIndex &guitar_players,
                                const ScoreLocation &bass_loc,
+                               const PlayerChangeIndex &bass_players,
                                ExpandedBarList::const_iterator guitar_bar,
                                ExpandedBarList::const_iterator end_guitar_bar,
                                ExpandedBarList::const_iterator bass_bar,
@@ -470,18 +509,16 @@ static void mergePlayerChanges(ScoreLocation &dest_loc,
         {
             // If there is only a player change in the bass score, carry over
             // the current active players from the guitar score.
-            guitar_change = ScoreUtils::getCurrentPlayers(
-                guitar_loc.getScore(), guitar_loc.getSystemIndex(),
-                guitar_loc.getPositionIndex());
+            guitar_change = guitar_players.getCurrentPlayers(
+                guitar_loc.getSystemIndex(), guitar_loc.getPositionIndex());
         }
 
         if (!bass_change && bass_bar != end_bass_bar)
         {
             // If there is only a player change in the guitar score, carry over
             // the current active players from the bass score.
-            bass_change = ScoreUtils::getCurrentPlayers(
-                bass_loc.getScore(), bass_loc.getSystemIndex(),
-                bass_loc.getPositionIndex());
+            bass_change = bass_players.getCurrentPlayers(
+                bass_loc.getSystemIndex(), bass_loc.getPositionIndex());
         }
 
         // Merge in data from only the active staves.
@@ -619,6 +656,9 @@ static void combineScores(Score &dest_score, Score &guitar_score,
     Caret bass_caret(bass_score, theDefaultViewOptions);
     const ScoreLocation &bass_loc = bass_caret.getLocation();
 
+    const PlayerChangeIndex guitar_players(guitar_score);
+    const PlayerChangeIndex bass_players(bass_score);
+
     auto guitar_bar = guitar_bars.begin();
     const auto end_guitar_bar = guitar_bars.end();
     auto bass_bar = bass_bars.begin();
@@ -688,9 +728,10 @@ static void combineScores(Score &dest_score, Score &guitar_score,
                                                  bass_caret, *bass_bar, true));
         }
 
-        mergePlayerChanges(dest_loc, guitar_loc, bass_loc, guitar_bar,
-                           end_guitar_bar, bass_bar, end_bass_bar,
-                           num_guitar_staves, prev_num_guitar_staves);
+        mergePlayerChanges(dest_loc, guitar_loc, guitar_players, bass_loc,
+                           bass_players, guitar_bar, end_guitar_bar, bass_bar,
+                           end_bass_bar, num_guitar_staves,
+                           prev_num_guitar_staves);
 
         // Advance to the next bar in the source scores.
         if (guitar_bar != end_guitar_bar)
@@ -735,18 +776,20 @@ static void combineScores(Score &dest_score, Score &guitar_score,
     }
 }
 
-/// Merge the expanded bars from a multi-bar rest.
-static ExpandedBarList::iterator mergeMultiBarRest(
-    ExpandedBarList &bars, ExpandedBarList::iterator bar, int count)
+/// Splits off the first few bars of a multi-bar rest. The remaining bars are
+/// left as a separate run after it.
+static void splitMultiBarRest(ExpandedBarList &bars,
+                              ExpandedBarList::iterator bar, int count)
 {
-    bar->setMultiBarRestCount(count);
+    const int remaining = bar->getMultiBarRestCount() - count;
+    if (remaining > 0)
+    {
+        bars.emplace(boost::next(bar), bar->getLocation(), true, remaining,
+                     bar->getStartBar(), bar->getRemainingRepeats(),
+                     bar->isRepeatEnd(), bar->isAlternateEnding());
+    }
 
-    // Remove the following bars that were expanded.
-    auto range_begin = bar;
-    auto range_end = bar;
-    std::advance(range_begin, 1);
-    std::advance(range_end, count);
-    return bars.erase(range_begin, range_end);
+    bar->setMultiBarRestCount(count);
 }
 
 static void mergeMultiBarRests(ExpandedBarList &guitar_bars,
@@ -762,43 +805,23 @@ static void mergeMultiBarRests(ExpandedBarList &guitar_bars,
         if (guitar_bar->getMultiBarRestCount() > 0 &&
             bass_bar->getMultiBarRestCount() > 0)
         {
+            // Merge the overlapping part of the rests.
             const int count = std::min(guitar_bar->getMultiBarRestCount(),
                                        bass_bar->getMultiBarRestCount());
-            guitar_bar = mergeMultiBarRest(guitar_bars, guitar_bar, count);
-            bass_bar = mergeMultiBarRest(bass_bars, bass_bar, count);
-            continue;
+            splitMultiBarRest(guitar_bars, guitar_bar, count);
+            splitMultiBarRest(bass_bars, bass_bar, count);
         }
-
-        // Otherwise, keep the expanded bars and convert them to a whole rest.
-        if (guitar_bar->getMultiBarRestCount() > 0)
-            guitar_bar->setMultiBarRestCount(1);
+        // Otherwise, split off a single bar and convert it to a whole rest.
+        else if (guitar_bar->getMultiBarRestCount() > 0)
+            splitMultiBarRest(guitar_bars, guitar_bar, 1);
         else if (bass_bar->getMultiBarRestCount() > 0)
-            bass_bar->setMultiBarRestCount(1);
+            splitMultiBarRest(bass_bars, bass_bar, 1);
 
         ++guitar_bar;
         ++bass_bar;
     }
 
-    while (guitar_bar != guitar_end_bar)
-    {
-        if (guitar_bar->getMultiBarRestCount() > 0)
-        {
-            guitar_bar = mergeMultiBarRest(guitar_bars, guitar_bar,
-                                           guitar_bar->getMultiBarRestCount());
-        }
-        else
-            ++guitar_bar;
-    }
-    while (bass_bar != bass_end_bar)
-    {
-        if (bass_bar->getMultiBarRestCount() > 0)
-        {
-            bass_bar = mergeMultiBarRest(bass_bars, bass_bar,
-                                         bass_bar->getMultiBarRestCount());
-        }
-        else
-            ++bass_bar;
-    }
+    // Any remaining multi-bar rests are left intact.
 }
 
 static ExpandedBarList::iterator clearRepeatedSection(
@@ -15,8 +15,8 @@
   * along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#ifndef SCORE_UTILS_SCOREMERGER_H
-#define SCORE_UTILS_SCOREMERGER_H
+#ifndef FORMATS_POWERTABOLD_SCOREMERGER_H
+#define FORMATS_POWERTABOLD_SCOREMERGER_H
 
 class Score;
 
@@ -0,0 +1,522 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "scorelibrary.h"
+
+#include <algorithm>
+#include <atomic>
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/iostreams/stream.hpp>
+#include <formats/fileformatmanager.h>
+#include <fstream>
+#include <limits>
+#include <score/binaryserialization.h>
+#include <score/score.h>
+#include <util/atomicfile.h>
+#include <util/parallel.h>
+
+namespace fs = boost::filesystem;
+
+static std::string getExtension(const fs::path &path)
+{
+    std::string extension = path.extension().string();
+    if (!extension.empty())
+        extension.erase(0, 1); // Remove the leading '.'
+
+    return boost::algorithm::to_lower_copy(extension);
+}
+
+/// Computes a 64-bit FNV-1a hash of a file's contents.
+static uint64_t hashFile(const std::string &path, uint64_t size)
+{
+    uint64_t hash = 14695981039346656037ULL;
+
+    // Empty files cannot be mapped.
+    if (size == 0)
+        return hash;
+
+    boost::iostreams::mapped_file_source file(path);
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(file.data());
+    for (size_t i = 0, n = file.size(); i < n; ++i)
+    {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/// Removes any trailing separators, which would otherwise be treated as an
+/// extra "." component (e.g. "/music/" would not contain "/music/song.gp5").
+static fs::path normalizeDirectory(fs::path dir)
+{
+    while (dir.filename() == "." && dir.has_parent_path())
+        dir = dir.parent_path();
+
+    return dir;
+}
+
+/// Returns whether the path is inside the directory (or its subdirectories).
+static bool isInDirectory(const fs::path &path, const fs::path &dir)
+{
+    auto it = path.begin();
+    for (const fs::path &component : normalizeDirectory(dir))
+    {
+        if (it == path.end() || *it != component)
+            return false;
+        ++it;
+    }
+
+    return it != path.end();
+}
+
+static bool isSameKey(const KeySignature &key1, const KeySignature &key2)
+{
+    return key1.getKeyType() == key2.getKeyType() &&
+           key1.getNumAccidentals() == key2.getNumAccidentals() &&
+           (key1.getNumAccidentals() == 0 ||
+            key1.usesSharps() == key2.usesSharps());
+}
+
+static bool isSameMeter(const TimeSignature &time1, const TimeSignature &time2)
+{
+    return time1.getBeatsPerMeasure() == time2.getBeatsPerMeasure() &&
+           time1.getBeatValue() == time2.getBeatValue();
+}
+
+/// Adds a value to the list if there isn't an equivalent value already.
+template <typename T, typename Equal>
+static void addUnique(std::vector<T> &values, const T &value,
+                      const Equal &equal)
+{
+    if (std::none_of(values.begin(), values.end(),
+                     [&](const T &other) { return equal(value, other); }))
+    {
+        values.push_back(value);
+    }
+}
+
+LibraryEntry::LibraryEntry() : modifiedTime(0), fileSize(0), contentHash(0)
+{
+}
+
+void LibraryEntry::setScore(const Score &score)
+{
+    scoreInfo = score.getScoreInfo();
+    tunings.clear();
+    tempos.clear();
+    keySignatures.clear();
+    timeSignatures.clear();
+
+    for (const Player &player : score.getPlayers())
+    {
+        addUnique(tunings, player.getTuning(),
+                  [](const Tuning &t1, const Tuning &t2) {
+                      return t1.getNotes() == t2.getNotes();
+                  });
+    }
+
+    for (const System &system : score.getSystems())
+    {
+        for (const Barline &barline : system.getBarlines())
+        {
+            addUnique(keySignatures, barline.getKeySignature(), isSameKey);
+            addUnique(timeSignatures, barline.getTimeSignature(), isSameMeter);
+        }
+
+        for (const TempoMarker &marker : system.getTempoMarkers())
+        {
+            if (marker.getMarkerType() == TempoMarker::StandardMarker)
+                tempos.push_back(marker.getBeatsPerMinute());
+        }
+    }
+
+    std::sort(tempos.begin(), tempos.end());
+    tempos.erase(std::unique(tempos.begin(), tempos.end()), tempos.end());
+}
+
+LibraryUpdateResult::LibraryUpdateResult()
+    : numFiles(0), numImported(0), numRemoved(0), cancelled(false)
+{
+}
+
+LibraryUpdateListener::~LibraryUpdateListener()
+{
+}
+
+ScoreLibrary::ScoreLibrary()
+{
+}
+
+void ScoreLibrary::load(const std::string &path)
+{
+    // The index is read directly from the mapped file.
+    boost::iostreams::mapped_file_source file(path);
+    boost::iostreams::stream<boost::iostreams::array_source> input(
+        file.data(), file.size());
+
+    ScoreLibrary library;
+    ScoreUtils::loadBinary(input, "library", library);
+
+    myDirectories = std::move(library.myDirectories);
+    myEntries = std::move(library.myEntries);
+    updateSearchText();
+}
+
+void ScoreLibrary::save(const std::string &path) const
+{
+    Util::writeFileAtomically(path, [&](const std::string &temp_path) {
+        std::ofstream output(temp_path.c_str(),
+                             std::ios::out | std::ios::binary);
+        ScoreUtils::saveBinary(output, "library", *this);
+
+        output.flush();
+        if (!output)
+            throw std::runtime_error("Error writing to " + path);
+    });
+}
+
+const std::vector<std::string> &ScoreLibrary::getDirectories() const
+{
+    return myDirectories;
+}
+
+void ScoreLibrary::addDirectory(const std::string &dir)
+{
+    const std::string normalized = normalizeDirectory(dir).string();
+    if (std::find(myDirectories.begin(), myDirectories.end(), normalized) ==
+        myDirectories.end())
+    {
+        myDirectories.push_back(normalized);
+    }
+}
+
+void ScoreLibrary::removeDirectory(const std::string &dir)
+{
+    // Indexes from older versions may have directories with trailing
+    // separators.
+    const fs::path normalized = normalizeDirectory(dir);
+    myDirectories.erase(
+        std::remove_if(myDirectories.begin(), myDirectories.end(),
+                       [&](const std::string &other) {
+                           return normalizeDirectory(other) == normalized;
+                       }),
+        myDirectories.end());
+
+    // Remove the files, unless they are also in another directory.
+    myEntries.erase(
+        std::remove_if(myEntries.begin(), myEntries.end(),
+                       [&](const LibraryEntry &entry) {
+                           return std::none_of(
+                               myDirectories.begin(), myDirectories.end(),
+                               [&](const std::string &other) {
+                                   return isInDirectory(entry.path, other);
+                               });
+                       }),
+        myEntries.end());
+    updateSearchText();
+}
+
+LibraryUpdateResult ScoreLibrary::update(
+    const SettingsManager &settings_manager, LibraryUpdateListener *listener)
+{
+    LibraryUpdateResult result;
+    auto isCancelled = [=]() { return listener && listener->isCancelled(); };
+
+    // Find all of the supported files.
+    std::vector<fs::path> files;
+    {
+        FileFormatManager manager(settings_manager);
+        for (const std::string &dir : myDirectories)
+        {
+            if (!fs::is_directory(dir))
+                continue;
+
+            for (fs::recursive_directory_iterator it(dir), end; it != end;
+                 ++it)
+            {
+                if (isCancelled())
+                {
+                    result.cancelled = true;
+                    return result;
+                }
+
+                const fs::path &path = it->path();
+                if (fs::is_regular_file(path) &&
+                    manager.findFormat(getExtension(path)))
+                {
+                    files.push_back(path);
+                }
+            }
+        }
+    }
+
+    // The directories may overlap.
+    std::sort(files.begin(), files.end());
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+    result.numFiles = files.size();
+
+    auto findEntry = [&](const std::string &path) -> const LibraryEntry * {
+        auto it = std::lower_bound(
+            myEntries.begin(), myEntries.end(), path,
+            [](const LibraryEntry &entry, const std::string &path) {
+                return entry.path < path;
+            });
+        return (it != myEntries.end() && it->path == path) ? &*it : nullptr;
+    };
+
+    // Files that have the same size and modification time are assumed to be
+    // unchanged, and the rest are checked in parallel.
+    std::vector<LibraryEntry> entries(files.size());
+    std::vector<const LibraryEntry *> previous(files.size(), nullptr);
+    std::vector<size_t> changed;
+    std::vector<std::string> errors(files.size());
+
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        LibraryEntry &entry = entries[i];
+        entry.path = files[i].string();
+        previous[i] = findEntry(entry.path);
+
+        boost::system::error_code error;
+        const std::time_t modified_time = fs::last_write_time(files[i], error);
+        const uintmax_t file_size = error ? 0 : fs::file_size(files[i], error);
+        if (error)
+        {
+            errors[i] = error.message();
+            continue;
+        }
+
+        const LibraryEntry *old_entry = previous[i];
+        if (old_entry && old_entry->modifiedTime == modified_time &&
+            old_entry->fileSize == static_cast<int64_t>(file_size))
+        {
+            entry = *old_entry;
+        }
+        else
+        {
+            entry.modifiedTime = modified_time;
+            entry.fileSize = static_cast<int64_t>(file_size);
+            changed.push_back(i);
+        }
+    }
+
+    // The unchanged files have already been checked.
+    std::atomic<size_t> num_checked(files.size() - changed.size());
+    if (listener)
+        listener->filesChecked(num_checked, files.size());
+
+    std::vector<char> imported(files.size(), 0);
+    Util::parallelFor(changed.size(), 1, [&](size_t begin, size_t end) {
+        // The importers are not thread-safe, so each block has its own.
+        FileFormatManager manager(settings_manager);
+
+        for (size_t j = begin; j < end; ++j)
+        {
+            if (isCancelled())
+                return;
+
+            const size_t i = changed[j];
+            LibraryEntry &entry = entries[i];
+
+            try
+            {
+                entry.contentHash = hashFile(entry.path, entry.fileSize);
+
+                // The file was only touched, so its contents don't need to be
+                // imported again.
+                const LibraryEntry *old_entry = previous[i];
+                if (old_entry && old_entry->contentHash == entry.contentHash)
+                {
+                    const int64_t modified_time = entry.modifiedTime;
+                    entry = *old_entry;
+                    entry.modifiedTime = modified_time;
+                }
+                else
+                {
+                    Score score;
+                    manager.importFile(
+                        score, entry.path,
+                        *manager.findFormat(getExtension(entry.path)));
+                    entry.setScore(score);
+                    imported[i] = true;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                errors[i] = e.what();
+            }
+
+            if (listener)
+                listener->filesChecked(++num_checked, files.size());
+        }
+    });
+
+    // Leave the index unchanged, rather than removing the files that weren't
+    // checked.
+    if (isCancelled())
+    {
+        result.cancelled = true;
+        return result;
+    }
+
+    // Files that couldn't be read are left out of the index, and will be
+    // tried again by the next update.
+    std::vector<LibraryEntry> new_entries;
+    new_entries.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        if (!errors[i].empty())
+            result.errors.emplace_back(entries[i].path, errors[i]);
+        else
+        {
+            if (imported[i])
+                ++result.numImported;
+            new_entries.push_back(std::move(entries[i]));
+        }
+    }
+
+    for (const LibraryEntry &entry : myEntries)
+    {
+        if (!std::binary_search(
+                new_entries.begin(), new_entries.end(), entry,
+                [](const LibraryEntry &e1, const LibraryEntry &e2) {
+                    return e1.path < e2.path;
+                }))
+        {
+            ++result.numRemoved;
+        }
+    }
+
+    myEntries = std::move(new_entries);
+    updateSearchText();
+    return result;
+}
+
+const std::vector<LibraryEntry> &ScoreLibrary::getEntries() const
+{
+    return myEntries;
+}
+
+std::vector<const LibraryEntry *> ScoreLibrary::search(
+    const LibraryQuery &query) const
+{
+    const std::string text = boost::algorithm::to_lower_copy(query.text);
+    const int min_tempo = query.minTempo ? *query.minTempo : 0;
+    const int max_tempo =
+        query.maxTempo ? *query.maxTempo : std::numeric_limits<int>::max();
+
+    std::vector<const LibraryEntry *> results;
+    for (size_t i = 0; i < myEntries.size(); ++i)
+    {
+        const LibraryEntry &entry = myEntries[i];
+
+        if (!text.empty() && mySearchText[i].find(text) == std::string::npos)
+            continue;
+
+        if (query.tuning &&
+            std::none_of(entry.tunings.begin(), entry.tunings.end(),
+                         [&](const Tuning &tuning) {
+                             return tuning.getNotes() ==
+                                    query.tuning->getNotes();
+                         }))
+        {
+            continue;
+        }
+
+        if (query.minTempo || query.maxTempo)
+        {
+            // The tempos are sorted.
+            auto it = std::lower_bound(entry.tempos.begin(),
+                                       entry.tempos.end(), min_tempo);
+            if (it == entry.tempos.end() || *it > max_tempo)
+                continue;
+        }
+
+        if (query.keySignature &&
+            std::none_of(entry.keySignatures.begin(),
+                         entry.keySignatures.end(),
+                         [&](const KeySignature &key) {
+                             return isSameKey(key, *query.keySignature);
+                         }))
+        {
+            continue;
+        }
+
+        if (query.timeSignature &&
+            std::none_of(entry.timeSignatures.begin(),
+                         entry.timeSignatures.end(),
+                         [&](const TimeSignature &time) {
+                             return isSameMeter(time, *query.timeSignature);
+                         }))
+        {
+            continue;
+        }
+
+        results.push_back(&entry);
+    }
+
+    return results;
+}
+
+void ScoreLibrary::updateSearchText()
+{
+    mySearchText.clear();
+    mySearchText.reserve(myEntries.size());
+
+    for (const LibraryEntry &entry : myEntries)
+    {
+        std::vector<std::string> fields;
+        fields.push_back(fs::path(entry.path).filename().string());
+
+        const ScoreInfo &info = entry.scoreInfo;
+        if (info.getScoreType() == ScoreInfo::ScoreType::Song)
+        {
+            const SongData &song = info.getSongData();
+            fields.push_back(song.getTitle());
+            fields.push_back(song.getArtist());
+            if (!song.isTraditionalAuthor())
+            {
+                fields.push_back(song.getAuthorInfo().getComposer());
+                fields.push_back(song.getAuthorInfo().getLyricist());
+            }
+            fields.push_back(song.getArranger());
+            fields.push_back(song.getTranscriber());
+        }
+        else
+        {
+            const LessonData &lesson = info.getLessonData();
+            fields.push_back(lesson.getTitle());
+            fields.push_back(lesson.getSubtitle());
+            fields.push_back(lesson.getAuthor());
+        }
+
+        // Separate the fields so that a search can't match across them.
+        std::string text;
+        for (const std::string &field : fields)
+        {
+            text += boost::algorithm::to_lower_copy(field);
+            text += '\n';
+        }
+
+        mySearchText.push_back(std::move(text));
+    }
+}
@@ -0,0 +1,193 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef FORMATS_SCORELIBRARY_H
+#define FORMATS_SCORELIBRARY_H
+
+#include <boost/optional/optional.hpp>
+#include <cstdint>
+#include <score/fileversion.h>
+#include <score/keysignature.h>
+#include <score/scoreinfo.h>
+#include <score/timesignature.h>
+#include <score/tuning.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+class Score;
+class SettingsManager;
+
+/// The searchable information about one file in a ScoreLibrary.
+struct LibraryEntry
+{
+    LibraryEntry();
+
+    /// Fills in the searchable information from an imported score.
+    void setScore(const Score &score);
+
+    template <class Archive>
+    void serialize(Archive &ar, const FileVersion version);
+
+    std::string path;
+    /// The modification time and size of the file when it was indexed, which
+    /// are checked to find files that may have changed.
+    int64_t modifiedTime;
+    int64_t fileSize;
+    /// A hash of the file's contents, to avoid importing a file again when it
+    /// was touched but not modified.
+    uint64_t contentHash;
+
+    ScoreInfo scoreInfo;
+    /// The distinct tunings of the players.
+    std::vector<Tuning> tunings;
+    /// The distinct tempos (in beats per minute) of the tempo markers.
+    std::vector<int> tempos;
+    /// The distinct key and time signatures used in the score.
+    std::vector<KeySignature> keySignatures;
+    std::vector<TimeSignature> timeSignatures;
+};
+
+/// The criteria for a library search. A file must match every criterion that
+/// is set.
+struct LibraryQuery
+{
+    /// Matches the title, artist, author, etc, or the filename. This is case
+    /// insensitive.
+    std::string text;
+    /// Matches files where a player's tuning has the same notes (the name,
+    /// capo, etc are ignored).
+    boost::optional<Tuning> tuning;
+    /// Matches files with a tempo marker in the range (inclusive).
+    boost::optional<int> minTempo;
+    boost::optional<int> maxTempo;
+    /// Matches files that use the key signature (major / minor and the
+    /// accidentals).
+    boost::optional<KeySignature> keySignature;
+    /// Matches files that use the time signature (the number of beats and the
+    /// beat value).
+    boost::optional<TimeSignature> timeSignature;
+};
+
+/// A summary of the changes made by ScoreLibrary::update().
+struct LibraryUpdateResult
+{
+    LibraryUpdateResult();
+
+    /// The number of supported files that were found.
+    size_t numFiles;
+    /// The number of files that were imported because they are new or were
+    /// modified.
+    size_t numImported;
+    /// The number of files that were removed from the index.
+    size_t numRemoved;
+    /// The files that could not be imported, and the reason for each.
+    std::vector<std::pair<std::string, std::string>> errors;
+    /// Whether the update was cancelled, in which case the index is unchanged.
+    bool cancelled;
+};
+
+/// Receives the progress of ScoreLibrary::update(). The methods may be called
+/// from any of the threads that are importing files.
+class LibraryUpdateListener
+{
+public:
+    virtual ~LibraryUpdateListener();
+
+    /// Called after each file has been checked (and imported, if necessary).
+    virtual void filesChecked(size_t numChecked, size_t numFiles) = 0;
+
+    /// Returns whether the update should be abandoned.
+    virtual bool isCancelled() const = 0;
+};
+
+/// An index of the scores in a set of directories, which can be searched
+/// without opening each file. The index is stored in a single compact file.
+class ScoreLibrary
+{
+public:
+    ScoreLibrary();
+
+    /// Loads the index from a file written by save().
+    /// @throw std::exception if the file can't be read.
+    void load(const std::string &path);
+    /// @throw std::exception if the file can't be written.
+    void save(const std::string &path) const;
+
+    /// Returns the directories that are indexed.
+    const std::vector<std::string> &getDirectories() const;
+    /// Adds a directory to be indexed by the next update(). Trailing
+    /// separators are ignored.
+    void addDirectory(const std::string &dir);
+    /// Removes a directory, along with the entries for any files in it.
+    void removeDirectory(const std::string &dir);
+
+    /// Searches the directories (recursively) for supported files, and
+    /// updates the index. Only new files and files whose contents have changed
+    /// are imported, which is done in parallel. Files that no longer exist are
+    /// removed from the index.
+    LibraryUpdateResult update(const SettingsManager &settings_manager,
+                               LibraryUpdateListener *listener = nullptr);
+
+    /// Returns all of the files in the index, sorted by path.
+    const std::vector<LibraryEntry> &getEntries() const;
+
+    /// Returns the files that match the query, sorted by path.
+    std::vector<const LibraryEntry *> search(const LibraryQuery &query) const;
+
+    template <class Archive>
+    void serialize(Archive &ar, const FileVersion version);
+
+private:
+    /// Rebuilds the lowercase text that is used for text searches.
+    void updateSearchText();
+
+    std::vector<std::string> myDirectories;
+    std::vector<LibraryEntry> myEntries;
+    /// The searchable text for each entry.
+    std::vector<std::string> mySearchText;
+};
+
+template <class Archive>
+void LibraryEntry::serialize(Archive &ar, const FileVersion /*version*/)
+{
+    ar("path", path);
+    ar("modified_time", modifiedTime);
+    ar("file_size", fileSize);
+
+    // The archives only support signed 64-bit integers, but the bits of the
+    // hash can be stored unchanged.
+    int64_t hash = static_cast<int64_t>(contentHash);
+    ar("hash", hash);
+    contentHash = static_cast<uint64_t>(hash);
+
+    ar("score_info", scoreInfo);
+    ar("tunings", tunings);
+    ar("tempos", tempos);
+    ar("key_signatures", keySignatures);
+    ar("time_signatures", timeSignatures);
+}
+
+template <class Archive>
+void ScoreLibrary::serialize(Archive &ar, const FileVersion /*version*/)
+{
+    ar("directories", myDirectories);
+    ar("entries", myEntries);
+}
+
+#endif
@@ -0,0 +1,35 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FORMATS_SETTINGS_H
+#define FORMATS_SETTINGS_H
+
+#include <util/settingstree.h>
+
+/// File format settings and their default values.
+namespace Settings
+{
+    /// Whether .pt2 files are saved in the compact binary encoding rather
+    /// than as JSON.
+    extern const Setting<bool> SavePowerTabAsBinary;
+    /// The gzip compression level (0-9) for .pt2 files.
+    extern const Setting<int> PowerTabCompressionLevel;
+    /// The size (in bytes) of the buffers used when compressing .pt2 files.
+    extern const Setting<int> PowerTabCompressionBufferSize;
+}
+
+#endif
@@ -17,7 +17,10 @@
   
 #include "midievent.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
+#include <utility>
 
 enum Controller : uint8_t
 {
@@ -33,7 +36,15 @@ enum Controller : uint8_t
 enum MetaType : uint8_t
 {
     TrackEnd = 0x2f,
-    SetTempo = 0x51
+    SetTempo = 0x51,
+    TimeSignature = 0x58
+};
+
+/// Internal (non-MIDI) messages that describe a sequence of MIDI events.
+enum ModulationType : uint8_t
+{
+    PitchWheelSweep = 0x01,
+    NoteRepeat = 0x02
 };
 
 static const uint8_t theSysExMsgEnd = 0xf7;
@@ -41,6 +52,26 @@ static const uint8_t theSysExManufacturerId = 0x7d;
 static const uint8_t theChannelMask = 0x0f;
 static const uint8_t theStatusByteMask = ~theChannelMask;
 
+/// Packs an integer parameter for a modulation descriptor. These messages are
+/// never sent to a device, so the values do not need to be 7-bit.
+static void appendInt(std::vector<uint8_t> &data, uint32_t val)
+{
+    data.push_back((val >> 24) & 0xff);
+    data.push_back((val >> 16) & 0xff);
+    data.push_back((val >> 8) & 0xff);
+    data.push_back(val & 0xff);
+}
+
+static int readInt(const std::vector<uint8_t> &data, size_t offset)
+{
+    // Shift unsigned values, since the top byte may set the sign bit.
+    const uint32_t val = (static_cast<uint32_t>(data[offset]) << 24) |
+                         (static_cast<uint32_t>(data[offset + 1]) << 16) |
+                         (static_cast<uint32_t>(data[offset + 2]) << 8) |
+                         static_cast<uint32_t>(data[offset + 3]);
+    return static_cast<int>(val);
+}
+
 MidiEvent::MidiEvent(int ticks, std::vector<uint8_t> data,
                      const SystemLocation &location, int player, int instrument)
     : myTicks(ticks),
@@ -70,6 +101,39 @@ int MidiEvent::getTempo() const
     return myData[5] + (myData[4] << 8) + (myData[3] << 16);
 }
 
+MidiEvent MidiEvent::timeSignature(int ticks, uint8_t beats_per_measure,
+                                   uint8_t beat_value)
+{
+    // The beat value is stored as a power of two.
+    uint8_t exponent = 0;
+    while ((1 << exponent) < beat_value)
+        ++exponent;
+
+    // Use the standard 24 clocks per beat and 8 32nd notes per quarter note.
+    return MidiEvent(ticks, { StatusByte::MetaMessage,
+                              static_cast<uint8_t>(MetaType::TimeSignature), 4,
+                              beats_per_measure, exponent, 24, 8 },
+                     SystemLocation(), -1, -1);
+}
+
+bool MidiEvent::isTimeSignature() const
+{
+    return getStatusByte() == StatusByte::MetaMessage &&
+           myData[1] == MetaType::TimeSignature;
+}
+
+int MidiEvent::getBeatsPerMeasure() const
+{
+    assert(isTimeSignature());
+    return myData[3];
+}
+
+int MidiEvent::getBeatValue() const
+{
+    assert(isTimeSignature());
+    return 1 << myData[4];
+}
+
 bool MidiEvent::isProgramChange() const
 {
     return (getStatusByte() & theStatusByteMask) == StatusByte::ProgramChange;
@@ -155,7 +219,155 @@ MidiEvent MidiEvent::positionChange(int ticks, const SystemLocation &location)
 bool MidiEvent::isPositionChange() const
 {
     return getStatusByte() == StatusByte::SysEx &&
-           myData[1] == theSysExManufacturerId;
+           myData[1] == theSysExManufacturerId && myData[2] == theSysExMsgEnd;
+}
+
+MidiEvent MidiEvent::pitchWheelSweep(int ticks, uint8_t channel,
+                                     uint8_t start_amount, uint8_t end_amount,
+                                     int step_ticks)
+{
+    std::vector<uint8_t> data = { StatusByte::SysEx, theSysExManufacturerId,
+                                  ModulationType::PitchWheelSweep, channel,
+                                  start_amount, end_amount };
+    appendInt(data, step_ticks);
+    data.push_back(theSysExMsgEnd);
+
+    return MidiEvent(ticks, std::move(data), SystemLocation(), -1, -1);
+}
+
+MidiEvent MidiEvent::noteRepeat(int ticks, uint8_t channel, uint8_t pitch,
+                                uint8_t other_pitch, uint8_t velocity,
+                                int step_ticks, int num_steps,
+                                const SystemLocation &location)
+{
+    std::vector<uint8_t> data = { StatusByte::SysEx, theSysExManufacturerId,
+                                  ModulationType::NoteRepeat, channel, pitch,
+                                  other_pitch, velocity };
+    appendInt(data, step_ticks);
+    appendInt(data, num_steps);
+    data.push_back(theSysExMsgEnd);
+
+    return MidiEvent(ticks, std::move(data), location, -1, -1);
+}
+
+bool MidiEvent::isModulation() const
+{
+    return getStatusByte() == StatusByte::SysEx &&
+           myData[1] == theSysExManufacturerId &&
+           (myData[2] == ModulationType::PitchWheelSweep ||
+            myData[2] == ModulationType::NoteRepeat);
+}
+
+void MidiEvent::expandModulation(std::vector<MidiEvent> &events,
+                                 int max_bend_error) const
+{
+    assert(isModulation());
+    const uint8_t channel = myData[3];
+
+    switch (myData[2])
+    {
+        case ModulationType::PitchWheelSweep:
+        {
+            const int start_amount = myData[4];
+            const int end_amount = myData[5];
+            const int step_ticks = readInt(myData, 6);
+            const int direction = (start_amount < end_amount) ? 1 : -1;
+            const int num_steps = std::abs(end_amount - start_amount);
+
+            // Only emit an event when the value has moved far enough from the
+            // previous event. If all of the steps occur at the same tick and
+            // any error is allowed, only the final value matters.
+            const int stride = (step_ticks == 0 && max_bend_error > 0)
+                                   ? num_steps
+                                   : std::max(1, max_bend_error + 1);
+
+            for (int i = stride; ; i += stride)
+            {
+                // Always finish at the end value.
+                i = std::min(i, num_steps);
+
+                events.push_back(pitchWheel(
+                    myTicks + i * step_ticks, channel,
+                    static_cast<uint8_t>(start_amount + i * direction)));
+
+                if (i == num_steps)
+                    break;
+            }
+            break;
+        }
+
+        case ModulationType::NoteRepeat:
+        {
+            uint8_t pitch = myData[4];
+            uint8_t other_pitch = myData[5];
+            const uint8_t velocity = myData[6];
+            const int step_ticks = readInt(myData, 7);
+            const int num_steps = readInt(myData, 11);
+
+            for (int i = 0; i < num_steps; ++i)
+            {
+                const int tick = myTicks + i * step_ticks;
+                events.push_back(noteOff(tick, channel, pitch, myLocation));
+
+                // Alternate to the other pitch (this has no effect for
+                // tremolo picking).
+                std::swap(pitch, other_pitch);
+                events.push_back(
+                    noteOn(tick, channel, pitch, velocity, myLocation));
+            }
+            break;
+        }
+    }
+}
+
+void MidiEvent::clipModulation(std::vector<MidiEvent> &events, int start_tick)
+{
+    // The events may come from several overlapping descriptors.
+    std::stable_sort(events.begin(), events.end());
+
+    std::vector<MidiEvent> clipped;
+    std::vector<const MidiEvent *> pitch_wheel(theChannelMask + 1, nullptr);
+
+    for (const MidiEvent &event : events)
+    {
+        if (event.getTicks() >= start_tick)
+            clipped.push_back(event);
+        else if (event.isPitchWheel())
+            pitch_wheel[event.getChannel()] = &event;
+        // Notes before the start are not played.
+    }
+
+    std::vector<MidiEvent> initial_values;
+    for (const MidiEvent *event : pitch_wheel)
+    {
+        if (event)
+        {
+            initial_values.push_back(*event);
+            initial_values.back().setTicks(start_tick);
+        }
+    }
+
+    clipped.insert(clipped.begin(), initial_values.begin(),
+                   initial_values.end());
+    events = std::move(clipped);
+}
+
+void MidiEvent::recordSkippedEvent(std::vector<MidiEvent> &events,
+                                   int max_bend_error) const
+{
+    if (isModulation())
+        expandModulation(events, max_bend_error);
+    else if (isPitchWheel())
+        events.push_back(*this);
+    else
+        return;
+
+    clipModulation(events, myTicks);
+}
+
+bool MidiEvent::isPitchWheel() const
+{
+    return (getStatusByte() & theStatusByteMask) == StatusByte::PitchWheel;
 }
 
 bool MidiEvent::isNoteOnOff() const
@@ -164,6 +376,31 @@ bool MidiEvent::isNoteOnOff() const
            (getStatusByte() & theStatusByteMask) == StatusByte::NoteOff;
 }
 
+bool MidiEvent::isNoteOn() const
+{
+    return (getStatusByte() & theStatusByteMask) == StatusByte::NoteOn &&
+           myData[2] != 0;
+}
+
+bool MidiEvent::isNoteOff() const
+{
+    return (getStatusByte() & theStatusByteMask) == StatusByte::NoteOff ||
+           ((getStatusByte() & theStatusByteMask) == StatusByte::NoteOn &&
+            myData[2] == 0);
+}
+
+uint8_t MidiEvent::getPitch() const
+{
+    assert(isNoteOnOff());
+    return myData[1];
+}
+
+uint8_t MidiEvent::getPreset() const
+{
+    assert(isProgramChange());
+    return myData[1];
+}
+
 uint8_t MidiEvent::getChannel() const
 {
     return getStatusByte() & theChannelMask;
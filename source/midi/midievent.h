@@ -53,10 +53,51 @@ public:
     bool isProgramChange() const;
     bool isPositionChange() const;
     bool isNoteOnOff() const;
+    /// Returns true for a note on message with a non-zero velocity.
+    bool isNoteOn() const;
+    /// Returns true for a note off message, or a note on message with a
+    /// velocity of zero.
+    bool isNoteOff() const;
+    /// Returns the pitch of a note on / note off message.
+    uint8_t getPitch() const;
+    /// Returns the preset of a program change message.
+    uint8_t getPreset() const;
+    bool isTimeSignature() const;
+    int getBeatsPerMeasure() const;
+    int getBeatValue() const;
+    /// Returns true if this is a modulation descriptor (e.g. a pitch wheel
+    /// sweep or a tremolo picking pattern), which is not a real MIDI message
+    /// and must be expanded with expandModulation() before being sent.
+    bool isModulation() const;
+    bool isPitchWheel() const;
     uint8_t getChannel() const;
 
+    /// Appends the MIDI events described by a modulation descriptor, using
+    /// absolute tick values.
+    /// For pitch wheel sweeps, intermediate steps are skipped as long as the
+    /// pitch wheel value is never off by more than max_bend_error units. With
+    /// the default of 0, every step is generated.
+    void expandModulation(std::vector<MidiEvent> &events,
+                          int max_bend_error = 0) const;
+
+    /// Removes the expanded modulation events that occur before the start
+    /// tick, e.g. when playback starts in the middle of a bend or trill. The
+    /// last pitch wheel value for each channel is moved to the start tick so
+    /// that the remainder of a bend continues from the correct pitch.
+    static void clipModulation(std::vector<MidiEvent> &events, int start_tick);
+
+    /// Records an event that is skipped because it occurs before the start
+    /// location. Pitch wheel events and modulation descriptors (which are
+    /// expanded) are added to the list, which is then clipped to this event's
+    /// tick. The list then holds the current pitch wheel values and the
+    /// remainder of any bends or trills that are still in progress.
+    void recordSkippedEvent(std::vector<MidiEvent> &events,
+                            int max_bend_error = 0) const;
+
     static MidiEvent endOfTrack(int ticks);
     static MidiEvent setTempo(int ticks, int microseconds);
+    static MidiEvent timeSignature(int ticks, uint8_t beats_per_measure,
+                                   uint8_t beat_value);
     static MidiEvent noteOn(int ticks, uint8_t channel, uint8_t pitch,
                             uint8_t velocity, const SystemLocation &location);
     static MidiEvent noteOff(int ticks, uint8_t channel, uint8_t pitch,
@@ -67,6 +108,20 @@ public:
     static MidiEvent holdPedal(int ticks, uint8_t channel, bool enabled);
     static MidiEvent pitchWheel(int ticks, uint8_t channel, uint8_t amount);
     static MidiEvent positionChange(int ticks, const SystemLocation &location);
+
+    /// Describes a series of pitch wheel events, stepping by one unit from
+    /// start_amount to end_amount with the given number of ticks between each
+    /// step. The first event occurs one step after the start tick.
+    static MidiEvent pitchWheelSweep(int ticks, uint8_t channel,
+                                     uint8_t start_amount, uint8_t end_amount,
+                                     int step_ticks);
+    /// Describes a series of repeated notes (used for tremolo picking and
+    /// trills). At each step, the current pitch is stopped and the next pitch
+    /// is played, alternating between the two pitches.
+    static MidiEvent noteRepeat(int ticks, uint8_t channel, uint8_t pitch,
+                                uint8_t other_pitch, uint8_t velocity,
+                                int step_ticks, int num_steps,
+                                const SystemLocation &location);
     static std::vector<MidiEvent> pitchWheelRange(int ticks, uint8_t channel,
                                                   uint8_t semitones);
 
@@ -67,3 +67,23 @@ void MidiEventList::concat(const MidiEventList &other)
     myEvents.insert(myEvents.end(), other.myEvents.begin(),
                     other.myEvents.end());
 }
+
+void MidiEventList::expandModulation(int max_bend_error)
+{
+    assert(myAbsoluteTicks);
+
+    std::vector<MidiEvent> events;
+    events.reserve(myEvents.size());
+
+    // Expand each descriptor in place, so that the relative order of events
+    // with the same timestamp is preserved.
+    for (const MidiEvent &event : myEvents)
+    {
+        if (event.isModulation())
+            event.expandModulation(events, max_bend_error);
+        else
+            events.push_back(event);
+    }
+
+    myEvents = std::move(events);
+}
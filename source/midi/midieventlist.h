@@ -39,6 +39,12 @@ public:
 
     void concat(const MidiEventList &other);
 
+    /// Replaces any modulation descriptors (see MidiEvent::isModulation) with
+    /// the events that they describe. The events must use absolute ticks.
+    void expandModulation(int max_bend_error = 0);
+
+    size_t size() const { return myEvents.size(); }
+
     typedef std::vector<MidiEvent>::iterator iterator;
     typedef std::vector<MidiEvent>::const_iterator const_iterator;
 
@@ -215,6 +215,10 @@ void MidiFile::load(const Score &score, const LoadOptions &options)
     for (MidiEventList &track : myTracks)
     {
         track.append(MidiEvent::endOfTrack(current_tick));
+
+        if (!options.myCompactModulation)
+            track.expandModulation(options.myMaxBendError);
+
         track.convertToDeltaTicks();
     }
 }
@@ -392,16 +396,33 @@ static int getArpeggioOffset(int ppq, int current_tempo)
 }
 
 /// Holds basic information about a bend - used to simplify the generateBends
-/// function.
+/// function. This is either a single pitch wheel event, or a gradual sweep
+/// from the start amount to the bend amount.
 struct BendEventInfo
 {
     BendEventInfo(int tick, uint8_t bend_amount)
-        : myTick(tick), myBendAmount(bend_amount)
+        : myTick(tick),
+          myStartBendAmount(bend_amount),
+          myBendAmount(bend_amount),
+          myStepTicks(0)
+    {
+    }
+
+    BendEventInfo(int tick, uint8_t start_amount, uint8_t bend_amount,
+                  int step_ticks)
+        : myTick(tick),
+          myStartBendAmount(start_amount),
+          myBendAmount(bend_amount),
+          myStepTicks(step_ticks)
     {
     }
 
+    bool isSweep() const { return myStartBendAmount != myBendAmount; }
+
     int myTick;
+    uint8_t myStartBendAmount;
     uint8_t myBendAmount;
+    int myStepTicks;
 };
 
 static void generateGradualBend(std::vector<BendEventInfo> &bends,
@@ -413,13 +434,37 @@ static void generateGradualBend(std::vector<BendEventInfo> &bends,
         return;
 
     const int event_duration = duration / num_events;
-    for (int i = 1; i <= num_events; ++i)
+    bends.push_back(
+        BendEventInfo(start_tick, start_bend, release_bend, event_duration));
+}
+
+/// Ensures that the last pitch wheel event returns to the default bend.
+static void resetFinalBend(std::vector<BendEventInfo> &bends)
+{
+    BendEventInfo &last = bends.back();
+    if (last.myBendAmount == DEFAULT_BEND)
+        return;
+
+    if (!last.isSweep())
+    {
+        last = BendEventInfo(last.myTick, DEFAULT_BEND);
+        return;
+    }
+
+    // Replace the last step of the sweep with an event for the default bend.
+    const int num_steps = std::abs(last.myBendAmount - last.myStartBendAmount);
+    const int end_tick = last.myTick + num_steps * last.myStepTicks;
+
+    if (num_steps == 1)
+        last = BendEventInfo(end_tick, DEFAULT_BEND);
+    else
     {
-        const int tick = start_tick + i * event_duration;
-        if (start_bend < release_bend)
-            bends.push_back(BendEventInfo(tick, start_bend + i));
+        if (last.myStartBendAmount < last.myBendAmount)
+            --last.myBendAmount;
         else
-            bends.push_back(BendEventInfo(tick, start_bend - i));
+            ++last.myBendAmount;
+
+        bends.push_back(BendEventInfo(end_tick, DEFAULT_BEND));
     }
 }
 
@@ -506,7 +551,7 @@ static void generateBends(std::vector<BendEventInfo> &bends,
     {
         // Always return to the default bend, regardless of the release pitch.
         if (!bends.empty())
-            bends.back().myBendAmount = DEFAULT_BEND;
+            resetFinalBend(bends);
         active_bend = DEFAULT_BEND;
     }
 }
@@ -815,10 +860,21 @@ int MidiFile::addEventsForBar(
                 {
                     for (const ActivePlayer &player : active_players)
                     {
-                        tracks[player.getPlayerNumber()].append(
-                            MidiEvent::pitchWheel(event.myTick,
-                                                  getChannel(player),
-                                                  event.myBendAmount));
+                        if (event.isSweep())
+                        {
+                            tracks[player.getPlayerNumber()].append(
+                                MidiEvent::pitchWheelSweep(
+                                    event.myTick, getChannel(player),
+                                    event.myStartBendAmount,
+                                    event.myBendAmount, event.myStepTicks));
+                        }
+                        else
+                        {
+                            tracks[player.getPlayerNumber()].append(
+                                MidiEvent::pitchWheel(event.myTick,
+                                                      getChannel(player),
+                                                      event.myBendAmount));
+                        }
                     }
                 }
             }
@@ -840,29 +896,22 @@ int MidiFile::addEventsForBar(
                         pitch + (note.getTrilledFret() - note.getFretNumber());
                 }
 
-                for (int i = 0; i < num_notes; ++i)
+                if (num_notes > 0)
                 {
-                    const int tick = current_tick + i * trem_pick_duration;
-
                     for (const ActivePlayer &player : active_players)
                     {
                         tracks[player.getPlayerNumber()].append(
-                            MidiEvent::noteOff(tick,
-                                               getChannel(player), pitch,
-                                               system_location));
+                            MidiEvent::noteRepeat(
+                                current_tick, getChannel(player), pitch,
+                                other_pitch, velocity, trem_pick_duration,
+                                num_notes, system_location));
                     }
+                }
 
-                    // Alternate to the other pitch (this has no effect for
-                    // tremolo picking).
+                // The note that is stopped at the end is the last pitch that
+                // was alternated to.
+                if (num_notes % 2 != 0)
                     std::swap(pitch, other_pitch);
-
-                    for (const ActivePlayer &player : active_players)
-                    {
-                        tracks[player.getPlayerNumber()].append(
-                            MidiEvent::noteOn(tick, getChannel(player), pitch,
-                                              velocity, system_location));
-                    }
-                }
             }
 
             bool tied_to_next_note = false;
@@ -42,7 +42,9 @@ public:
               myStrongAccentVel(0),
               myWeakAccentVel(0),
               myMetronomePreset(0),
-              myRecordPositionChanges(false)
+              myRecordPositionChanges(false),
+              myCompactModulation(false),
+              myMaxBendError(0)
         {
         }
 
@@ -53,6 +55,14 @@ public:
         uint8_t myWeakAccentVel;
         uint8_t myMetronomePreset;
         bool myRecordPositionChanges;
+        /// If enabled, bends, slides, trills and tremolo picking are left as
+        /// modulation descriptors (see MidiEvent::isModulation) rather than
+        /// being expanded into individual events.
+        bool myCompactModulation;
+        /// The maximum error (in pitch wheel units) that is allowed when
+        /// generating the events for gradual bends and slides. Larger values
+        /// produce fewer pitch wheel events.
+        int myMaxBendError;
     };
 
     MidiFile();
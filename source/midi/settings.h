@@ -0,0 +1,37 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MIDI_SETTINGS_H
+#define MIDI_SETTINGS_H
+
+#include <util/settingstree.h>
+
+/// Settings that affect the generated MIDI events, which are used both for
+/// playback and for exporting MIDI files.
+namespace Settings
+{
+    extern const Setting<int> MidiVibratoLevel;
+    extern const Setting<int> MidiWideVibratoLevel;
+    extern const Setting<int> MidiBendTolerance;
+
+    extern const Setting<bool> MetronomeEnabled;
+    extern const Setting<int> MetronomePreset;
+    extern const Setting<int> MetronomeStrongAccent;
+    extern const Setting<int> MetronomeWeakAccent;
+}
+
+#endif
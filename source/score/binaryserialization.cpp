@@ -0,0 +1,92 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "binaryserialization.h"
+
+namespace ScoreUtils
+{
+/// Identifies a binary archive. The first byte can never appear at the start
+/// of a JSON document.
+static const std::array<uint8_t, 4> theMagic = { { 0x89, 'P', 'T', 'B' } };
+
+bool isBinaryArchive(std::istream &is)
+{
+    return is.peek() == theMagic[0];
+}
+
+BinaryInputArchive::BinaryInputArchive(std::istream &is)
+    : myBuffer(is.rdbuf()), myVersion(FileVersion::INITIAL_VERSION)
+{
+    if (!is)
+        throw std::runtime_error("Could not open stream");
+
+    for (uint8_t c : theMagic)
+    {
+        if (readByte() != c)
+            throw std::runtime_error("Invalid binary archive");
+    }
+
+    int version;
+    read(version);
+    myVersion = static_cast<FileVersion>(version);
+}
+
+FileVersion BinaryInputArchive::version() const
+{
+    return myVersion;
+}
+
+const std::string &BinaryInputArchive::readName()
+{
+    const uint64_t id = readVarUInt();
+
+    // The first time that a name is used, its contents are stored inline.
+    if (id == myNames.size())
+    {
+        std::string name;
+        read(name);
+        myNames.push_back(std::move(name));
+    }
+    else if (id > myNames.size())
+        throw std::runtime_error("Invalid field name");
+
+    return myNames[id];
+}
+
+BinaryOutputArchive::BinaryOutputArchive(std::ostream &os, FileVersion version)
+    : myStream(os), myBuffer(os.rdbuf()), myVersion(version)
+{
+    for (uint8_t c : theMagic)
+        writeByte(c);
+
+    write(static_cast<int>(myVersion));
+}
+
+void BinaryOutputArchive::writeName(const std::string &name)
+{
+    auto it = myNames.find(name);
+    if (it != myNames.end())
+        writeVarUInt(it->second);
+    else
+    {
+        const uint32_t id = static_cast<uint32_t>(myNames.size());
+        myNames.emplace(name, id);
+        writeVarUInt(id);
+        write(name);
+    }
+}
+}
@@ -0,0 +1,475 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCORE_BINARYSERIALIZATION_H
+#define SCORE_BINARYSERIALIZATION_H
+
+#include <array>
+#include <bitset>
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/optional.hpp>
+#include <cstdint>
+#include "fileversion.h"
+#include <istream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+/// A compact binary alternative to the JSON archives in serialization.h, which
+/// works with the same serialize() methods.
+///
+/// The data is read and written in the order of the serialize() calls, so no
+/// document tree is needed. Integers are stored as variable-length
+/// quantities, arrays are prefixed with their length, and each field name is
+/// only written out the first time it is used (afterwards, it is referred to
+/// by its index).
+namespace ScoreUtils
+{
+/// Returns whether the stream contains a binary archive rather than JSON.
+/// This only peeks at the stream, and does not consume any data.
+bool isBinaryArchive(std::istream &is);
+
+class BinaryInputArchive
+{
+public:
+    BinaryInputArchive(std::istream &is);
+
+    FileVersion version() const;
+
+    template <typename T>
+    void operator()(const char *expectedName, T &obj)
+    {
+        const std::string &name = readName();
+        if (name != expectedName)
+        {
+            throw std::runtime_error(
+                std::string("Unexpected or missing data: found ") + name +
+                ", expected " + expectedName);
+        }
+
+        read(obj);
+    }
+
+    template <typename T>
+    void operator()(const std::string &expectedName, T &obj)
+    {
+        (*this)(expectedName.c_str(), obj);
+    }
+
+private:
+    inline uint8_t readByte();
+    inline uint64_t readVarUInt();
+    inline int64_t readVarInt();
+    const std::string &readName();
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value>::type read(T &val);
+
+    inline void read(bool &val);
+    inline void read(std::string &str);
+
+    template <typename T>
+    void read(std::vector<T> &vec);
+
+    template <typename K, typename V, typename C>
+    void read(std::map<K, V, C> &map);
+
+    template <typename T, size_t N>
+    void read(std::array<T, N> &arr);
+
+    template <size_t N>
+    void read(std::bitset<N> &bits);
+
+    template <typename T>
+    void read(boost::optional<T> &val);
+
+    template <typename T>
+    void read(std::shared_ptr<T> &val);
+
+    inline void read(boost::gregorian::date &date);
+
+    template <typename T>
+    typename std::enable_if<std::is_enum<T>::value>::type read(T &val)
+    {
+        int int_val;
+        read(int_val);
+        val = static_cast<T>(int_val);
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_class<T>::value>::type read(T &obj)
+    {
+        obj.serialize(*this, myVersion);
+    }
+
+    std::streambuf *myBuffer;
+    FileVersion myVersion;
+    /// The field names that have been read so far, indexed by id.
+    std::vector<std::string> myNames;
+};
+
+template <typename T>
+void loadBinary(std::istream &input, const std::string &name, T &obj)
+{
+    BinaryInputArchive archive(input);
+    if (archive.version() > FileVersion::LATEST_VERSION ||
+        archive.version() < FileVersion::INITIAL_VERSION)
+    {
+        throw std::runtime_error("Invalid file version");
+    }
+
+    archive(name, obj);
+}
+
+/// Loads the first members of an object without reading the rest of the
+/// data, like loadPartial() for JSON. Since the members are read in order
+/// and objects have no closing marker, loadBinary() already stops there.
+template <typename T>
+void loadBinaryPartial(std::istream &input, const std::string &name, T &obj)
+{
+    loadBinary(input, name, obj);
+}
+
+class BinaryOutputArchive
+{
+public:
+    BinaryOutputArchive(std::ostream &os, FileVersion version);
+
+    template <typename T>
+    void operator()(const std::string &name, const T &obj)
+    {
+        writeName(name);
+        write(obj);
+    }
+
+private:
+    inline void writeByte(uint8_t val);
+    inline void writeVarUInt(uint64_t val);
+    inline void writeVarInt(int64_t val);
+    void writeName(const std::string &name);
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value>::type write(T val)
+    {
+        writeVarInt(static_cast<int64_t>(val));
+    }
+
+    inline void write(bool val);
+    inline void write(const std::string &str);
+
+    template <typename T>
+    void write(const std::vector<T> &vec);
+
+    template <typename K, typename V, typename C>
+    void write(const std::map<K, V, C> &map);
+
+    template <typename T, size_t N>
+    void write(const std::array<T, N> &arr);
+
+    template <size_t N>
+    void write(const std::bitset<N> &bits);
+
+    template <typename T>
+    void write(const boost::optional<T> &val);
+
+    template <typename T>
+    void write(const std::shared_ptr<T> &val);
+
+    inline void write(const boost::gregorian::date &date);
+
+    template <typename T>
+    typename std::enable_if<std::is_enum<T>::value>::type write(const T &val)
+    {
+        write(static_cast<int>(val));
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_class<T>::value>::type write(const T &obj)
+    {
+        const_cast<T &>(obj).serialize(*this, myVersion);
+    }
+
+    std::ostream &myStream;
+    std::streambuf *myBuffer;
+    const FileVersion myVersion;
+    /// Maps each field name that has been written to its id.
+    std::unordered_map<std::string, uint32_t> myNames;
+};
+
+template <typename T>
+void saveBinary(std::ostream &output, const std::string &name, const T &obj)
+{
+    BinaryOutputArchive ar(output, FileVersion::LATEST_VERSION);
+    ar(name, obj);
+}
+
+uint8_t BinaryInputArchive::readByte()
+{
+    const auto c = myBuffer->sbumpc();
+    if (c == std::char_traits<char>::eof())
+        throw std::runtime_error("Unexpected end of file");
+
+    return static_cast<uint8_t>(c);
+}
+
+uint64_t BinaryInputArchive::readVarUInt()
+{
+    uint64_t val = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        const uint8_t byte = readByte();
+        val |= static_cast<uint64_t>(byte & 0x7f) << shift;
+
+        if (!(byte & 0x80))
+            return val;
+    }
+
+    throw std::runtime_error("Invalid variable-length integer");
+}
+
+int64_t BinaryInputArchive::readVarInt()
+{
+    // Undo the zigzag encoding.
+    const uint64_t val = readVarUInt();
+    return static_cast<int64_t>(val >> 1) ^ -static_cast<int64_t>(val & 1);
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value>::type
+BinaryInputArchive::read(T &val)
+{
+    typedef std::numeric_limits<T> Limits;
+
+    const int64_t int_val = readVarInt();
+    if (int_val < static_cast<int64_t>(Limits::min()) ||
+        (int_val > 0 &&
+         static_cast<uint64_t>(int_val) > static_cast<uint64_t>(Limits::max())))
+    {
+        throw std::overflow_error("Invalid integer value");
+    }
+
+    val = static_cast<T>(int_val);
+}
+
+void BinaryInputArchive::read(bool &val)
+{
+    val = readByte() != 0;
+}
+
+void BinaryInputArchive::read(std::string &str)
+{
+    const uint64_t length = readVarUInt();
+
+    // Read in chunks, so that a corrupt length can't cause a huge allocation.
+    str.clear();
+    char chunk[256];
+    uint64_t remaining = length;
+    while (remaining > 0)
+    {
+        const std::streamsize n = static_cast<std::streamsize>(
+            std::min<uint64_t>(remaining, sizeof(chunk)));
+        if (myBuffer->sgetn(chunk, n) != n)
+            throw std::runtime_error("Unexpected end of file");
+
+        str.append(chunk, static_cast<size_t>(n));
+        remaining -= n;
+    }
+}
+
+template <typename T>
+void BinaryInputArchive::read(std::vector<T> &vec)
+{
+    const uint64_t size = readVarUInt();
+
+    vec.clear();
+    vec.reserve(static_cast<size_t>(std::min<uint64_t>(size, 1024)));
+    for (uint64_t i = 0; i < size; ++i)
+    {
+        vec.emplace_back();
+        read(vec.back());
+    }
+}
+
+template <typename K, typename V, typename C>
+void BinaryInputArchive::read(std::map<K, V, C> &map)
+{
+    const uint64_t size = readVarUInt();
+
+    map.clear();
+    for (uint64_t i = 0; i < size; ++i)
+    {
+        const K key = boost::lexical_cast<K>(readName());
+        read(map[key]);
+    }
+}
+
+template <typename T, size_t N>
+void BinaryInputArchive::read(std::array<T, N> &arr)
+{
+    for (T &val : arr)
+        read(val);
+}
+
+template <size_t N>
+void BinaryInputArchive::read(std::bitset<N> &bits)
+{
+    bits.reset();
+
+    for (size_t i = 0; i < N; i += 8)
+    {
+        const uint8_t byte = readByte();
+        for (size_t j = 0; j < 8 && i + j < N; ++j)
+            bits[i + j] = (byte >> j) & 1;
+    }
+}
+
+template <typename T>
+void BinaryInputArchive::read(boost::optional<T> &val)
+{
+    bool has_value;
+    read(has_value);
+
+    if (has_value)
+    {
+        T data;
+        read(data);
+        val.reset(data);
+    }
+    else
+        val.reset();
+}
+
+template <typename T>
+void BinaryInputArchive::read(std::shared_ptr<T> &val)
+{
+    auto data = std::make_shared<typename std::remove_const<T>::type>();
+    read(*data);
+    val = std::move(data);
+}
+
+void BinaryInputArchive::read(boost::gregorian::date &date)
+{
+    std::string date_str;
+    read(date_str);
+    date = boost::gregorian::from_undelimited_string(date_str);
+}
+
+void BinaryOutputArchive::writeByte(uint8_t val)
+{
+    if (myBuffer->sputc(static_cast<char>(val)) ==
+        std::char_traits<char>::eof())
+    {
+        myStream.setstate(std::ios::badbit);
+    }
+}
+
+void BinaryOutputArchive::writeVarUInt(uint64_t val)
+{
+    while (val >= 0x80)
+    {
+        writeByte(static_cast<uint8_t>(val | 0x80));
+        val >>= 7;
+    }
+
+    writeByte(static_cast<uint8_t>(val));
+}
+
+void BinaryOutputArchive::writeVarInt(int64_t val)
+{
+    // Use zigzag encoding so that small negative numbers are also compact.
+    writeVarUInt((static_cast<uint64_t>(val) << 1) ^
+                 static_cast<uint64_t>(val >> 63));
+}
+
+void BinaryOutputArchive::write(bool val)
+{
+    writeByte(val ? 1 : 0);
+}
+
+void BinaryOutputArchive::write(const std::string &str)
+{
+    writeVarUInt(str.length());
+
+    const auto length = static_cast<std::streamsize>(str.length());
+    if (myBuffer->sputn(str.data(), length) != length)
+        myStream.setstate(std::ios::badbit);
+}
+
+template <typename T>
+void BinaryOutputArchive::write(const std::vector<T> &vec)
+{
+    writeVarUInt(vec.size());
+    for (const T &obj : vec)
+        write(obj);
+}
+
+template <typename K, typename V, typename C>
+void BinaryOutputArchive::write(const std::map<K, V, C> &map)
+{
+    writeVarUInt(map.size());
+    for (const auto &pair : map)
+        (*this)(std::to_string(pair.first), pair.second);
+}
+
+template <typename T, size_t N>
+void BinaryOutputArchive::write(const std::array<T, N> &arr)
+{
+    for (const T &val : arr)
+        write(val);
+}
+
+template <size_t N>
+void BinaryOutputArchive::write(const std::bitset<N> &bits)
+{
+    for (size_t i = 0; i < N; i += 8)
+    {
+        uint8_t byte = 0;
+        for (size_t j = 0; j < 8 && i + j < N; ++j)
+            byte |= static_cast<uint8_t>(bits[i + j]) << j;
+
+        writeByte(byte);
+    }
+}
+
+template <typename T>
+void BinaryOutputArchive::write(const boost::optional<T> &val)
+{
+    write(static_cast<bool>(val));
+    if (val)
+        write(*val);
+}
+
+template <typename T>
+void BinaryOutputArchive::write(const std::shared_ptr<T> &val)
+{
+    write(*val);
+}
+
+void BinaryOutputArchive::write(const boost::gregorian::date &date)
+{
+    write(boost::gregorian::to_iso_string(date));
+}
+}
+
+#endif
@@ -17,6 +17,8 @@
 
 #include "score.h"
 
+#include <algorithm>
+
 const int Score::MIN_LINE_SPACING = 6;
 const int Score::MAX_LINE_SPACING = 14;
 
@@ -27,13 +29,32 @@ Score::Score()
 
 bool Score::operator==(const Score &other) const
 {
-    return myScoreInfo == other.myScoreInfo && mySystems == other.mySystems &&
+    return myScoreInfo == other.myScoreInfo &&
+           mySystems.size() == other.mySystems.size() &&
+           std::equal(mySystems.begin(), mySystems.end(),
+                      other.mySystems.begin(),
+                      [](const SystemHandle &system1,
+                         const SystemHandle &system2) {
+                          return system1 == system2 || *system1 == *system2;
+                      }) &&
            myPlayers == other.myPlayers &&
            myInstruments == other.myInstruments &&
            myLineSpacing == other.myLineSpacing &&
            myViewFilters == other.myViewFilters;
 }
 
+std::unique_ptr<Score> Score::clone() const
+{
+    std::unique_ptr<Score> copy(new Score());
+    copy->myScoreInfo = myScoreInfo;
+    copy->mySystems = mySystems;
+    copy->myPlayers = myPlayers;
+    copy->myInstruments = myInstruments;
+    copy->myLineSpacing = myLineSpacing;
+    copy->myViewFilters = myViewFilters;
+    return copy;
+}
+
 const ScoreInfo &Score::getScoreInfo() const
 {
     return myScoreInfo;
@@ -46,20 +67,49 @@ void Score::setScoreInfo(const ScoreInfo &info)
 
 boost::iterator_range<Score::SystemIterator> Score::getSystems()
 {
-    return boost::make_iterator_range(mySystems);
+    return boost::make_iterator_range(SystemIterator(mySystems.begin()),
+                                      SystemIterator(mySystems.end()));
 }
 
 boost::iterator_range<Score::SystemConstIterator> Score::getSystems() const
 {
-    return boost::make_iterator_range(mySystems);
+    return boost::make_iterator_range(SystemConstIterator(mySystems.begin()),
+                                      SystemConstIterator(mySystems.end()));
+}
+
+Score::SystemHandle Score::getSystemHandle(int index) const
+{
+    return mySystems.at(index);
+}
+
+void Score::setSystem(int index, SystemHandle system)
+{
+    mySystems.at(index) = std::move(system);
+}
+
+void Score::restoreSystem(int index, const SystemHandle &system)
+{
+    SystemHandle &current = mySystems.at(index);
+    if (current == system)
+        return;
+
+    if (current.use_count() == 1)
+        const_cast<System &>(*current) = *system;
+    else
+        current = system;
 }
 
 void Score::insertSystem(const System &system, int index)
+{
+    insertSystem(std::make_shared<System>(system), index);
+}
+
+void Score::insertSystem(SystemHandle system, int index)
 {
     if (index < 0)
-        mySystems.push_back(system);
+        mySystems.push_back(std::move(system));
     else
-        mySystems.insert(mySystems.begin() + index, system);
+        mySystems.insert(mySystems.begin() + index, std::move(system));
 }
 
 void Score::removeSystem(int index)
@@ -180,32 +230,29 @@ const PlayerChange *ScoreUtils::getCurrentPlayers(const Score &score,
 void ScoreUtils::adjustRehearsalSigns(Score &score)
 {
     std::string letters;
-    char letter = 'Z';
-
     for (System &system : score.getSystems())
+        adjustRehearsalSigns(system, letters);
+}
+
+void ScoreUtils::adjustRehearsalSigns(System &system, std::string &letters)
+{
+    for (Barline &barline : system.getBarlines())
     {
-        for (Barline &barline : system.getBarlines())
+        if (barline.hasRehearsalSign())
         {
-            if (barline.hasRehearsalSign())
+            RehearsalSign &sign = barline.getRehearsalSign();
+
+            // Cycle through the letters A-Z, and then to AA, AB, etc.
+            if (letters.empty() || letters.back() == 'Z')
             {
-                RehearsalSign &sign = barline.getRehearsalSign();
-
-                // Cycle through the letters A-Z, and then to AA, AB, etc.
-                if (letter == 'Z')
-                {
-                    letter = 'A';
-					if (!letters.empty())
-						letters.back() = letter;
-                    letters.push_back(letter);
-                }
-                else
-                {
-                    ++letter;
-					letters.back() = letter;
-                }
-
-                sign.setLetters(letters);
+                if (!letters.empty())
+                    letters.back() = 'A';
+                letters.push_back('A');
             }
+            else
+                ++letters.back();
+
+            sign.setLetters(letters);
         }
     }
 }
@@ -18,12 +18,15 @@
 #ifndef SCORE_SCORE_H
 #define SCORE_SCORE_H
 
+#include <boost/iterator/indirect_iterator.hpp>
 #include <boost/range/iterator_range_core.hpp>
 #include "fileversion.h"
 #include "instrument.h"
+#include <memory>
 #include "player.h"
 #include "scoreinfo.h"
 #include "system.h"
+#include <util/copyonwrite.h>
 #include "viewfilter.h"
 #include <vector>
 
@@ -32,8 +35,20 @@ class PlayerChange;
 class Score
 {
 public:
-    typedef std::vector<System>::iterator SystemIterator;
-    typedef std::vector<System>::const_iterator SystemConstIterator;
+    /// The systems are stored behind shared handles, so that cloning the
+    /// score or keeping a copy of a system (e.g. for undo) is cheap. Accessing
+    /// a system through a non-const score copies it if it is shared, so a
+    /// mutable reference to a system must not be held across a call to
+    /// clone() or getSystemHandle(), and read-only code should use a const
+    /// score. Undo commands put their original systems back with
+    /// restoreSystem(), so references to a system remain valid across an
+    /// undo.
+    typedef std::shared_ptr<const System> SystemHandle;
+    typedef Util::CopyOnWriteIterator<System,
+                                      std::vector<SystemHandle>::iterator>
+        SystemIterator;
+    typedef boost::indirect_iterator<std::vector<SystemHandle>::const_iterator>
+        SystemConstIterator;
     typedef std::vector<Player>::iterator PlayerIterator;
     typedef std::vector<Player>::const_iterator PlayerConstIterator;
     typedef std::vector<Instrument>::iterator InstrumentIterator;
@@ -46,6 +61,12 @@ public:
     Score &operator=(const Score &other) = delete;
     bool operator==(const Score &other) const;
 
+    /// Returns a copy of the score. Scores can't be copied implicitly, but a
+    /// snapshot is needed e.g. to save in the background while the original
+    /// continues to be edited. The systems are shared with the copy until
+    /// they are modified.
+    std::unique_ptr<Score> clone() const;
+
     template <class Archive>
     void serialize(Archive &ar, const FileVersion version);
 
@@ -59,8 +80,20 @@ public:
     /// Returns the set of systems in the score.
     boost::iterator_range<SystemConstIterator> getSystems() const;
 
+    /// Returns a handle to the specified system, which shares its storage
+    /// with the score until either is modified.
+    SystemHandle getSystemHandle(int index) const;
+    /// Replaces the specified system, sharing the handle's storage.
+    void setSystem(int index, SystemHandle system);
+    /// Copies the handle's contents into the specified system, keeping the
+    /// existing System object if it isn't shared. If it is shared, the other
+    /// owners keep the existing object alive and the handle is shared instead.
+    void restoreSystem(int index, const SystemHandle &system);
+
     /// Adds a new system to the score, optionally at a specific index.
     void insertSystem(const System &system, int index = -1);
+    /// Adds a system to the score without copying it.
+    void insertSystem(SystemHandle system, int index = -1);
     /// Removes the specified system from the score.
     void removeSystem(int index);
 
@@ -107,7 +140,7 @@ public:
 private:
     // TODO - add font settings, chord diagrams, etc.
     ScoreInfo myScoreInfo;
-    std::vector<System> mySystems;
+    std::vector<SystemHandle> mySystems;
     std::vector<Player> myPlayers;
     std::vector<Instrument> myInstruments;
     int myLineSpacing; ///< Spacing between tab lines (in pixels).
@@ -136,6 +169,11 @@ const PlayerChange *getCurrentPlayers(const Score &score, int systemIndex,
 /// (i.e. assigning rehearsal signs the letters "A", "B", and so on).
 void adjustRehearsalSigns(Score &score);
 
+/// Assigns the rehearsal sign letters for a single system, continuing on from
+/// the letters of the previous system. This allows the signs to be lettered
+/// as the systems are created, starting with an empty string.
+void adjustRehearsalSigns(System &system, std::string &letters);
+
 /// Add the standard view filters (guitar and bass) to the score.
 void addStandardFilters(Score &score);
 }
@@ -79,6 +79,7 @@ const Position *ScoreLocation::getPosition() const
 
 Position *ScoreLocation::getPosition()
 {
+    detachSystem();
     return const_cast<Position *>(
                 const_cast<const ScoreLocation &>(*this).getPosition());
 }
@@ -93,7 +94,7 @@ const Position *ScoreLocation::findMultiBarRest() const
     {
         for (const Voice &voice : staff.getVoices())
         {
-            for (const Position &pos : ScoreUtils::findInRange(
+            for (const Position &pos : ScoreUtils::findInSortedRange(
                      voice.getPositions(), bar->getPosition(),
                      nextBar->getPosition()))
             {
@@ -116,9 +117,9 @@ bool ScoreLocation::isEmptyBar() const
     {
         for (const Voice &voice : staff.getVoices())
         {
-            if (!ScoreUtils::findInRange(voice.getPositions(),
-                                         bar->getPosition(),
-                                         nextBar->getPosition()).empty())
+            if (!ScoreUtils::findInSortedRange(voice.getPositions(),
+                                               bar->getPosition(),
+                                               nextBar->getPosition()).empty())
             {
                 return false;
             }
@@ -145,6 +146,8 @@ bool ScoreLocation::hasSelection() const
 
 std::vector<Position *> ScoreLocation::getSelectedPositions()
 {
+    detachSystem();
+
     // Avoid duplicate logic between const and non-const versions.
     auto positions = const_cast<const ScoreLocation *>(this)->getSelectedPositions();
     std::vector<Position *> nc_positions;
@@ -268,25 +271,38 @@ const Note *ScoreLocation::getNote() const
 
 Note *ScoreLocation::getNote()
 {
+    detachSystem();
     return const_cast<Note *>(
                 const_cast<const ScoreLocation &>(*this).getNote());
 }
 
 std::vector<Note *> ScoreLocation::getSelectedNotes()
 {
-    std::vector<Note *> notes;
+    detachSystem();
+
+    // Avoid duplicate logic between const and non-const versions.
+    auto notes = const_cast<const ScoreLocation *>(this)->getSelectedNotes();
+    std::vector<Note *> nc_notes;
+    for (const Note *note : notes)
+        nc_notes.push_back(const_cast<Note *>(note));
+
+    return nc_notes;
+}
+
+std::vector<const Note *> ScoreLocation::getSelectedNotes() const
+{
+    std::vector<const Note *> notes;
 
     if (!hasSelection())
     {
-        if (getNote())
-            notes.push_back(getNote());
+        if (const Note *note = getNote())
+            notes.push_back(note);
     }
     else
     {
-        std::vector<Position *> selectedPositions(getSelectedPositions());
-        for (Position *pos : selectedPositions)
+        for (const Position *pos : getSelectedPositions())
         {
-            for (Note &note : pos->getNotes())
+            for (const Note &note : pos->getNotes())
                 notes.push_back(&note);
         }
     }
@@ -294,6 +310,12 @@ std::vector<Note *> ScoreLocation::getSelectedNotes()
     return notes;
 }
 
+void ScoreLocation::detachSystem()
+{
+    if (myWriteableScore)
+        getSystem();
+}
+
 int ScoreLocation::getVoiceIndex() const
 {
     return myVoiceIndex;
@@ -30,6 +30,12 @@ class Staff;
 class System;
 class Voice;
 
+/// Identifies a position (and optionally a selection) within a score.
+///
+/// The score's systems are shared with e.g. the score area and the undo
+/// stack, so the non-const accessors copy the current system if it is shared
+/// before giving mutable access to it. Code that only reads from the score
+/// should use a const location, so that nothing is copied.
 class ScoreLocation
 {
 public:
@@ -86,8 +92,13 @@ public:
     const Note *getNote() const;
     Note *getNote();
     std::vector<Note *> getSelectedNotes();
+    std::vector<const Note *> getSelectedNotes() const;
 
 private:
+    /// Copies the current system if it is shared, before returning a mutable
+    /// pointer that was found through the const accessors.
+    void detachSystem();
+
     const Score &myScore;
     Score *myWriteableScore;
 
@@ -21,23 +21,112 @@
 
 namespace ScoreUtils
 {
-InputArchive::InputArchive(std::istream &is) : myStream(is)
+/// Records each event from rapidjson's reader into a token.
+class InputArchive::TokenHandler
 {
-    if (!is)
-        throw std::runtime_error("Could not open stream");
+public:
+    TokenHandler(Token &token) : myToken(token)
+    {
+    }
+
+    bool Null()
+    {
+        return set(Token::Null);
+    }
+
+    bool Bool(bool b)
+    {
+        myToken.boolValue = b;
+        return set(Token::Bool);
+    }
+
+    bool Int(int i)
+    {
+        return Int64(i);
+    }
+
+    bool Uint(unsigned int i)
+    {
+        return Int64(i);
+    }
+
+    bool Int64(int64_t i)
+    {
+        myToken.intValue = i;
+        return set(Token::Integer);
+    }
+
+    bool Uint64(uint64_t i)
+    {
+        if (i > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+            return set(Token::Number);
+
+        return Int64(static_cast<int64_t>(i));
+    }
+
+    bool Double(double)
+    {
+        return set(Token::Number);
+    }
+
+    bool RawNumber(const char *, rapidjson::SizeType, bool)
+    {
+        return set(Token::Number);
+    }
+
+    bool String(const char *str, rapidjson::SizeType length, bool)
+    {
+        myToken.str.assign(str, length);
+        return set(Token::String);
+    }
+
+    bool Key(const char *str, rapidjson::SizeType length, bool)
+    {
+        myToken.str.assign(str, length);
+        return set(Token::Key);
+    }
 
-    myDocument.ParseStream<0>(myStream);
+    bool StartObject()
+    {
+        return set(Token::StartObject);
+    }
 
-    if (myDocument.HasParseError())
+    bool EndObject(rapidjson::SizeType)
     {
-        throw std::runtime_error("Parse error at offset " +
-                                 std::to_string(myDocument.GetErrorOffset()) +
-                                 ": " +
-                                 GetParseError_En(myDocument.GetParseError()));
+        return set(Token::EndObject);
     }
 
-    myIterators.push(myDocument.MemberBegin());
+    bool StartArray()
+    {
+        return set(Token::StartArray);
+    }
 
+    bool EndArray(rapidjson::SizeType)
+    {
+        return set(Token::EndArray);
+    }
+
+private:
+    bool set(Token::Type type)
+    {
+        myToken.type = type;
+        return true;
+    }
+
+    Token &myToken;
+};
+
+InputArchive::InputArchive(std::istream &is)
+    : myStream(is),
+      myHasToken(false),
+      myVersion(FileVersion::INITIAL_VERSION)
+{
+    if (!is)
+        throw std::runtime_error("Could not open stream");
+
+    myReader.IterativeParseInit();
+
+    beginObject();
     (*this)("version", myVersion);
 }
 
@@ -46,16 +135,110 @@ FileVersion InputArchive::version() const
     return myVersion;
 }
 
-OutputArchive::OutputArchive(std::ostream &os, FileVersion version)
-    : myWriteStream(os), myStream(myWriteStream), myVersion(version)
+const InputArchive::Token &InputArchive::peek()
 {
-    myStream.StartObject();
+    if (myHasToken)
+        return myToken;
 
-    (*this)("version", myVersion);
+    if (myReader.IterativeParseComplete())
+        parseError("Unexpected end of data");
+
+    TokenHandler handler(myToken);
+    if (!myReader.IterativeParseNext<rapidjson::kParseDefaultFlags>(myStream,
+                                                                    handler))
+    {
+        throw std::runtime_error(
+            "Parse error at offset " +
+            std::to_string(myReader.GetErrorOffset()) + ": " +
+            rapidjson::GetParseError_En(myReader.GetParseErrorCode()));
+    }
+
+    myHasToken = true;
+    return myToken;
+}
+
+const InputArchive::Token &InputArchive::take()
+{
+    const Token &token = peek();
+    myHasToken = false;
+    return token;
+}
+
+const InputArchive::Token &InputArchive::expect(Token::Type type,
+                                                const char *description)
+{
+    const Token &token = take();
+    if (token.type != type)
+        parseError(std::string("Expected ") + description);
+
+    return token;
+}
+
+void InputArchive::parseError(const std::string &msg) const
+{
+    throw std::runtime_error("Parse error at offset " +
+                             std::to_string(myStream.Tell()) + ": " + msg);
+}
+
+void InputArchive::beginObject()
+{
+    expect(Token::StartObject, "an object");
+}
+
+void InputArchive::endObject()
+{
+    // Skip any members that weren't read (e.g. from a newer file version).
+    while (take().type != Token::EndObject)
+        skipValue();
+}
+
+void InputArchive::readName(const char *expectedName)
+{
+    const Token &token = take();
+    if (token.type != Token::Key || token.str != expectedName)
+    {
+        throw std::runtime_error(
+            std::string("Unexpected or missing JSON data: found ") +
+            (token.type == Token::Key ? token.str : "end of object") +
+            ", expected " + expectedName);
+    }
+}
+
+void InputArchive::skipValue()
+{
+    int depth = 0;
+    do
+    {
+        switch (take().type)
+        {
+        case Token::StartObject:
+        case Token::StartArray:
+            ++depth;
+            break;
+        case Token::EndObject:
+        case Token::EndArray:
+            --depth;
+            break;
+        default:
+            break;
+        }
+    } while (depth > 0);
+}
+
+void InputArchive::read(bool &val)
+{
+    val = expect(Token::Bool, "a boolean").boolValue;
+}
+
+void InputArchive::read(std::string &str)
+{
+    str = expect(Token::String, "a string").str;
 }
 
-OutputArchive::~OutputArchive()
+void InputArchive::read(boost::gregorian::date &date)
 {
-    myStream.EndObject();
+    std::string date_str;
+    read(date_str);
+    date = boost::gregorian::from_undelimited_string(date_str);
 }
 }
@@ -22,19 +22,27 @@
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/optional.hpp>
-#include <boost/variant.hpp>
 #include <bitset>
+#include <cstdint>
 #include "fileversion.h"
+#include <istream>
+#include <limits>
 #include <map>
-#include <rapidjson/document.h>
+#include <memory>
 #include <rapidjson/prettywriter.h>
-#include <stack>
+#include <rapidjson/reader.h>
+#include <rapidjson/writer.h>
 #include <stdexcept>
+#include <type_traits>
 #include <util/rapidjson_iostreams.h>
 #include <vector>
 
 namespace ScoreUtils
 {
+/// Reads an object from JSON data.
+/// Rather than building a document tree, the JSON data is parsed with
+/// rapidjson's iterative reader as it is read from the stream, driven by the
+/// calls from the serialize() methods.
 class InputArchive
 {
 public:
@@ -43,83 +51,80 @@ public:
     FileVersion version() const;
 
     template <typename T>
-    void operator()(const std::string &expectedName, T &obj)
+    void operator()(const char *expectedName, T &obj)
     {
-        if (expectedName != name())
-        {
-            throw std::runtime_error(
-                std::string("Unexpected or missing JSON data: found ") +
-                name() + ", expected " + expectedName);
-        }
-
+        readName(expectedName);
         read(obj);
-        advance();
     }
 
-private:
-    typedef rapidjson::GenericValue<rapidjson::UTF8<> > JSONValue;
-
-    struct ValueVisitor : public boost::static_visitor<const JSONValue &>
+    template <typename T>
+    void operator()(const std::string &expectedName, T &obj)
     {
-        const JSONValue &operator()(
-            const JSONValue::ConstMemberIterator &it) const
-        {
-            return it->value;
-        }
-
-        const JSONValue &operator()(
-            const JSONValue::ConstValueIterator &it) const
-        {
-            return *it;
-        }
-    };
+        (*this)(expectedName.c_str(), obj);
+    }
 
-    struct NameVisitor : public boost::static_visitor<std::string>
+    /// Reads the first members of an object, and stops without reading the
+    /// rest of the data. This allows e.g. a file's header to be read cheaply.
+    template <typename T>
+    void readPartial(const std::string &expectedName, T &obj)
     {
-        std::string operator()(const JSONValue::ConstMemberIterator &it) const
-        {
-            return it->name.GetString();
-        }
-
-        std::string operator()(const JSONValue::ConstValueIterator &) const
-        {
-            throw std::logic_error("Cannot read the name of an array element");
-        }
-    };
+        readName(expectedName.c_str());
+        beginObject();
+        obj.serialize(*this, myVersion);
+    }
 
-    struct AdvanceVisitor : public boost::static_visitor<void>
+private:
+    /// A single event from the JSON reader.
+    struct Token
     {
-        template <typename Iterator>
-        void operator()(Iterator &it) const
+        enum Type
         {
-            ++it;
-        }
+            Null,
+            Bool,
+            Integer,
+            /// A floating point value, or an integer that does not fit in an
+            /// int64_t.
+            Number,
+            String,
+            Key,
+            StartObject,
+            EndObject,
+            StartArray,
+            EndArray
+        };
+
+        Type type = Null;
+        bool boolValue = false;
+        int64_t intValue = 0;
+        /// The value of a string or key. This is reused to avoid allocating
+        /// a new string for every member.
+        std::string str;
     };
 
-    void advance()
-    {
-        AdvanceVisitor visitor;
-        myIterators.top().apply_visitor(visitor);
-    }
+    class TokenHandler;
+
+    /// Returns the next token without consuming it.
+    const Token &peek();
+    /// Consumes the next token.
+    const Token &take();
+    /// Consumes the next token, and throws if it is not of the given type.
+    const Token &expect(Token::Type type, const char *description);
+    [[noreturn]] void parseError(const std::string &msg) const;
+
+    /// Reads the start of an object.
+    void beginObject();
+    /// Skips over any remaining members of the object, and reads the end of
+    /// the object.
+    void endObject();
+    /// Reads the next member's name, and throws if it is not the expected one.
+    void readName(const char *expectedName);
+    void skipValue();
 
-    std::string name() const
-    {
-        NameVisitor visitor;
-        return myIterators.top().apply_visitor(visitor);
-    }
-
-    const JSONValue &value() const
-    {
-        ValueVisitor visitor;
-        return myIterators.top().apply_visitor(visitor);
-    }
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value>::type read(T &val);
 
-    inline void read(int &val);
-    inline void read(int8_t &val);
-    inline void read(unsigned int &val);
-    inline void read(uint8_t &val);
-    inline void read(bool &val);
-    inline void read(std::string &str);
+    void read(bool &val);
+    void read(std::string &str);
 
     template <typename T>
     void read(std::vector<T> &vec);
@@ -136,30 +141,33 @@ private:
     template <typename T>
     void read(boost::optional<T> &val);
 
-    inline void read(boost::gregorian::date &date);
+    template <typename T>
+    void read(std::shared_ptr<T> &val);
+
+    void read(boost::gregorian::date &date);
 
     template <typename T>
     typename std::enable_if<std::is_enum<T>::value>::type read(T &val)
     {
-        val = static_cast<T>(value().GetInt());
+        int int_val;
+        read(int_val);
+        val = static_cast<T>(int_val);
     }
 
     template <typename T>
     typename std::enable_if<std::is_class<T>::value>::type read(T &obj)
     {
-        myIterators.push(value().MemberBegin());
+        beginObject();
         obj.serialize(*this, myVersion);
-        myIterators.pop();
+        endObject();
     }
 
     Util::RapidJSON::IStreamWrapper myStream;
-    rapidjson::Document myDocument;
+    rapidjson::Reader myReader;
+    Token myToken;
+    /// Whether myToken holds a token that has been peeked but not consumed.
+    bool myHasToken;
     FileVersion myVersion;
-
-	// Iterate over both objects and arrays in a uniform manner.
-    typedef boost::variant<JSONValue::ConstMemberIterator,
-                           JSONValue::ConstValueIterator> Iterator;
-    std::stack<Iterator> myIterators;
 };
 
 template <typename T>
@@ -175,11 +183,40 @@ void load(std::istream &input, const std::string &name, T &obj)
     archive(name, obj);
 }
 
-class OutputArchive
+/// Loads the first members of an object without reading the rest of the
+/// data. The serialize() method of T must read a prefix of the members that
+/// were written.
+template <typename T>
+void loadPartial(std::istream &input, const std::string &name, T &obj)
+{
+    InputArchive archive(input);
+    if (archive.version() > FileVersion::LATEST_VERSION ||
+        archive.version() < FileVersion::INITIAL_VERSION)
+    {
+        throw std::runtime_error("Invalid file version");
+    }
+
+    archive.readPartial(name, obj);
+}
+
+/// Writes an object as JSON, using either rapidjson::Writer (compact) or
+/// rapidjson::PrettyWriter (indented) as the Writer type.
+template <typename Writer>
+class BasicOutputArchive
 {
 public:
-    OutputArchive(std::ostream &os, FileVersion version);
-    ~OutputArchive();
+    BasicOutputArchive(std::ostream &os, FileVersion version)
+        : myWriteStream(os), myStream(myWriteStream), myVersion(version)
+    {
+        myStream.StartObject();
+
+        (*this)("version", myVersion);
+    }
+
+    ~BasicOutputArchive()
+    {
+        myStream.EndObject();
+    }
 
     template <typename T>
     void operator()(const std::string &name, const T &obj)
@@ -209,6 +246,9 @@ private:
     template <typename T>
     void write(const boost::optional<T> &val);
 
+    template <typename T>
+    void write(const std::shared_ptr<T> &val);
+
     inline void write(const boost::gregorian::date &date);
 
     template <typename T>
@@ -226,99 +266,97 @@ private:
     }
 
     Util::RapidJSON::OStreamWrapper myWriteStream;
-    rapidjson::PrettyWriter<Util::RapidJSON::OStreamWrapper> myStream;
+    Writer myStream;
     const FileVersion myVersion;
 };
 
-template <typename T>
-void save(std::ostream &output, const std::string &name, const T &obj)
-{
-    OutputArchive ar(output, FileVersion::LATEST_VERSION);
-    ar(name, obj);
-}
-
-void InputArchive::read(int &val)
-{
-    val = value().GetInt();
-}
+typedef BasicOutputArchive<rapidjson::Writer<Util::RapidJSON::OStreamWrapper>>
+    OutputArchive;
+typedef BasicOutputArchive<
+    rapidjson::PrettyWriter<Util::RapidJSON::OStreamWrapper>>
+    PrettyOutputArchive;
 
-void InputArchive::read(int8_t &val)
+/// Compact output is smaller and faster to write, while pretty output is
+/// easier to read and diff.
+enum class JsonFormat
 {
-    int int_val = value().GetInt();
-    if (int_val > std::numeric_limits<int8_t>::max())
-        throw std::overflow_error("Invalid int8_t value");
-    val = static_cast<int8_t>(int_val);
-}
+    Compact,
+    Pretty
+};
 
-void InputArchive::read(unsigned int &val)
+template <typename T>
+void save(std::ostream &output, const std::string &name, const T &obj,
+          JsonFormat format = JsonFormat::Compact)
 {
-    val = value().GetUint();
+    if (format == JsonFormat::Pretty)
+    {
+        PrettyOutputArchive ar(output, FileVersion::LATEST_VERSION);
+        ar(name, obj);
+    }
+    else
+    {
+        OutputArchive ar(output, FileVersion::LATEST_VERSION);
+        ar(name, obj);
+    }
 }
 
-void InputArchive::read(uint8_t &val)
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value>::type
+InputArchive::read(T &val)
 {
-    unsigned int uint_val = value().GetUint();
-    if (uint_val > std::numeric_limits<uint8_t>::max())
-        throw std::overflow_error("Invalid uint8_t value");
-    val = static_cast<uint8_t>(uint_val);
-}
+    typedef std::numeric_limits<T> Limits;
 
-void InputArchive::read(bool &val)
-{
-    val = value().GetBool();
-}
+    const int64_t int_val = expect(Token::Integer, "an integer").intValue;
+    if (int_val < static_cast<int64_t>(Limits::min()) ||
+        (int_val > 0 &&
+         static_cast<uint64_t>(int_val) > static_cast<uint64_t>(Limits::max())))
+    {
+        throw std::overflow_error("Invalid integer value");
+    }
 
-void InputArchive::read(std::string &str)
-{
-    str = value().GetString();
+    val = static_cast<T>(int_val);
 }
 
 template <typename T>
 void InputArchive::read(std::vector<T> &vec)
 {
-    auto size = value().Size();
-    myIterators.push(value().Begin());
+    expect(Token::StartArray, "an array");
 
-    vec.resize(size);
-    for (unsigned int i = 0; i < size; ++i)
+    vec.clear();
+    while (peek().type != Token::EndArray)
     {
-        read(vec[i]);
-        advance();
+        vec.emplace_back();
+        read(vec.back());
     }
 
-    myIterators.pop();
+    take();
 }
 
 template <typename K, typename V, typename C>
 void InputArchive::read(std::map<K, V, C> &map)
 {
-    auto it = value().MemberBegin();
-    const long long size = std::distance(it, value().MemberEnd());
-    myIterators.push(it);
+    beginObject();
 
-    for (long long i = 0; i < size; ++i)
+    map.clear();
+    while (peek().type != Token::EndObject)
     {
-        const K key = boost::lexical_cast<K>(name());
-
-        V value;
-        read(value);
-        map[key] = value;
-
-        advance();
+        const K key =
+            boost::lexical_cast<K>(expect(Token::Key, "a member name").str);
+        read(map[key]);
     }
 
-    myIterators.pop();
+    take();
 }
 
 template <typename T, size_t N>
 void InputArchive::read(std::array<T, N> &arr)
 {
-    myIterators.push(value().MemberBegin());
+    beginObject();
 
     for (size_t i = 0; i < N; ++i)
         (*this)(std::to_string(i), arr[i]);
 
-    myIterators.pop();
+    endObject();
 }
 
 template <size_t N>
@@ -332,8 +370,11 @@ void InputArchive::read(std::bitset<N> &bits)
 template <typename T>
 void InputArchive::read(boost::optional<T> &val)
 {
-    if (value().IsNull())
+    if (peek().type == Token::Null)
+    {
+        take();
         val.reset();
+    }
     else
     {
         T data;
@@ -342,36 +383,42 @@ void InputArchive::read(boost::optional<T> &val)
     }
 }
 
-void InputArchive::read(boost::gregorian::date &date)
+template <typename T>
+void InputArchive::read(std::shared_ptr<T> &val)
 {
-    std::string date_str;
-    read(date_str);
-    date = boost::gregorian::from_undelimited_string(date_str);
+    auto data = std::make_shared<typename std::remove_const<T>::type>();
+    read(*data);
+    val = std::move(data);
 }
 
-void OutputArchive::write(int val)
+template <typename Writer>
+void BasicOutputArchive<Writer>::write(int val)
 {
     myStream.Int(val);
 }
 
-void OutputArchive::write(unsigned int val)
+template <typename Writer>
+void BasicOutputArchive<Writer>::write(unsigned int val)
 {
     myStream.Uint(val);
 }
 
-void OutputArchive::write(bool val)
+template <typename Writer>
+void BasicOutputArchive<Writer>::write(bool val)
 {
     myStream.Bool(val);
 }
 
-void OutputArchive::write(const std::string &str)
+template <typename Writer>
+void BasicOutputArchive<Writer>::write(const std::string &str)
 {
     myStream.String(str.c_str(),
                     static_cast<rapidjson::SizeType>(str.length()));
 }
 
+template <typename Writer>
 template <typename T>
-void OutputArchive::write(const std::vector<T> &vec)
+void BasicOutputArchive<Writer>::write(const std::vector<T> &vec)
 {
     myStream.StartArray();
     for (const T &obj : vec)
@@ -379,8 +426,9 @@ void OutputArchive::write(const std::vector<T> &vec)
     myStream.EndArray();
 }
 
+template <typename Writer>
 template <typename K, typename V, typename C>
-void OutputArchive::write(const std::map<K, V, C> &map)
+void BasicOutputArchive<Writer>::write(const std::map<K, V, C> &map)
 {
     myStream.StartObject();
 
@@ -390,8 +438,9 @@ void OutputArchive::write(const std::map<K, V, C> &map)
     myStream.EndObject();
 }
 
+template <typename Writer>
 template <typename T, size_t N>
-void OutputArchive::write(const std::array<T, N> &arr)
+void BasicOutputArchive<Writer>::write(const std::array<T, N> &arr)
 {
     myStream.StartObject();
 
@@ -401,14 +450,16 @@ void OutputArchive::write(const std::array<T, N> &arr)
     myStream.EndObject();
 }
 
+template <typename Writer>
 template <size_t N>
-void OutputArchive::write(const std::bitset<N> &bits)
+void BasicOutputArchive<Writer>::write(const std::bitset<N> &bits)
 {
     write(bits.to_string());
 }
 
+template <typename Writer>
 template <typename T>
-void OutputArchive::write(const boost::optional<T> &val)
+void BasicOutputArchive<Writer>::write(const boost::optional<T> &val)
 {
     if (val)
         write(*val);
@@ -416,7 +467,15 @@ void OutputArchive::write(const boost::optional<T> &val)
         myStream.Null();
 }
 
-void OutputArchive::write(const boost::gregorian::date &date)
+template <typename Writer>
+template <typename T>
+void BasicOutputArchive<Writer>::write(const std::shared_ptr<T> &val)
+{
+    write(*val);
+}
+
+template <typename Writer>
+void BasicOutputArchive<Writer>::write(const boost::gregorian::date &date)
 {
     write(boost::gregorian::to_iso_string(date));
 }
@@ -78,6 +78,35 @@ namespace ScoreUtils {
             range, InPositionRange(left, right));
     }
 
+    struct PositionLess
+    {
+        template <typename T>
+        bool operator()(const T &obj, int position) const
+        {
+            return obj.getPosition() < position;
+        }
+
+        template <typename T>
+        bool operator()(int position, const T &obj) const
+        {
+            return position < obj.getPosition();
+        }
+    };
+
+    /// Equivalent to findInRange(), but uses a binary search. The objects must
+    /// be sorted by position, which is the case for all of the lists of
+    /// objects stored in a system, staff, or voice.
+    template <typename Iterator>
+    boost::iterator_range<Iterator> findInSortedRange(
+        const boost::iterator_range<Iterator> &range, int left, int right)
+    {
+        const Iterator begin = std::lower_bound(range.begin(), range.end(),
+                                                left, PositionLess());
+        const Iterator end =
+            std::upper_bound(begin, range.end(), right, PositionLess());
+        return boost::make_iterator_range(begin, end);
+    }
+
     // Some helper methods to reduce code duplication.
 
     /// Sorts objects by their positions in the system.
@@ -208,17 +208,31 @@ RepeatIndexer::RepeatIndexer(const Score &score)
 
     // TODO - report mismatched repeat start bars.
     // TODO - report missing / extra alternate endings.
+
+    boost::optional<SystemLocation> furthest_end;
+    for (const RepeatedSection &repeat : myRepeats)
+    {
+        if (!furthest_end || *furthest_end < repeat.getLastEndBarLocation())
+            furthest_end = repeat.getLastEndBarLocation();
+
+        myFurthestEndBars.emplace(repeat.getStartBarLocation(), *furthest_end);
+    }
 }
 
 const RepeatedSection *RepeatIndexer::findRepeat(
     const SystemLocation &loc) const
 {
     auto repeat = myRepeats.upper_bound(loc);
+    auto furthest_end = myFurthestEndBars.upper_bound(loc);
 
     // Search for a pair of start and end bars that surrounds this location.
     while (repeat != myRepeats.begin())
     {
         --repeat;
+        --furthest_end;
+
+        if (furthest_end->second < loc)
+            break;
         if (repeat->getLastEndBarLocation() >= loc)
             return &(*repeat);
     }
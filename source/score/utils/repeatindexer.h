@@ -92,6 +92,10 @@ public:
 
 private:
     std::set<RepeatedSection> myRepeats;
+    /// For each repeated section (keyed by its start bar), the furthest end
+    /// bar of that section or any earlier section. This allows findRepeat()
+    /// to stop searching once no earlier section can surround a location.
+    std::map<SystemLocation, SystemLocation> myFurthestEndBars;
 };
 
 #endif
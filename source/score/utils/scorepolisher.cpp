@@ -23,6 +23,7 @@
 #include <score/utils.h>
 #include <unordered_map>
 #include <unordered_set>
+#include <util/parallel.h>
 
 class TimeStamp
 {
@@ -245,6 +246,11 @@ void ScoreUtils::polishSystem(System &system)
 
 void ScoreUtils::polishScore(Score &score)
 {
-    for (System &system : score.getSystems())
-        polishSystem(system);
+    // Each system is formatted independently, so the systems can be processed
+    // in parallel.
+    auto systems = score.getSystems();
+    Util::parallelFor(systems.size(), 8, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            polishSystem(systems[i]);
+    });
 }
@@ -115,16 +115,21 @@ std::vector<const IrregularGrouping *> getIrregularGroupsInRange(
     const Voice &voice, int left, int right)
 {
     std::vector<const IrregularGrouping *> groups;
+    auto positions = voice.getPositions();
 
     for (const IrregularGrouping &group : voice.getIrregularGroupings())
     {
+        // The groups are sorted by position.
         const int groupLeft = group.getPosition();
+        if (groupLeft > right)
+            break;
+
+        auto firstPos = std::lower_bound(positions.begin(), positions.end(),
+                                         groupLeft, ScoreUtils::PositionLess());
         const int groupRight =
-            voice.getPositions()[ScoreUtils::findIndexByPosition(
-                                     voice.getPositions(), groupLeft) +
-                                 group.getLength() - 1].getPosition();
+            (firstPos + (group.getLength() - 1))->getPosition();
 
-        if (groupLeft <= right && groupRight >= left)
+        if (groupRight >= left)
             groups.push_back(&group);
     }
 
@@ -0,0 +1,122 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "atomicfile.h"
+
+#include <boost/filesystem.hpp>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = boost::filesystem;
+
+namespace Util
+{
+/// Flushes the file's contents to disk.
+static void syncFile(const fs::path &path)
+{
+#ifdef _WIN32
+    HANDLE handle = CreateFileW(path.wstring().c_str(), GENERIC_WRITE, 0,
+                                nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                                nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Could not open " + path.string());
+
+    const bool success = FlushFileBuffers(handle) != 0;
+    CloseHandle(handle);
+#else
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Could not open " + path.string());
+
+    const bool success = fsync(fd) == 0;
+    close(fd);
+#endif
+
+    if (!success)
+        throw std::runtime_error("Could not flush " + path.string());
+}
+
+/// Makes a rename within the directory durable. This is not possible (or
+/// needed) on Windows, and is only a best effort elsewhere.
+static void syncDirectory(const fs::path &dir)
+{
+#ifdef _WIN32
+    (void)dir;
+#else
+    const int fd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+        fsync(fd);
+        close(fd);
+    }
+#endif
+}
+
+/// Follows any symbolic links, so that the file they point to is replaced
+/// rather than the link itself.
+static fs::path resolveSymlinks(fs::path path)
+{
+    // Limit the number of links that are followed, in case of a cycle.
+    boost::system::error_code ec;
+    for (int i = 0; i < 40 && fs::is_symlink(fs::symlink_status(path, ec));
+         ++i)
+    {
+        const fs::path target = fs::read_symlink(path);
+        path = target.is_absolute() ? target : path.parent_path() / target;
+    }
+
+    return path;
+}
+
+void writeFileAtomically(
+    const std::string &path,
+    const std::function<void(const std::string &tempPath)> &write)
+{
+    const fs::path dest = resolveSymlinks(path);
+    const fs::path dir = dest.parent_path();
+    const fs::path temp =
+        dir / fs::unique_path(dest.filename().string() + ".%%%%-%%%%.tmp");
+
+    try
+    {
+        write(temp.string());
+        syncFile(temp);
+
+        // Keep the permissions of the file that is being replaced.
+        boost::system::error_code ec;
+        const fs::file_status status = fs::status(dest, ec);
+        if (!ec && fs::exists(status))
+            fs::permissions(temp, status.permissions(), ec);
+
+        fs::rename(temp, dest);
+    }
+    catch (...)
+    {
+        boost::system::error_code ec;
+        fs::remove(temp, ec);
+        throw;
+    }
+
+    syncDirectory(dir);
+}
+}
@@ -0,0 +1,36 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef UTIL_ATOMICFILE_H
+#define UTIL_ATOMICFILE_H
+
+#include <functional>
+#include <string>
+
+namespace Util
+{
+/// Writes a file without ever leaving a partially written file at the
+/// destination. The write function is called with the path of a temporary
+/// file in the same directory, which is then flushed to disk and renamed over
+/// the destination. If anything fails, the temporary file is removed and the
+/// original file is left untouched.
+void writeFileAtomically(
+    const std::string &path,
+    const std::function<void(const std::string &tempPath)> &write);
+}
+
+#endif
@@ -0,0 +1,70 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef UTIL_COPYONWRITE_H
+#define UTIL_COPYONWRITE_H
+
+#include <atomic>
+#include <boost/iterator/iterator_adaptor.hpp>
+#include <memory>
+
+namespace Util
+{
+/// Iterates over a sequence of std::shared_ptr<const T>, and gives mutable
+/// access to the values. If a value is shared with another owner (e.g. a
+/// snapshot), it is copied before being returned so that the other owners
+/// are unaffected.
+///
+/// The values must not have been created as const objects. A reference to a
+/// value is only safe to modify until the value is shared again.
+template <typename T, typename BaseIterator>
+class CopyOnWriteIterator
+    : public boost::iterator_adaptor<CopyOnWriteIterator<T, BaseIterator>,
+                                     BaseIterator, T, boost::use_default, T &>
+{
+public:
+    CopyOnWriteIterator()
+    {
+    }
+
+    explicit CopyOnWriteIterator(const BaseIterator &it)
+        : CopyOnWriteIterator::iterator_adaptor_(it)
+    {
+    }
+
+private:
+    friend class boost::iterator_core_access;
+
+    T &dereference() const
+    {
+        std::shared_ptr<const T> &ptr = *this->base();
+        if (ptr.use_count() != 1)
+            ptr = std::make_shared<T>(*ptr);
+        else
+        {
+            // Another thread (e.g. one saving a snapshot) may have just
+            // released the value, so make sure that it has finished reading.
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+
+        // Nothing else refers to the value now.
+        return const_cast<T &>(*ptr);
+    }
+};
+}
+
+#endif
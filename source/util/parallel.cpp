@@ -0,0 +1,93 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <exception>
+#include <future>
+#include <thread>
+#include <vector>
+
+// Visual Studio 2013 does not support thread_local, but __declspec(thread)
+// works for plain types.
+#ifdef _MSC_VER
+#define PTE_THREAD_LOCAL __declspec(thread)
+#else
+#define PTE_THREAD_LOCAL thread_local
+#endif
+
+namespace Util
+{
+static PTE_THREAD_LOCAL bool theIsSerial = false;
+
+void parallelFor(size_t count, size_t minBlockSize,
+                 const std::function<void(size_t, size_t)> &func)
+{
+    if (count == 0)
+        return;
+
+    const size_t numBlocks =
+        theIsSerial
+            ? 1
+            : std::max<size_t>(
+                  1, std::min<size_t>(std::thread::hardware_concurrency(),
+                                      count / std::max<size_t>(minBlockSize, 1)));
+    const size_t blockSize = (count + numBlocks - 1) / numBlocks;
+
+    std::vector<std::future<void>> tasks;
+    for (size_t begin = blockSize; begin < count; begin += blockSize)
+    {
+        tasks.push_back(std::async(std::launch::async, func, begin,
+                                   std::min(begin + blockSize, count)));
+    }
+
+    std::exception_ptr error;
+    try
+    {
+        func(0, std::min(blockSize, count));
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+
+    // Wait for all of the tasks to finish before rethrowing any errors.
+    for (std::future<void> &task : tasks)
+        task.wait();
+    if (error)
+        std::rethrow_exception(error);
+    for (std::future<void> &task : tasks)
+        task.get();
+}
+
+std::launch launchPolicy()
+{
+    return theIsSerial ? std::launch::deferred : std::launch::async;
+}
+
+SerialScope::SerialScope(bool enabled) : myWasSerial(theIsSerial)
+{
+    if (enabled)
+        theIsSerial = true;
+}
+
+SerialScope::~SerialScope()
+{
+    theIsSerial = myWasSerial;
+}
+}
@@ -0,0 +1,59 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef UTIL_PARALLEL_H
+#define UTIL_PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+#include <future>
+
+namespace Util
+{
+/// Splits the range [0, count) into contiguous blocks, and calls
+/// func(begin, end) for each block in parallel (with at most one block per
+/// hardware thread). The first block is processed on the calling thread.
+///
+/// All of the blocks are finished before returning. If any of them threw an
+/// exception, the exception from the earliest block is rethrown.
+/// @param minBlockSize Avoids starting threads for small amounts of work.
+void parallelFor(size_t count, size_t minBlockSize,
+                 const std::function<void(size_t, size_t)> &func);
+
+/// Returns the launch policy to use with std::async for work that may run in
+/// parallel. Inside a SerialScope the tasks are deferred, so that they run on
+/// the calling thread when their result is requested.
+std::launch launchPolicy();
+
+/// While this object exists, parallelFor() and launchPolicy() do not start
+/// any threads from the current thread. This is used by callers that are
+/// already running one task per core, such as the batch converter.
+class SerialScope
+{
+public:
+    explicit SerialScope(bool enabled = true);
+    ~SerialScope();
+
+    SerialScope(const SerialScope &) = delete;
+    SerialScope &operator=(const SerialScope &) = delete;
+
+private:
+    const bool myWasSerial;
+};
+}
+
+#endif
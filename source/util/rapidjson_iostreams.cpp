@@ -21,7 +21,8 @@ namespace Util
 {
 namespace RapidJSON
 {
-    IStreamWrapper::IStreamWrapper(std::istream &stream) : myStream(stream)
+    IStreamWrapper::IStreamWrapper(std::istream &stream)
+        : myBuffer(stream.rdbuf()), myOffset(0)
     {
     }
 
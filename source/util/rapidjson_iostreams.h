@@ -21,6 +21,7 @@
 #include <cassert>
 #include <cstddef>
 #include <istream>
+#include <ostream>
 #include <string>
 
 namespace Util
@@ -28,6 +29,8 @@ namespace Util
 namespace RapidJSON
 {
     /// Wrapper class to use a std::istream with RapidJSON.
+    /// Characters are read directly from the stream's buffer, and the offset
+    /// is counted here since tellg() is not supported by filtering streams.
     class IStreamWrapper
     {
     public:
@@ -38,22 +41,25 @@ namespace RapidJSON
 
         Ch Peek() const
         {
-            // We cannot check eof() here due to a bug in earlier versions of
-            // libc++ (http://stackoverflow.com/a/14150918).
-            const char ch = myStream.peek();
-            return traits_type::eq_int_type(ch, traits_type::eof()) ? '\0' : ch;
+            const auto ch = myBuffer->sgetc();
+            return traits_type::eq_int_type(ch, traits_type::eof())
+                       ? '\0'
+                       : traits_type::to_char_type(ch);
         }
 
         Ch Take()
         {
-            if (myStream.eof())
+            const auto ch = myBuffer->sbumpc();
+            if (traits_type::eq_int_type(ch, traits_type::eof()))
                 return '\0';
-            return static_cast<Ch>(myStream.get());
+
+            ++myOffset;
+            return traits_type::to_char_type(ch);
         }
 
         size_t Tell() const
         {
-            return static_cast<size_t>(myStream.tellg());
+            return myOffset;
         }
 
         Ch *PutBegin()
@@ -79,7 +85,8 @@ namespace RapidJSON
         }
 
     private:
-        std::istream &myStream;
+        std::streambuf *myBuffer;
+        size_t myOffset;
     };
 
     /// Wrapper class to use a std::ostream with RapidJSON.
@@ -87,6 +94,7 @@ namespace RapidJSON
     {
     public:
         typedef char Ch;
+        typedef std::ostream::traits_type traits_type;
 
         OStreamWrapper(std::ostream &stream);
 
@@ -115,7 +123,13 @@ namespace RapidJSON
 
         void Put(Ch c)
         {
-            myStream.put(c);
+            // Write directly to the stream buffer, rather than paying for the
+            // sentry object that std::ostream::put() constructs per character.
+            if (traits_type::eq_int_type(myStream.rdbuf()->sputc(c),
+                                         traits_type::eof()))
+            {
+                myStream.setstate(std::ios::badbit);
+            }
         }
 
         void Flush()
@@ -15,8 +15,8 @@
   * along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#ifndef APP_SETTINGSMANAGER_H
-#define APP_SETTINGSMANAGER_H
+#ifndef UTIL_SETTINGSMANAGER_H
+#define UTIL_SETTINGSMANAGER_H
 
 #include <boost/filesystem/path.hpp>
 #include <boost/signals2/signal.hpp>
@@ -0,0 +1,184 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "threadedstreambuf.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Util
+{
+ThreadedOutputStreamBuf::ThreadedOutputStreamBuf(std::streambuf &dest,
+                                                 size_t chunkSize,
+                                                 size_t maxQueuedChunks)
+    : myDest(dest),
+      myChunkSize(std::max<size_t>(chunkSize, 1)),
+      myMaxQueuedChunks(std::max<size_t>(maxQueuedChunks, 1)),
+      myChunk(myChunkSize),
+      myIsFinished(false)
+{
+    setp(myChunk.data(), myChunk.data() + myChunk.size());
+    myThread = std::thread(&ThreadedOutputStreamBuf::run, this);
+}
+
+ThreadedOutputStreamBuf::~ThreadedOutputStreamBuf()
+{
+    try
+    {
+        finish();
+    }
+    catch (...)
+    {
+        // Errors can only be reported by calling finish() explicitly.
+    }
+}
+
+void ThreadedOutputStreamBuf::finish()
+{
+    if (!myThread.joinable())
+        return;
+
+    submitChunk();
+
+    {
+        std::lock_guard<std::mutex> lock(myMutex);
+        myIsFinished = true;
+    }
+    myChunkQueued.notify_one();
+    myThread.join();
+
+    if (myError)
+        std::rethrow_exception(myError);
+}
+
+ThreadedOutputStreamBuf::int_type ThreadedOutputStreamBuf::overflow(int_type c)
+{
+    if (!myThread.joinable() || !submitChunk())
+        return traits_type::eof();
+
+    if (!traits_type::eq_int_type(c, traits_type::eof()))
+    {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+
+    return traits_type::not_eof(c);
+}
+
+std::streamsize ThreadedOutputStreamBuf::xsputn(const char *s,
+                                                std::streamsize n)
+{
+    std::streamsize written = 0;
+    while (written < n)
+    {
+        if (pptr() == epptr() &&
+            traits_type::eq_int_type(overflow(traits_type::eof()),
+                                     traits_type::eof()))
+        {
+            break;
+        }
+
+        const std::streamsize count =
+            std::min<std::streamsize>(n - written, epptr() - pptr());
+        std::copy(s + written, s + written + count, pptr());
+        pbump(static_cast<int>(count));
+        written += count;
+    }
+
+    return written;
+}
+
+bool ThreadedOutputStreamBuf::submitChunk()
+{
+    myChunk.resize(pptr() - pbase());
+
+    {
+        std::unique_lock<std::mutex> lock(myMutex);
+        myChunkWritten.wait(lock, [this]() {
+            return myQueue.size() < myMaxQueuedChunks || myError;
+        });
+
+        // If the background thread failed, discard the data. The error is
+        // reported by finish().
+        if (myError)
+        {
+            myChunk.resize(myChunkSize);
+            setp(myChunk.data(), myChunk.data() + myChunk.size());
+            return false;
+        }
+
+        if (!myChunk.empty())
+            myQueue.push_back(std::move(myChunk));
+
+        if (!myFreeChunks.empty())
+        {
+            myChunk = std::move(myFreeChunks.back());
+            myFreeChunks.pop_back();
+        }
+        else
+            myChunk = Chunk();
+    }
+    myChunkQueued.notify_one();
+
+    myChunk.resize(myChunkSize);
+    setp(myChunk.data(), myChunk.data() + myChunk.size());
+    return true;
+}
+
+void ThreadedOutputStreamBuf::run()
+{
+    while (true)
+    {
+        Chunk chunk;
+        {
+            std::unique_lock<std::mutex> lock(myMutex);
+            myChunkQueued.wait(lock, [this]() {
+                return !myQueue.empty() || myIsFinished;
+            });
+
+            if (myQueue.empty())
+                break;
+
+            chunk = std::move(myQueue.front());
+            myQueue.pop_front();
+        }
+
+        try
+        {
+            const auto size = static_cast<std::streamsize>(chunk.size());
+            if (myDest.sputn(chunk.data(), size) != size)
+                throw std::runtime_error("Error writing to stream");
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(myMutex);
+            myError = std::current_exception();
+            myQueue.clear();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(myMutex);
+            chunk.clear();
+            myFreeChunks.push_back(std::move(chunk));
+        }
+        myChunkWritten.notify_one();
+
+        if (myError)
+            break;
+    }
+}
+}
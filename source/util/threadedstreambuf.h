@@ -0,0 +1,81 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef UTIL_THREADEDSTREAMBUF_H
+#define UTIL_THREADEDSTREAMBUF_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+namespace Util
+{
+/// An output stream buffer that hands its data off in chunks to a background
+/// thread, which writes them to another stream buffer. This allows an
+/// expensive stage such as compression to run in parallel with the code
+/// producing the data.
+class ThreadedOutputStreamBuf : public std::streambuf
+{
+public:
+    /// @param chunkSize The number of bytes that are collected before being
+    /// passed to the background thread.
+    /// @param maxQueuedChunks The number of chunks that can be waiting for
+    /// the background thread before the writer blocks.
+    ThreadedOutputStreamBuf(std::streambuf &dest, size_t chunkSize = 65536,
+                            size_t maxQueuedChunks = 4);
+    ~ThreadedOutputStreamBuf();
+
+    /// Passes any remaining data to the destination and waits for the
+    /// background thread to finish. Any exception thrown while writing to the
+    /// destination is rethrown here.
+    void finish();
+
+protected:
+    virtual int_type overflow(int_type c) override;
+    virtual std::streamsize xsputn(const char *s, std::streamsize n) override;
+
+private:
+    typedef std::vector<char> Chunk;
+
+    /// Queues the current chunk and starts a new one. Returns false if the
+    /// background thread has failed.
+    bool submitChunk();
+    void run();
+
+    std::streambuf &myDest;
+    const size_t myChunkSize;
+    const size_t myMaxQueuedChunks;
+    Chunk myChunk;
+
+    std::mutex myMutex;
+    std::condition_variable myChunkQueued;
+    std::condition_variable myChunkWritten;
+    std::deque<Chunk> myQueue;
+    /// Empty chunks that can be reused, to avoid reallocating buffers.
+    std::vector<Chunk> myFreeChunks;
+    bool myIsFinished;
+    std::exception_ptr myError;
+    std::thread myThread;
+};
+}
+
+#endif
@@ -27,13 +27,15 @@ TEST_CASE("App/DocumentManager", "")
 
     manager.addDocument();
     manager.addDocument();
-    manager.addDocument();
+    Document &last = manager.addDocument();
 
     REQUIRE(manager.hasOpenDocuments());
     REQUIRE(manager.getCurrentDocumentIndex() == 2);
+    REQUIRE(manager.findDocument(last) == 2);
 
     manager.removeDocument(1);
     REQUIRE(manager.getCurrentDocumentIndex() == 1);
+    REQUIRE(manager.findDocument(last) == 1);
 
     manager.removeDocument(0);
     REQUIRE(manager.getCurrentDocumentIndex() == 0);
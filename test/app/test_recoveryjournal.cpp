@@ -0,0 +1,190 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <catch.hpp>
+
+#include <app/recoveryjournal.h>
+#include "benchmark.h"
+#include <boost/filesystem.hpp>
+#include <memory>
+#include <score/score.h>
+
+namespace fs = boost::filesystem;
+
+static System makeSystem(int num_positions)
+{
+    Staff staff(6);
+    for (int i = 0; i < num_positions; ++i)
+    {
+        Position pos(i);
+        pos.insertNote(Note(i % 6, i % 12));
+        staff.getVoices()[0].insertPosition(pos);
+    }
+
+    System system;
+    system.insertStaff(staff);
+    return system;
+}
+
+/// Adds a note to the first staff of a system.
+static void editSystem(Score &score, int system_index, int position)
+{
+    Position pos(position);
+    pos.insertNote(Note(0, 5));
+    score.getSystems()[system_index]
+        .getStaves()[0]
+        .getVoices()[0]
+        .insertPosition(pos);
+}
+
+struct JournalFixture
+{
+    JournalFixture() : myDir(fs::temp_directory_path() / fs::unique_path())
+    {
+        for (int i = 0; i < 3; ++i)
+            myScore.insertSystem(makeSystem(10));
+    }
+
+    ~JournalFixture()
+    {
+        fs::remove_all(myDir);
+    }
+
+    std::string dir() const { return myDir.string(); }
+
+    const fs::path myDir;
+    Score myScore;
+};
+
+TEST_CASE("App/RecoveryJournal/Recover", "")
+{
+    JournalFixture fixture;
+    Score &score = fixture.myScore;
+
+    RecoveryJournal journal(fixture.dir());
+    journal.setFilename("song.pt2");
+    REQUIRE(!RecoveryJournal::exists(fixture.dir()));
+
+    // The first edit writes a snapshot.
+    editSystem(score, 0, 20);
+    journal.recordSystem(score, 0, 1);
+    journal.flush();
+    REQUIRE(RecoveryJournal::exists(fixture.dir()));
+
+    editSystem(score, 1, 21);
+    journal.recordSystem(score, 1, 2);
+    editSystem(score, 2, 22);
+    journal.recordSystem(score, 2, 3);
+
+    // Adding a system starts a new snapshot.
+    score.insertSystem(makeSystem(5));
+    journal.recordScore(score, 4);
+    editSystem(score, 3, 23);
+    journal.recordSystem(score, 3, 5);
+
+    SECTION("Replay")
+    {
+        // Only the edit after the last snapshot needs to be replayed.
+        journal.flush();
+
+        Score recovered;
+        RecoveredDocument document =
+            RecoveryJournal::recover(fixture.dir(), recovered);
+        REQUIRE(document.filename == "song.pt2");
+        REQUIRE(document.undoIndex == 5);
+        REQUIRE(document.numEdits == 1);
+        REQUIRE(recovered == score);
+    }
+
+    SECTION("Partial record")
+    {
+        journal.flush();
+        std::unique_ptr<Score> expected = score.clone();
+
+        editSystem(score, 0, 30);
+        journal.recordSystem(score, 0, 6);
+
+        // Simulate a crash while writing a record.
+        fs::path last_segment;
+        for (fs::directory_iterator it(fixture.myDir), end; it != end; ++it)
+        {
+            if (it->path().filename() != "snapshot")
+                last_segment = std::max(last_segment, it->path());
+        }
+        const uintmax_t size = fs::file_size(last_segment);
+        fs::resize_file(last_segment, size - 3);
+
+        Score recovered;
+        RecoveredDocument document =
+            RecoveryJournal::recover(fixture.dir(), recovered);
+        REQUIRE(document.undoIndex == 5);
+        REQUIRE(recovered == *expected);
+    }
+
+    SECTION("Clear")
+    {
+        journal.clear();
+        REQUIRE(!fs::exists(fixture.myDir));
+
+        // Recording another edit starts a new journal.
+        editSystem(score, 0, 30);
+        journal.recordSystem(score, 0, 6);
+        journal.flush();
+
+        Score recovered;
+        RecoveredDocument document =
+            RecoveryJournal::recover(fixture.dir(), recovered);
+        REQUIRE(document.undoIndex == 6);
+        REQUIRE(recovered == score);
+    }
+}
+
+TEST_CASE("App/RecoveryJournal/Benchmark", "[!hide][benchmark]")
+{
+    JournalFixture fixture;
+    Score &score = fixture.myScore;
+
+    const int num_edits = 5000;
+    for (int i = 0; i < 500; ++i)
+        score.insertSystem(makeSystem(50));
+
+    RecoveryJournal journal(fixture.dir());
+    journal.recordScore(score, 0);
+    journal.flush();
+
+    const auto record_time = Benchmark::measure([&]() {
+        for (int i = 0; i < num_edits; ++i)
+        {
+            const int system_index = i % 500;
+            editSystem(score, system_index, 100 + i / 500);
+            journal.recordSystem(score, system_index, i + 1);
+        }
+    });
+    WARN("Recording an edit: " << Benchmark::format(record_time / num_edits));
+
+    journal.flush();
+
+    Score recovered;
+    RecoveredDocument document;
+    const auto recover_time = Benchmark::measure([&]() {
+        document = RecoveryJournal::recover(fixture.dir(), recovered);
+    });
+    REQUIRE(recovered == score);
+
+    WARN("Recovering " << document.numEdits << " edits: "
+                       << Benchmark::format(recover_time));
+}
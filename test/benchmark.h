@@ -0,0 +1,59 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TEST_BENCHMARK_H
+#define TEST_BENCHMARK_H
+
+#include <chrono>
+#include <string>
+
+/// Helpers for the hidden benchmark tests (tagged [!hide][benchmark]), which
+/// report their timings with WARN().
+namespace Benchmark
+{
+typedef std::chrono::high_resolution_clock Clock;
+
+/// Returns the average time taken by each call to the function.
+template <typename Function>
+Clock::duration measure(Function function, int iterations = 1)
+{
+    const Clock::time_point start = Clock::now();
+    for (int i = 0; i < iterations; ++i)
+        function();
+
+    return (Clock::now() - start) / iterations;
+}
+
+/// Formats a duration in milliseconds, or in microseconds if it is short.
+inline std::string format(Clock::duration duration)
+{
+    using std::chrono::duration_cast;
+
+    if (duration < std::chrono::milliseconds(10))
+    {
+        return std::to_string(
+                   duration_cast<std::chrono::microseconds>(duration).count()) +
+               " us";
+    }
+
+    return std::to_string(
+               duration_cast<std::chrono::milliseconds>(duration).count()) +
+           " ms";
+}
+}
+
+#endif
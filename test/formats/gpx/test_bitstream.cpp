@@ -0,0 +1,173 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <catch.hpp>
+
+#include "benchmark.h"
+#include <formats/gpx/bitstream.h>
+#include <random>
+
+namespace
+{
+/// Straightforward implementation that reads one bit at a time, for
+/// comparison.
+class SimpleBitStream
+{
+public:
+    SimpleBitStream(const std::vector<uint8_t> &bytes)
+        : myBytes(bytes), myPosition(0)
+    {
+    }
+
+    bool readBit()
+    {
+        if (myPosition / 8 >= myBytes.size())
+            return false;
+
+        const int bit = (myBytes[myPosition / 8] >> (7 - myPosition % 8)) & 1;
+        ++myPosition;
+        return bit != 0;
+    }
+
+    int32_t readBits(int n, Gpx::BitStream::BitOrder order)
+    {
+        int32_t value = 0;
+
+        if (order == Gpx::BitStream::Reversed)
+        {
+            for (int i = 0; i < n; ++i)
+                value |= (readBit() << i);
+        }
+        else
+        {
+            for (int i = n - 1; i >= 0; --i)
+                value |= (readBit() << i);
+        }
+
+        return value;
+    }
+
+private:
+    const std::vector<uint8_t> &myBytes;
+    size_t myPosition;
+};
+
+struct Read
+{
+    int myNumBits;
+    Gpx::BitStream::BitOrder myOrder;
+};
+}
+
+static std::vector<uint8_t> createRandomBytes(size_t length)
+{
+    std::mt19937 generator(1234);
+    std::uniform_int_distribution<int> dist(0, 255);
+
+    std::vector<uint8_t> bytes(length);
+    for (uint8_t &byte : bytes)
+        byte = static_cast<uint8_t>(dist(generator));
+    return bytes;
+}
+
+/// Creates a sequence of reads similar to the ones done when decompressing a
+/// .gpx file.
+static std::vector<Read> createReads(size_t num_reads)
+{
+    std::mt19937 generator(5678);
+    std::uniform_int_distribution<int> dist(0, 15);
+
+    std::vector<Read> reads;
+    for (size_t i = 0; i < num_reads; ++i)
+    {
+        const int p = dist(generator);
+        reads.push_back({ 1, Gpx::BitStream::Normal });
+        if (p % 2)
+            reads.push_back({ 2, Gpx::BitStream::Reversed });
+        reads.push_back({ 8, Gpx::BitStream::Normal });
+        reads.push_back({ p, Gpx::BitStream::Reversed });
+    }
+
+    return reads;
+}
+
+TEST_CASE("Formats/Gpx/BitStream/ReadBits", "")
+{
+    const std::vector<uint8_t> bytes = { 0x42, 0x43, 0x46, 0x5a, 0xb5, 0x01 };
+    Gpx::BitStream stream(bytes.data(), bytes.size());
+
+    REQUIRE(stream.readInt() == 0x5a464342);
+    REQUIRE(stream.getLocation() == 4);
+
+    // 0xb5 == 10110101
+    REQUIRE(stream.readBit());
+    REQUIRE(stream.readBits(3) == 3);
+    REQUIRE(stream.readBits(4, Gpx::BitStream::Reversed) == 10);
+    REQUIRE(stream.isAtEnd());
+
+    // Bits past the end of the stream are read as zero.
+    REQUIRE(stream.readBits(12) == 0x010);
+    REQUIRE(stream.readBits(32) == 0);
+}
+
+TEST_CASE("Formats/Gpx/BitStream/MatchesSimpleReader", "")
+{
+    const std::vector<uint8_t> bytes = createRandomBytes(1000);
+    const std::vector<Read> reads = createReads(500);
+
+    Gpx::BitStream stream(bytes.data(), bytes.size());
+    SimpleBitStream expected(bytes);
+
+    for (const Read &read : reads)
+    {
+        REQUIRE(stream.readBits(read.myNumBits, read.myOrder) ==
+                expected.readBits(read.myNumBits, read.myOrder));
+    }
+
+    // Read past the end of the data.
+    for (int i = 0; i < 100; ++i)
+    {
+        REQUIRE(stream.readBits(31, Gpx::BitStream::Reversed) ==
+                expected.readBits(31, Gpx::BitStream::Reversed));
+    }
+}
+
+TEST_CASE("Formats/Gpx/BitStream/Benchmark", "[!hide][benchmark]")
+{
+    const std::vector<uint8_t> bytes = createRandomBytes(16 * 1024 * 1024);
+    const std::vector<Read> reads = createReads(bytes.size() / 3);
+
+    int64_t sum = 0;
+
+    const auto simple_time = Benchmark::measure([&]() {
+        SimpleBitStream stream(bytes);
+        for (const Read &read : reads)
+            sum += stream.readBits(read.myNumBits, read.myOrder);
+    });
+
+    const auto buffered_time = Benchmark::measure([&]() {
+        Gpx::BitStream stream(bytes.data(), bytes.size());
+        for (const Read &read : reads)
+            sum -= stream.readBits(read.myNumBits, read.myOrder);
+    });
+
+    REQUIRE(sum == 0);
+
+    WARN("Read " << reads.size() << " values. Bit-at-a-time: "
+                 << Benchmark::format(simple_time)
+                 << ", buffered: " << Benchmark::format(buffered_time));
+}
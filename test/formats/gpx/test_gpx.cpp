@@ -18,7 +18,11 @@
 #include <catch.hpp>
 
 #include <app/appinfo.h>
+#include <formats/gpx/documentreader.h>
+#include <formats/gpx/filesystem.h>
 #include <formats/gpx/gpximporter.h>
+#include <fstream>
+#include <iterator>
 #include <score/score.h>
 
 TEST_CASE("Formats/GpxImport/Text", "")
@@ -32,4 +36,77 @@ TEST_CASE("Formats/GpxImport/Text", "")
     REQUIRE(system.getTextItems().size() == 1);
     REQUIRE(system.getTextItems()[0].getPosition() == 9);
     REQUIRE(system.getTextItems()[0].getContents() == "foo");
-}
\ No newline at end of file
+}
+static std::vector<char> readFile(const char *filename)
+{
+    std::ifstream file(AppInfo::getAbsolutePath(filename),
+                       std::ios::binary | std::ios::in);
+    return std::vector<char>((std::istreambuf_iterator<char>(file)),
+                             std::istreambuf_iterator<char>());
+}
+
+TEST_CASE("Formats/GpxImport/FileSystem", "")
+{
+    const std::vector<char> data = readFile("data/text.gpx");
+    Gpx::FileSystem fs(reinterpret_cast<const uint8_t *>(data.data()),
+                       data.size());
+
+    const std::string contents = fs.getFileContents("score.gpif");
+    REQUIRE(contents.size() == 10083);
+    REQUIRE(contents.compare(0, 5, "<?xml") == 0);
+    REQUIRE(contents.find("foo") != std::string::npos);
+
+    REQUIRE_THROWS_AS(fs.getFileContents("missing.xml"), FileFormatException);
+}
+
+TEST_CASE("Formats/GpxImport/IdTable", "")
+{
+    Gpx::IdTable<Gpx::Rhythm> table;
+    table.reset(2);
+
+    table[1].noteValue = 4;
+    REQUIRE(table.at(1).noteValue == 4);
+    REQUIRE(table.find(0) == nullptr);
+
+    // Referring to a missing object is an error in the file.
+    REQUIRE_THROWS_AS(table.at(0), FileFormatException);
+    REQUIRE_THROWS_AS(table.at(5), FileFormatException);
+    REQUIRE_THROWS_AS(table.at(-1), FileFormatException);
+
+    // Resetting the table removes the previous objects.
+    table.reset(2);
+    REQUIRE(table.find(1) == nullptr);
+}
+
+TEST_CASE("Formats/GpxImport/SparseIds", "")
+{
+    Gpx::IdTable<Gpx::Rhythm> table;
+    table.reset(4);
+
+    // The ids don't need to start at zero or be consecutive.
+    const int ids[] = { 3, 7, 1000, 0x7fffffff, -2 };
+    for (int id : ids)
+        table[id].noteValue = id;
+
+    for (int id : ids)
+        REQUIRE(table.at(id).noteValue == id);
+
+    REQUIRE(table.find(0) == nullptr);
+    REQUIRE(table.find(8) == nullptr);
+    REQUIRE(table.find(999) == nullptr);
+    REQUIRE(table.find(-1) == nullptr);
+}
+
+TEST_CASE("Formats/GpxImport/Timings", "[!hide][benchmark]")
+{
+    const std::vector<char> data = readFile("data/text.gpx");
+    Gpx::FileSystem fs(reinterpret_cast<const uint8_t *>(data.data()),
+                       data.size());
+
+    Score score;
+    Gpx::DocumentReader reader(fs.getFileContents("score.gpif"));
+    reader.readScore(score);
+
+    for (const PhaseTiming &timing : reader.getTimings())
+        WARN(timing.name << ": " << timing.seconds * 1000 << " ms");
+}
@@ -18,7 +18,11 @@
 #include <catch.hpp>
 
 #include <app/appinfo.h>
+#include "benchmark.h"
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <formats/guitar_pro/document.h>
 #include <formats/guitar_pro/guitarproimporter.h>
+#include <formats/guitar_pro/inputstream.h>
 #include <score/score.h>
 
 static void loadTest(GuitarProImporter &importer, const char *filename,
@@ -288,4 +292,110 @@ TEST_CASE("Formats/GuitarPro/IrregularGroups", "")
     REQUIRE(groups[2].getLength() == 6);
     REQUIRE(groups[2].getNotesPlayed() == 6);
     REQUIRE(groups[2].getNotesPlayedOver() == 4);
-}
\ No newline at end of file
+}
+TEST_CASE("Formats/GuitarPro/InputStream", "")
+{
+    const std::vector<uint8_t> data = {
+        24,  'F', 'I', 'C', 'H', 'I', 'E', 'R', ' ', 'G', 'U', 'I', 'T',
+        'A', 'R', ' ', 'P', 'R', 'O', ' ', 'v', '5', '.', '0', '0', 0,
+        0,   0,   0,   0,   0,   0x34, 0x12, 5, 0, 0, 0, 4, 't', 'e', 's',
+        't', 3,   'a', 'b'
+    };
+
+    Gp::InputStream stream(data.data(), data.size());
+    REQUIRE(stream.getVersion() == Gp::Version5_0);
+    REQUIRE(stream.read<uint16_t>() == 0x1234);
+    REQUIRE(stream.readStringView() == "test");
+
+    // The string is longer than the remaining data.
+    REQUIRE_THROWS_AS(stream.readFixedLengthStringView(3), FileFormatException);
+    REQUIRE_THROWS_AS(stream.read<uint32_t>(), FileFormatException);
+
+    // Unknown version.
+    const std::vector<uint8_t> invalid(40, 'a');
+    REQUIRE_THROWS_AS(Gp::InputStream(invalid.data(), invalid.size()),
+                      FileFormatException);
+}
+
+TEST_CASE("Formats/GuitarPro/TruncatedFile", "")
+{
+    boost::iostreams::mapped_file_source file(
+        AppInfo::getAbsolutePath("data/notes.gp5"));
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(file.data());
+
+    for (size_t length : { file.size() / 4, file.size() / 2, file.size() - 1 })
+    {
+        Gp::InputStream stream(data, length);
+        Gp::Document document;
+        REQUIRE_THROWS_AS(document.load(stream), FileFormatException);
+    }
+}
+
+namespace
+{
+/// Records the systems that are published during an import.
+class SystemRecorder : public ImportListener
+{
+public:
+    SystemRecorder() : myCancelled(false)
+    {
+    }
+
+    virtual void systemImported(const Score &score, int index) override
+    {
+        REQUIRE(index == static_cast<int>(mySystems.size()));
+        REQUIRE(!score.getPlayers().empty());
+        mySystems.push_back(score.getSystems()[index]);
+    }
+
+    virtual bool isCancelled() const override
+    {
+        return myCancelled;
+    }
+
+    std::vector<System> mySystems;
+    bool myCancelled;
+};
+}
+
+TEST_CASE("Formats/GuitarPro/PublishSystems", "")
+{
+    GuitarProImporter importer;
+    Score expected;
+    loadTest(importer, "data/rehearsal_signs.gp5", expected);
+
+    // The published systems should be identical to the final score.
+    SystemRecorder recorder;
+    importer.setListener(&recorder);
+    Score score;
+    loadTest(importer, "data/rehearsal_signs.gp5", score);
+
+    REQUIRE(score == expected);
+    REQUIRE(recorder.mySystems.size() == expected.getSystems().size());
+    for (size_t i = 0; i < recorder.mySystems.size(); ++i)
+        REQUIRE(recorder.mySystems[i] == expected.getSystems()[i]);
+
+    recorder.myCancelled = true;
+    Score cancelled;
+    REQUIRE_THROWS_AS(
+        loadTest(importer, "data/rehearsal_signs.gp5", cancelled),
+        ImportCancelledException);
+}
+
+TEST_CASE("Formats/GuitarPro/Benchmark", "[!hide][benchmark]")
+{
+    for (const char *filename :
+         { "data/notes.gp5", "data/positions.gp5", "data/text.gp5" })
+    {
+        const auto import_time = Benchmark::measure(
+            [=]() {
+                Score score;
+                GuitarProImporter importer;
+                loadTest(importer, filename, score);
+            },
+            200);
+
+        WARN(filename << ": " << Benchmark::format(import_time)
+                      << " per import");
+    }
+}
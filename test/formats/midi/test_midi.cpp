@@ -0,0 +1,372 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <catch.hpp>
+
+#include <app/appinfo.h>
+#include <formats/midi/midiexporter.h>
+#include <formats/midi/midiimporter.h>
+#include <midi/midieventlist.h>
+#include <score/score.h>
+
+static void loadTest(MidiImporter &importer, const char *filename,
+                     Score &score)
+{
+    importer.load(AppInfo::getAbsolutePath(filename), score);
+}
+
+/// Appends a variable-length quantity.
+static void appendVarLen(std::vector<uint8_t> &data, uint32_t val)
+{
+    std::vector<uint8_t> bytes = { static_cast<uint8_t>(val & 0x7f) };
+    while (val >>= 7)
+        bytes.insert(bytes.begin(), static_cast<uint8_t>((val & 0x7f) | 0x80));
+    data.insert(data.end(), bytes.begin(), bytes.end());
+}
+
+/// Creates a type 0 file with a sequence of sixteenth notes.
+static std::vector<uint8_t> createMidiFile(int num_notes)
+{
+    std::vector<uint8_t> track;
+    for (int i = 0; i < num_notes; ++i)
+    {
+        const uint8_t pitch = 40 + i % 24;
+        appendVarLen(track, 0);
+        track.insert(track.end(), { 0x90, pitch, 100 });
+        appendVarLen(track, 120);
+        track.insert(track.end(), { 0x80, pitch, 0 });
+    }
+    track.insert(track.end(), { 0x00, 0xff, 0x2f, 0x00 });
+
+    std::vector<uint8_t> data = { 'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0,
+                                  0,   1,   1,   0xe0, 'M', 'T', 'r', 'k' };
+    const uint32_t length = static_cast<uint32_t>(track.size());
+    data.insert(data.end(),
+                { static_cast<uint8_t>(length >> 24),
+                  static_cast<uint8_t>(length >> 16),
+                  static_cast<uint8_t>(length >> 8),
+                  static_cast<uint8_t>(length) });
+    data.insert(data.end(), track.begin(), track.end());
+    return data;
+}
+
+/// Reads a variable-length quantity, advancing the offset.
+static uint32_t readVarLen(const std::vector<uint8_t> &data, size_t &offset)
+{
+    uint32_t val = 0;
+    uint8_t byte;
+    do
+    {
+        byte = data.at(offset++);
+        val = (val << 7) | (byte & 0x7f);
+    } while (byte & 0x80);
+
+    return val;
+}
+
+/// Reads a big-endian 32-bit value, advancing the offset.
+static uint32_t readInt(const std::vector<uint8_t> &data, size_t &offset)
+{
+    uint32_t val = 0;
+    for (int i = 0; i < 4; ++i)
+        val = (val << 8) | data.at(offset++);
+    return val;
+}
+
+TEST_CASE("Formats/MidiExport/VariableLength", "")
+{
+    // Values on either side of each boundary between encoded lengths.
+    const std::vector<std::pair<uint32_t, size_t>> values = {
+        { 0, 1 },         { 0x7f, 1 },       { 0x80, 2 },
+        { 0x3fff, 2 },    { 0x4000, 3 },     { 0x1fffff, 3 },
+        { 0x200000, 4 },  { 0x0fffffff, 4 }
+    };
+
+    for (auto &&value : values)
+    {
+        std::vector<uint8_t> buffer;
+        MidiExporter::writeVariableLength(buffer, value.first);
+        REQUIRE(buffer.size() == value.second);
+
+        std::vector<uint8_t> expected;
+        appendVarLen(expected, value.first);
+        REQUIRE(buffer == expected);
+
+        size_t offset = 0;
+        REQUIRE(readVarLen(buffer, offset) == value.first);
+        REQUIRE(offset == buffer.size());
+    }
+
+    // Check the exact encodings from the Standard MIDI File specification.
+    std::vector<uint8_t> buffer;
+    MidiExporter::writeVariableLength(buffer, 0x80);
+    REQUIRE(buffer == std::vector<uint8_t>({ 0x81, 0x00 }));
+
+    buffer.clear();
+    MidiExporter::writeVariableLength(buffer, 0x3fff);
+    REQUIRE(buffer == std::vector<uint8_t>({ 0xff, 0x7f }));
+
+    buffer.clear();
+    MidiExporter::writeVariableLength(buffer, 0x4000);
+    REQUIRE(buffer == std::vector<uint8_t>({ 0x81, 0x80, 0x00 }));
+
+    buffer.clear();
+    MidiExporter::writeVariableLength(buffer, 0x0fffffff);
+    REQUIRE(buffer == std::vector<uint8_t>({ 0xff, 0xff, 0xff, 0x7f }));
+}
+
+TEST_CASE("Formats/MidiExport/Track", "")
+{
+    MidiEventList events(false);
+    events.append(MidiEvent::noteOn(0, 0, 60, 100, SystemLocation()));
+    events.append(MidiEvent::noteOff(0x7f, 0, 60, SystemLocation()));
+    events.append(MidiEvent::noteOn(0x80, 0, 62, 100, SystemLocation()));
+    events.append(MidiEvent::noteOff(0x3fff, 0, 62, SystemLocation()));
+    events.append(MidiEvent::programChange(0x4000, 0, 25));
+    events.append(MidiEvent::noteOn(0x0fffffff, 0, 64, 100, SystemLocation()));
+    events.append(MidiEvent::endOfTrack(0));
+
+    // Start with some existing data to check that the chunk is appended.
+    std::vector<uint8_t> buffer = { 1, 2, 3 };
+    MidiExporter::writeTrack(buffer, events);
+
+    size_t offset = 3;
+    REQUIRE(std::equal(buffer.begin() + offset, buffer.begin() + offset + 4,
+                       "MTrk"));
+    offset += 4;
+    const uint32_t length = readInt(buffer, offset);
+    REQUIRE(offset + length == buffer.size());
+
+    for (const MidiEvent &event : events)
+    {
+        REQUIRE(readVarLen(buffer, offset) ==
+                static_cast<uint32_t>(event.getTicks()));
+
+        const std::vector<uint8_t> &data = event.getData();
+        REQUIRE(std::equal(data.begin(), data.end(),
+                           buffer.begin() + offset));
+        offset += data.size();
+    }
+
+    REQUIRE(offset == buffer.size());
+}
+
+TEST_CASE("Formats/MidiExport/RoundTrip", "")
+{
+    // A quarter note, a quarter rest and a half note in a bar of 4/4, with
+    // delta times that need one, two and three bytes.
+    const int ticks_per_quarter = 0x2000;
+    MidiEventList events(false);
+    events.append(MidiEvent::noteOn(0, 0, 40, 100, SystemLocation()));
+    events.append(
+        MidiEvent::noteOff(ticks_per_quarter - 1, 0, 40, SystemLocation()));
+    events.append(MidiEvent::noteOn(ticks_per_quarter + 1, 0, 45, 100,
+                                    SystemLocation()));
+    events.append(
+        MidiEvent::noteOff(2 * ticks_per_quarter, 0, 45, SystemLocation()));
+    events.append(MidiEvent::endOfTrack(0));
+
+    std::vector<uint8_t> data = { 'M', 'T', 'h', 'd', 0, 0, 0, 6,
+                                  0,   0,   0,   1,   0x20, 0x00 };
+    MidiExporter::writeTrack(data, events);
+
+    Score score;
+    MidiImporter importer;
+    importer.load(data.data(), data.size(), score);
+
+    REQUIRE(importer.getTimings().front().count == events.size());
+    REQUIRE(score.getSystems().size() == 1);
+
+    const Voice &voice = score.getSystems()[0].getStaves()[0].getVoices()[0];
+    const auto &positions = voice.getPositions();
+    REQUIRE(positions.size() == 3);
+    REQUIRE(positions[0].getDurationType() == Position::QuarterNote);
+    REQUIRE(positions[0].getNotes()[0] == Note(5, 0));
+    REQUIRE(positions[1].isRest());
+    REQUIRE(positions[2].getDurationType() == Position::HalfNote);
+    REQUIRE(positions[2].getNotes()[0] == Note(4, 0));
+}
+
+TEST_CASE("Formats/MidiImport/Players", "")
+{
+    Score score;
+    MidiImporter importer;
+    loadTest(importer, "data/notes.mid", score);
+
+    // The percussion track should be skipped.
+    REQUIRE(score.getPlayers().size() == 2);
+    REQUIRE(score.getPlayers()[0].getDescription() == "Guitar");
+    REQUIRE(score.getPlayers()[0].getTuning().getStringCount() == 6);
+    REQUIRE(score.getInstruments()[0].getMidiPreset() == 25);
+    REQUIRE(score.getPlayers()[1].getDescription() == "Bass");
+    REQUIRE(score.getPlayers()[1].getTuning().getStringCount() == 4);
+    REQUIRE(score.getInstruments()[1].getMidiPreset() == 33);
+
+    REQUIRE(importer.getTimings().front().count == 57);
+}
+
+TEST_CASE("Formats/MidiImport/Bars", "")
+{
+    Score score;
+    MidiImporter importer;
+    loadTest(importer, "data/notes.mid", score);
+
+    REQUIRE(score.getSystems().size() == 1);
+    const System &system = score.getSystems()[0];
+
+    const auto &barlines = system.getBarlines();
+    REQUIRE(barlines.size() == 5);
+    REQUIRE(barlines[0].getTimeSignature().getBeatsPerMeasure() == 3);
+    REQUIRE(barlines[0].getTimeSignature().isVisible());
+    REQUIRE(!barlines[1].getTimeSignature().isVisible());
+    REQUIRE(barlines[2].getTimeSignature().getBeatsPerMeasure() == 4);
+    REQUIRE(barlines[2].getTimeSignature().isVisible());
+    REQUIRE(barlines[4].getBarType() == Barline::DoubleBarFine);
+
+    const auto &tempos = system.getTempoMarkers();
+    REQUIRE(tempos.size() == 2);
+    REQUIRE(tempos[0].getBeatsPerMinute() == 100);
+    // The tempo change should be at the start of the last bar.
+    const Position &first_pos =
+        system.getStaves()[0].getVoices()[0].getPositions()[8];
+    REQUIRE(tempos[1].getPosition() == first_pos.getPosition());
+    REQUIRE(barlines[3].getPosition() < tempos[1].getPosition());
+    REQUIRE(tempos[1].getBeatsPerMinute() == 140);
+}
+
+TEST_CASE("Formats/MidiImport/Bars/MidBarTimeSignature", "")
+{
+    // A time signature change in the middle of a bar should take effect at
+    // the next barline. The events use delta times.
+    MidiEventList events(false);
+    events.append(MidiEvent::noteOn(0, 0, 40, 100, SystemLocation()));
+    events.append(MidiEvent::timeSignature(480, 3, 4));
+    events.append(MidiEvent::setTempo(0, 500000));
+    events.append(MidiEvent::noteOff(5 * 480, 0, 40, SystemLocation()));
+    events.append(MidiEvent::endOfTrack(0));
+
+    std::vector<uint8_t> data = { 'M', 'T', 'h', 'd', 0, 0, 0, 6,
+                                  0,   0,   0,   1,   0x01, 0xe0 };
+    MidiExporter::writeTrack(data, events);
+
+    Score score;
+    MidiImporter importer;
+    importer.load(data.data(), data.size(), score);
+
+    const auto &barlines = score.getSystems()[0].getBarlines();
+    REQUIRE(barlines.size() == 3);
+    REQUIRE(barlines[0].getTimeSignature().getBeatsPerMeasure() == 4);
+    REQUIRE(barlines[1].getTimeSignature().getBeatsPerMeasure() == 3);
+    REQUIRE(barlines[1].getTimeSignature().getBeatValue() == 4);
+    REQUIRE(barlines[1].getTimeSignature().isVisible());
+}
+
+TEST_CASE("Formats/MidiImport/Notes", "")
+{
+    Score score;
+    MidiImporter importer;
+    loadTest(importer, "data/notes.mid", score);
+
+    const System &system = score.getSystems()[0];
+    const Voice &guitar = system.getStaves()[0].getVoices()[0];
+    const auto &positions = guitar.getPositions();
+    REQUIRE(positions.size() == 10);
+
+    REQUIRE(positions[0].getDurationType() == Position::QuarterNote);
+    REQUIRE(positions[0].getNotes()[0] == Note(0, 0));
+
+    // Chord, which is stopped slightly early.
+    REQUIRE(positions[1].getDurationType() == Position::QuarterNote);
+    REQUIRE(positions[1].getNotes().size() == 3);
+    REQUIRE(positions[1].getNotes()[0] == Note(3, 2));
+    REQUIRE(positions[1].getNotes()[1] == Note(4, 2));
+    REQUIRE(positions[1].getNotes()[2] == Note(5, 0));
+    REQUIRE(positions[2].isRest());
+
+    REQUIRE(positions[3].getDurationType() == Position::HalfNote);
+    REQUIRE(positions[3].hasProperty(Position::Dotted));
+
+    // The first note is slightly late, and the second note is stopped with a
+    // zero-velocity note on.
+    REQUIRE(positions[4].getDurationType() == Position::EighthNote);
+    REQUIRE(positions[4].getNotes()[0] == Note(2, 2));
+    REQUIRE(positions[5].getDurationType() == Position::EighthNote);
+    REQUIRE(positions[5].getNotes()[0] == Note(1, 0));
+    REQUIRE(positions[6].isRest());
+    REQUIRE(positions[6].getDurationType() == Position::HalfNote);
+
+    // A note that crosses the barline is split into tied notes.
+    REQUIRE(positions[7].getNotes()[0] == Note(1, 3));
+    REQUIRE(positions[8].getNotes()[0].getFretNumber() == 3);
+    REQUIRE(positions[8].getNotes()[0].hasProperty(Note::Tied));
+    REQUIRE(positions[9].isRest());
+
+    // Bass, which uses running status.
+    const Voice &bass = system.getStaves()[1].getVoices()[0];
+    REQUIRE(bass.getPositions().size() == 5);
+    REQUIRE(bass.getPositions()[0].getNotes()[0] == Note(3, 0));
+    REQUIRE(bass.getPositions()[1].isRest());
+    REQUIRE(bass.getPositions()[2].getNotes()[0] == Note(2, 0));
+}
+
+TEST_CASE("Formats/MidiImport/InvalidFile", "")
+{
+    MidiImporter importer;
+
+    std::vector<uint8_t> data = createMidiFile(4);
+    data.resize(data.size() - 6);
+
+    Score score;
+    REQUIRE_THROWS_AS(importer.load(data.data(), data.size(), score),
+                      FileFormatException);
+
+    // A status byte where running status expects a data byte.
+    std::vector<uint8_t> running_status = createMidiFile(4);
+    const size_t note_off = 14 + 8 + 5;
+    REQUIRE(running_status[note_off] == 0x80);
+    running_status[note_off] = 0x40;
+    running_status[note_off + 1] = 0x90;
+    Score score3;
+    REQUIRE_THROWS_AS(
+        importer.load(running_status.data(), running_status.size(), score3),
+        FileFormatException);
+
+    const std::vector<uint8_t> text = { 'a', 'b', 'c' };
+    Score score2;
+    REQUIRE_THROWS_AS(importer.load(text.data(), text.size(), score2),
+                      FileFormatException);
+}
+
+TEST_CASE("Formats/MidiImport/Benchmark", "[!hide][benchmark]")
+{
+    const std::vector<uint8_t> data = createMidiFile(200000);
+
+    Score score;
+    MidiImporter importer;
+    importer.load(data.data(), data.size(), score);
+
+    for (const PhaseTiming &timing : importer.getTimings())
+    {
+        WARN(timing.name << ": " << timing.seconds * 1000 << " ms");
+        if (timing.count > 0)
+        {
+            WARN("    " << timing.count << " events, "
+                        << static_cast<int>(timing.count / timing.seconds)
+                        << " events/sec");
+        }
+    }
+}
@@ -0,0 +1,232 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <catch.hpp>
+
+#include <app/appinfo.h>
+#include "benchmark.h"
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_streambuf.hpp>
+#include <formats/powertab/powertabexporter.h>
+#include <formats/powertab/powertabimporter.h>
+#include <formats/settings.h>
+#include <fstream>
+#include <score/binaryserialization.h>
+#include <score/score.h>
+#include <score/serialization.h>
+#include <util/atomicfile.h>
+#include <util/settingsmanager.h>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/resource.h>
+#endif
+
+static void loadScore(Score &score)
+{
+    PowerTabImporter importer;
+    importer.load(AppInfo::getAbsolutePath("data/test_viewfilter.pt2"), score);
+}
+
+/// Returns whether the compressed file contains a binary archive.
+static bool isBinaryFile(const std::string &filename)
+{
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
+    boost::iostreams::filtering_istreambuf in;
+    in.push(boost::iostreams::gzip_decompressor());
+    in.push(file);
+
+    std::istream input(&in);
+    return ScoreUtils::isBinaryArchive(input);
+}
+
+TEST_CASE("Formats/PowerTabExport/Encoding", "")
+{
+    Score score;
+    loadScore(score);
+
+    const boost::filesystem::path path =
+        boost::filesystem::temp_directory_path() /
+        boost::filesystem::unique_path("%%%%-%%%%-%%%%.pt2");
+
+    SettingsManager settings_manager;
+    PowerTabExporter exporter(settings_manager);
+
+    for (bool binary : { false, true })
+    {
+        {
+            auto settings = settings_manager.getWriteHandle();
+            settings->set(Settings::SavePowerTabAsBinary, binary);
+        }
+
+        exporter.save(path.string(), score);
+        REQUIRE(isBinaryFile(path.string()) == binary);
+
+        Score copy;
+        PowerTabImporter importer;
+        importer.load(path.string(), copy);
+        REQUIRE(copy == score);
+    }
+
+    boost::filesystem::remove(path);
+}
+
+TEST_CASE("Formats/PowerTabExport/Compression", "")
+{
+    Score score;
+    loadScore(score);
+
+    const boost::filesystem::path path =
+        boost::filesystem::temp_directory_path() /
+        boost::filesystem::unique_path("%%%%-%%%%-%%%%.pt2");
+
+    SettingsManager settings_manager;
+    PowerTabExporter exporter(settings_manager);
+
+    // Out of range values are clamped.
+    std::vector<uintmax_t> sizes;
+    for (int level : { -5, 0, 9, 20 })
+    {
+        {
+            auto settings = settings_manager.getWriteHandle();
+            settings->set(Settings::PowerTabCompressionLevel, level);
+            settings->set(Settings::PowerTabCompressionBufferSize, 1);
+        }
+
+        exporter.save(path.string(), score);
+        sizes.push_back(boost::filesystem::file_size(path));
+
+        Score copy;
+        PowerTabImporter importer;
+        importer.load(path.string(), copy);
+        REQUIRE(copy == score);
+    }
+
+    REQUIRE(sizes[0] == sizes[1]);
+    REQUIRE(sizes[1] > sizes[2]);
+    REQUIRE(sizes[2] == sizes[3]);
+
+    boost::filesystem::remove(path);
+}
+
+TEST_CASE("Formats/PowerTabExport/WriteErrors", "")
+{
+    Score score;
+    loadScore(score);
+
+    SettingsManager settings_manager;
+    PowerTabExporter exporter(settings_manager);
+
+    const boost::filesystem::path dir =
+        boost::filesystem::temp_directory_path() /
+        boost::filesystem::unique_path();
+    boost::filesystem::create_directories(dir);
+
+    // The file can't be created.
+    REQUIRE_THROWS(
+        exporter.save((dir / "missing" / "test.pt2").string(), score));
+
+#ifndef _WIN32
+    // Limit the size of files that can be written, so that the export fails
+    // partway through writing the file.
+    const boost::filesystem::path path = dir / "test.pt2";
+    {
+        std::ofstream file(path.string());
+        file << "original contents";
+    }
+
+    rlimit old_limit;
+    getrlimit(RLIMIT_FSIZE, &old_limit);
+    rlimit limit = old_limit;
+    limit.rlim_cur = 64;
+    auto old_handler = signal(SIGXFSZ, SIG_IGN);
+    setrlimit(RLIMIT_FSIZE, &limit);
+
+    bool failed = false;
+    try
+    {
+        Util::writeFileAtomically(path.string(), [&](const std::string &temp) {
+            exporter.save(temp, score);
+        });
+    }
+    catch (const std::exception &)
+    {
+        failed = true;
+    }
+
+    setrlimit(RLIMIT_FSIZE, &old_limit);
+    signal(SIGXFSZ, old_handler);
+
+    // The original file should not be replaced by a truncated file.
+    REQUIRE(failed);
+    std::ifstream file(path.string());
+    std::string contents;
+    std::getline(file, contents);
+    REQUIRE(contents == "original contents");
+    file.close();
+#endif
+
+    boost::filesystem::remove_all(dir);
+}
+
+TEST_CASE("Formats/PowerTabExport/Benchmark", "[!hide][benchmark]")
+{
+    Score score;
+    loadScore(score);
+
+    // Make a much larger score by repeating the systems.
+    const System system = score.getSystems()[0];
+    for (int i = 0; i < 2000; ++i)
+        score.insertSystem(system);
+
+    const boost::filesystem::path path =
+        boost::filesystem::temp_directory_path() /
+        boost::filesystem::unique_path("%%%%-%%%%-%%%%.pt2");
+
+    // The previous save path: pretty-printed JSON, compressed with the
+    // default gzip settings on the same thread.
+    const auto old_save_time = Benchmark::measure([&]() {
+        std::ofstream file(path.string(), std::ios::out | std::ios::binary);
+        boost::iostreams::filtering_ostreambuf out;
+        out.push(boost::iostreams::gzip_compressor());
+        out.push(file);
+
+        std::ostream output(&out);
+        ScoreUtils::save(output, "score", score,
+                         ScoreUtils::JsonFormat::Pretty);
+    });
+    const auto old_size = boost::filesystem::file_size(path);
+
+    SettingsManager settings_manager;
+    PowerTabExporter exporter(settings_manager);
+    const auto new_save_time =
+        Benchmark::measure([&]() { exporter.save(path.string(), score); });
+    const auto new_size = boost::filesystem::file_size(path);
+
+    Score copy;
+    PowerTabImporter importer;
+    importer.load(path.string(), copy);
+    REQUIRE(copy == score);
+
+    boost::filesystem::remove(path);
+
+    WARN("Before: " << old_size << " bytes, save "
+                    << Benchmark::format(old_save_time));
+    WARN("After: " << new_size << " bytes, save "
+                   << Benchmark::format(new_save_time));
+}
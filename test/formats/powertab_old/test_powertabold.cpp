@@ -18,9 +18,12 @@
 #include <catch.hpp>
 
 #include <app/appinfo.h>
+#include <array>
+#include "benchmark.h"
 #include <formats/powertab/powertabimporter.h>
 #include <formats/powertab_old/powertaboldimporter.h>
 #include <formats/powertab_old/powertabdocument/powertabdocument.h>
+#include <formats/powertab_old/powertabdocument/powertabinputstream.h>
 #include <score/score.h>
 
 static void loadTest(FileFormatImporter &importer, const char *filename,
@@ -379,3 +382,55 @@ TEST_CASE("Formats/PowerTabOldImport/MergeMultiBarRests", "")
 
     REQUIRE(score == expected_score);
 }
+
+TEST_CASE("Formats/PowerTabOldImport/InputStream", "")
+{
+    const std::vector<uint8_t> data = {
+        // 16-bit count
+        0x34, 0x12,
+        // 32-bit count
+        0xff, 0xff, 0x78, 0x56, 0x34, 0x12,
+        // String
+        4, 't', 'e', 's', 't',
+        // Small vector with more elements than the array can hold
+        3, 1, 0, 0, 0
+    };
+
+    PowerTabDocument::PowerTabInputStream stream(data.data(), data.size());
+    REQUIRE(stream.ReadCount() == 0x1234);
+    REQUIRE(stream.ReadCount() == 0x12345678);
+
+    std::string str;
+    stream.ReadMFCString(str);
+    REQUIRE(str == "test");
+
+    std::array<uint32_t, 2> array;
+    REQUIRE_THROWS_AS(stream.ReadSmallVector(array), std::ios_base::failure);
+
+    // Reading past the end of the data.
+    uint32_t value;
+    REQUIRE_THROWS_AS(stream >> value >> value, std::ios_base::failure);
+}
+
+TEST_CASE("Formats/PowerTabOldImport/Benchmark", "[!hide][benchmark]")
+{
+    for (const char *filename :
+         { "data/notes.ptb", "data/positions.ptb", "data/staves.ptb" })
+    {
+        std::vector<PhaseTiming> timings;
+        const auto import_time = Benchmark::measure(
+            [&]() {
+                Score score;
+                PowerTabOldImporter importer;
+                loadTest(importer, filename, score);
+                timings = importer.getTimings();
+            },
+            200);
+
+        WARN(filename << ": " << Benchmark::format(import_time)
+                      << " per import");
+        for (const PhaseTiming &timing : timings)
+            WARN("    " << timing.name << ": " << timing.seconds * 1000
+                        << " ms");
+    }
+}
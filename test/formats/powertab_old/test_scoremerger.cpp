@@ -0,0 +1,164 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <catch.hpp>
+
+#include "benchmark.h"
+#include <formats/powertab_old/scoremerger.h>
+#include <score/score.h>
+
+static void addPlayer(Score &score, int num_strings)
+{
+    Tuning tuning;
+    tuning.setNotes(std::vector<uint8_t>(num_strings, 40));
+
+    Player player;
+    player.setTuning(tuning);
+    score.insertPlayer(player);
+    score.insertInstrument(Instrument());
+}
+
+/// Creates a single bar containing either a few notes or a multi-bar rest.
+static void addBar(System &system, int num_strings, int start, int rest_count)
+{
+    if (start > 0)
+        system.insertBarline(Barline(start, Barline::SingleBar));
+
+    if (system.getStaves().empty())
+        system.insertStaff(Staff(num_strings));
+
+    Voice &voice = system.getStaves()[0].getVoices()[0];
+    const int first_pos = (start > 0) ? start + 1 : 0;
+
+    if (rest_count > 0)
+    {
+        Position rest(first_pos, Position::WholeNote);
+        rest.setRest();
+        rest.setMultiBarRest(rest_count);
+        voice.insertPosition(rest);
+    }
+    else
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            Position pos(first_pos + i, Position::QuarterNote);
+            pos.insertNote(Note(i % num_strings, i));
+            voice.insertPosition(pos);
+        }
+    }
+}
+
+/// Creates a long score, with a multi-bar rest, player change, and repeated
+/// section every few bars.
+static void createLongScore(Score &score, int num_strings, int num_bars)
+{
+    addPlayer(score, num_strings);
+
+    const int bars_per_system = 4;
+    const int bar_width = 8;
+    for (int bar = 0; bar < num_bars; bar += bars_per_system)
+    {
+        System system;
+        system.getBarlines().back().setPosition(bars_per_system * bar_width);
+
+        for (int i = 0; i < bars_per_system; ++i)
+        {
+            const int start = i * bar_width;
+            addBar(system, num_strings, start, (bar + i) % 10 == 9 ? 4 : 0);
+
+            if ((bar + i) % 16 == 2)
+                system.getBarlines()[i].setBarType(Barline::RepeatStart);
+        }
+
+        if (bar % 16 == 4)
+        {
+            Barline &repeat_end = system.getBarlines()[2];
+            repeat_end.setBarType(Barline::RepeatEnd);
+            repeat_end.setRepeatCount(2);
+        }
+
+        PlayerChange change(0);
+        change.insertActivePlayer(0, ActivePlayer(0, 0));
+        if (bar % 8 == 0)
+            system.insertPlayerChange(change);
+
+        score.insertSystem(system);
+    }
+}
+
+TEST_CASE("Formats/ScoreMerger/MultiBarRests", "")
+{
+    // The guitar score has a four bar rest, while the bass score has a single
+    // bar of notes followed by a three bar rest.
+    Score guitar_score;
+    addPlayer(guitar_score, 6);
+    {
+        System system;
+        addBar(system, 6, 0, 4);
+        guitar_score.insertSystem(system);
+    }
+
+    Score bass_score;
+    addPlayer(bass_score, 4);
+    {
+        System system;
+        addBar(system, 4, 0, 0);
+        addBar(system, 4, 8, 3);
+        bass_score.insertSystem(system);
+    }
+
+    Score score;
+    ScoreMerger::merge(score, guitar_score, bass_score);
+
+    REQUIRE(score.getPlayers().size() == 2);
+    REQUIRE(score.getSystems().size() == 1);
+
+    // The first bar of the guitar's rest should become a whole rest alongside
+    // the bass notes, and the remaining bars should be merged into a single
+    // multi-bar rest.
+    const System &system = score.getSystems()[0];
+    REQUIRE(system.getBarlines().size() == 3);
+    REQUIRE(system.getStaves().size() == 2);
+
+    const Voice &guitar_voice = system.getStaves()[0].getVoices()[0];
+    REQUIRE(guitar_voice.getPositions().size() == 2);
+    REQUIRE(guitar_voice.getPositions()[0].isRest());
+    REQUIRE(!guitar_voice.getPositions()[0].hasMultiBarRest());
+    REQUIRE(guitar_voice.getPositions()[1].getMultiBarRestCount() == 3);
+
+    const Voice &bass_voice = system.getStaves()[1].getVoices()[0];
+    REQUIRE(bass_voice.getPositions().size() == 5);
+    REQUIRE(bass_voice.getPositions()[4].getMultiBarRestCount() == 3);
+}
+
+TEST_CASE("Formats/ScoreMerger/Benchmark", "[!hide][benchmark]")
+{
+    for (int num_bars : { 1000, 2000, 4000 })
+    {
+        Score guitar_score;
+        createLongScore(guitar_score, 6, num_bars);
+        Score bass_score;
+        createLongScore(bass_score, 4, num_bars);
+
+        Score score;
+        const auto merge_time = Benchmark::measure([&]() {
+            ScoreMerger::merge(score, guitar_score, bass_score);
+        });
+
+        WARN(num_bars << " bars: " << Benchmark::format(merge_time));
+    }
+}
@@ -0,0 +1,89 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <catch.hpp>
+
+#include <app/appinfo.h>
+#include <boost/filesystem.hpp>
+#include <formats/batchconverter.h>
+#include <fstream>
+#include <map>
+#include <util/settingsmanager.h>
+
+namespace fs = boost::filesystem;
+
+TEST_CASE("Formats/BatchConverter/FindJobs", "")
+{
+    SettingsManager settings_manager;
+    BatchConverter converter(settings_manager, "pt2");
+
+    std::vector<ConversionJob> jobs = converter.findJobs(
+        { AppInfo::getAbsolutePath("data/g*s.ptb"),
+          AppInfo::getAbsolutePath("data/notes.gp5") },
+        "out");
+
+    REQUIRE(jobs.size() == 3);
+    REQUIRE(fs::path(jobs[0].inputFile).filename() == "guitar_ins.ptb");
+    REQUIRE(fs::path(jobs[0].outputFile) ==
+            fs::path("out") / "guitar_ins.pt2");
+    REQUIRE(fs::path(jobs[1].inputFile).filename() == "guitars.ptb");
+    REQUIRE(fs::path(jobs[2].outputFile) == fs::path("out") / "notes.pt2");
+
+    REQUIRE_THROWS(BatchConverter(settings_manager, "gp5"));
+}
+
+TEST_CASE("Formats/BatchConverter/Convert", "")
+{
+    const fs::path dir = fs::temp_directory_path() / fs::unique_path();
+    const fs::path input_dir = dir / "input";
+    fs::create_directories(input_dir / "nested");
+    fs::copy_file(AppInfo::getAbsolutePath("data/guitars.ptb"),
+                  input_dir / "guitars.ptb");
+    fs::copy_file(AppInfo::getAbsolutePath("data/notes.gp5"),
+                  input_dir / "nested" / "notes.gp5");
+    {
+        std::ofstream file((input_dir / "invalid.gp5").string());
+        file << "not a Guitar Pro file";
+    }
+
+    SettingsManager settings_manager;
+    BatchConverter converter(settings_manager, "pt2");
+    std::vector<ConversionJob> jobs =
+        converter.findJobs({ input_dir.string() }, (dir / "output").string());
+    REQUIRE(jobs.size() == 3);
+
+    std::map<std::string, ConversionResult> results;
+    converter.convert(jobs, 2, [&](const ConversionResult &result) {
+        results.insert(std::make_pair(
+            fs::path(result.job.inputFile).filename().string(), result));
+    });
+
+    REQUIRE(results.size() == 3);
+    REQUIRE(results.at("guitars.ptb").success);
+    REQUIRE(results.at("guitars.ptb").bytes > 0);
+    REQUIRE(results.at("guitars.ptb").timings.size() == 2);
+    REQUIRE(fs::exists(dir / "output" / "guitars.pt2"));
+
+    REQUIRE(results.at("notes.gp5").success);
+    REQUIRE(fs::exists(dir / "output" / "nested" / "notes.pt2"));
+
+    REQUIRE(!results.at("invalid.gp5").success);
+    REQUIRE(!results.at("invalid.gp5").error.empty());
+    REQUIRE(!fs::exists(dir / "output" / "invalid.pt2"));
+
+    fs::remove_all(dir);
+}
@@ -0,0 +1,144 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <catch.hpp>
+
+#include <app/appinfo.h>
+#include <boost/filesystem.hpp>
+#include <formats/fileformatmanager.h>
+#include <fstream>
+#include <score/score.h>
+#include <util/settingsmanager.h>
+
+namespace fs = boost::filesystem;
+
+static boost::optional<FileProbe> probe(const FileFormatManager &manager,
+                                        const char *filename)
+{
+    return manager.probeFile(AppInfo::getAbsolutePath(filename));
+}
+
+TEST_CASE("Formats/FileFormatManager/ProbeFile", "")
+{
+    SettingsManager settings_manager;
+    FileFormatManager manager(settings_manager);
+
+    auto result = probe(manager, "data/song_header.ptb");
+    REQUIRE(result);
+    REQUIRE(result->format.name() == "Power Tab 1.7 Document");
+    REQUIRE(result->scoreInfo);
+    REQUIRE(result->scoreInfo->getSongData().getTitle() == "Some Title");
+    REQUIRE(result->scoreInfo->getSongData().getArtist() == "Some Artist");
+
+    result = probe(manager, "data/notes.gp5");
+    REQUIRE(result);
+    REQUIRE(result->format == *manager.findFormat("gp5"));
+    REQUIRE(result->scoreInfo);
+
+    result = probe(manager, "data/test_editstaff.pt2");
+    REQUIRE(result);
+    REQUIRE(result->format == *manager.findFormat("pt2"));
+    REQUIRE(result->scoreInfo);
+
+    // The score information for these formats isn't stored in a header.
+    result = probe(manager, "data/text.gpx");
+    REQUIRE(result);
+    REQUIRE(result->format == *manager.findFormat("gpx"));
+    REQUIRE(!result->scoreInfo);
+
+    result = probe(manager, "data/notes.mid");
+    REQUIRE(result);
+    REQUIRE(result->format == *manager.findFormat("mid"));
+    REQUIRE(!result->scoreInfo);
+}
+
+TEST_CASE("Formats/FileFormatManager/DetectFormat", "")
+{
+    const fs::path dir = fs::temp_directory_path() / fs::unique_path();
+    fs::create_directories(dir);
+
+    SettingsManager settings_manager;
+    FileFormatManager manager(settings_manager);
+
+    SECTION("Misnamed file")
+    {
+        const fs::path path = dir / "notes.ptb";
+        fs::copy_file(AppInfo::getAbsolutePath("data/notes.gp5"), path);
+
+        auto result = manager.probeFile(path.string());
+        REQUIRE(result);
+        REQUIRE(result->format == *manager.findFormat("gp5"));
+
+        // The file is imported as a Guitar Pro file.
+        Score score;
+        manager.importFile(score, path.string(), *manager.findFormat("ptb"));
+        REQUIRE(!score.getSystems().empty());
+    }
+
+    SECTION("Invalid file")
+    {
+        const fs::path path = dir / "invalid.gp5";
+        {
+            std::ofstream file(path.string());
+            file << "not a Guitar Pro file";
+        }
+
+        REQUIRE(!manager.probeFile(path.string()));
+
+        Score score;
+        REQUIRE_THROWS_AS(manager.importFile(score, path.string(),
+                                             *manager.findFormat("gp5")),
+                          FileFormatException);
+    }
+
+    fs::remove_all(dir);
+}
+
+TEST_CASE("Formats/FileFormatManager/ExportFormat", "")
+{
+    const fs::path dir = fs::temp_directory_path() / fs::unique_path();
+    fs::create_directories(dir);
+
+    SettingsManager settings_manager;
+    FileFormatManager manager(settings_manager);
+
+    Score score;
+    manager.importFile(score, AppInfo::getAbsolutePath("data/notes.mid"),
+                       *manager.findFormat("mid"));
+
+    // The MIDI importer supports more extensions than the exporter, so the
+    // export format must be looked up separately.
+    for (const char *extension : { "mid", "pt2" })
+    {
+        auto format = manager.findExportFormat(extension);
+        REQUIRE(format);
+
+        const fs::path path = dir / (std::string("notes.") + extension);
+        manager.exportFile(score, path.string(), *format);
+        REQUIRE(fs::file_size(path) > 0);
+
+        auto result = manager.probeFile(path.string());
+        REQUIRE(result);
+        REQUIRE(result->format == *manager.findFormat(extension));
+    }
+
+    // Formats that can only be imported.
+    REQUIRE(!manager.findExportFormat("gp5"));
+    REQUIRE(!manager.findExportFormat("gpx"));
+
+    fs::remove_all(dir);
+}
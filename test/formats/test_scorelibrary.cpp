@@ -0,0 +1,304 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <catch.hpp>
+
+#include <app/appinfo.h>
+#include <atomic>
+#include "benchmark.h"
+#include <boost/filesystem.hpp>
+#include <formats/scorelibrary.h>
+#include <fstream>
+#include <string>
+#include <util/settingsmanager.h>
+
+namespace fs = boost::filesystem;
+
+namespace
+{
+/// Creates a directory of files to be indexed.
+class LibraryFixture
+{
+public:
+    LibraryFixture() : myDir(fs::temp_directory_path() / fs::unique_path())
+    {
+        fs::create_directories(myDir / "nested");
+        copy("data/guitars.ptb", "guitars.ptb");
+        copy("data/keys.gp5", "keys.gp5");
+        copy("data/tempos.gp5", "tempos.gp5");
+        copy("data/time_signatures.gp5", "nested/time_signatures.gp5");
+
+        std::ofstream file((myDir / "invalid.gp5").string());
+        file << "not a Guitar Pro file";
+    }
+
+    ~LibraryFixture()
+    {
+        fs::remove_all(myDir);
+    }
+
+    void copy(const char *source, const char *dest)
+    {
+        fs::copy_file(AppInfo::getAbsolutePath(source), myDir / dest,
+                      fs::copy_option::overwrite_if_exists);
+    }
+
+    const fs::path myDir;
+};
+
+std::vector<std::string> search(const ScoreLibrary &library,
+                                const LibraryQuery &query)
+{
+    std::vector<std::string> filenames;
+    for (const LibraryEntry *entry : library.search(query))
+        filenames.push_back(fs::path(entry->path).filename().string());
+
+    return filenames;
+}
+
+/// Records the progress of an update, and optionally cancels it.
+class TestListener : public LibraryUpdateListener
+{
+public:
+    TestListener(bool cancel)
+        : myCancel(cancel), myNumChecked(0), myNumFiles(0)
+    {
+    }
+
+    virtual void filesChecked(size_t numChecked, size_t numFiles) override
+    {
+        // The files may be checked in parallel.
+        size_t previous = myNumChecked;
+        while (numChecked > previous &&
+               !myNumChecked.compare_exchange_weak(previous, numChecked))
+        {
+        }
+
+        myNumFiles = numFiles;
+    }
+
+    virtual bool isCancelled() const override
+    {
+        return myCancel;
+    }
+
+    const bool myCancel;
+    std::atomic<size_t> myNumChecked;
+    std::atomic<size_t> myNumFiles;
+};
+}
+
+TEST_CASE("Formats/ScoreLibrary/Search", "")
+{
+    LibraryFixture fixture;
+    SettingsManager settings_manager;
+    ScoreLibrary library;
+    library.addDirectory(fixture.myDir.string());
+
+    LibraryUpdateResult result = library.update(settings_manager);
+    REQUIRE(result.numFiles == 5);
+    REQUIRE(result.numImported == 4);
+    REQUIRE(result.errors.size() == 1);
+    REQUIRE(fs::path(result.errors[0].first).filename() == "invalid.gp5");
+    REQUIRE(library.getEntries().size() == 4);
+
+    typedef std::vector<std::string> Files;
+
+    LibraryQuery query;
+    REQUIRE(search(library, query).size() == 4);
+
+    query.text = "SOME title";
+    REQUIRE(search(library, query) == Files({ "guitars.ptb" }));
+
+    query = LibraryQuery();
+    query.text = "signatures";
+    REQUIRE(search(library, query) == Files({ "time_signatures.gp5" }));
+
+    // A seven string guitar.
+    query = LibraryQuery();
+    Tuning tuning;
+    tuning.setNotes({ 64, 59, 55, 50, 45, 40, 35 });
+    query.tuning = tuning;
+    REQUIRE(search(library, query) == Files({ "guitars.ptb" }));
+
+    query = LibraryQuery();
+    query.minTempo = 100;
+    query.maxTempo = 115;
+    REQUIRE(search(library, query) == Files({ "tempos.gp5" }));
+
+    query.maxTempo = boost::none;
+    REQUIRE(search(library, query) ==
+            Files({ "keys.gp5", "time_signatures.gp5", "tempos.gp5" }));
+
+    query = LibraryQuery();
+    query.keySignature = KeySignature(KeySignature::Minor, 0, true);
+    REQUIRE(search(library, query) == Files({ "keys.gp5" }));
+
+    query = LibraryQuery();
+    TimeSignature time;
+    time.setBeatsPerMeasure(3);
+    time.setBeatValue(4);
+    query.timeSignature = time;
+    REQUIRE(search(library, query) == Files({ "time_signatures.gp5" }));
+
+    // Every criterion must match.
+    query.text = "keys";
+    REQUIRE(search(library, query).empty());
+}
+
+TEST_CASE("Formats/ScoreLibrary/Update", "")
+{
+    LibraryFixture fixture;
+    SettingsManager settings_manager;
+    ScoreLibrary library;
+    library.addDirectory(fixture.myDir.string());
+    library.update(settings_manager);
+
+    // Nothing needs to be imported again.
+    LibraryUpdateResult result = library.update(settings_manager);
+    REQUIRE(result.numImported == 0);
+    REQUIRE(result.numRemoved == 0);
+
+    // The contents of a file that was only touched are unchanged.
+    const fs::path keys = fixture.myDir / "keys.gp5";
+    fs::last_write_time(keys, fs::last_write_time(keys) - 10);
+    result = library.update(settings_manager);
+    REQUIRE(result.numImported == 0);
+
+    LibraryQuery query;
+    query.keySignature = KeySignature(KeySignature::Minor, 0, true);
+    REQUIRE(library.search(query).size() == 1);
+
+    fixture.copy("data/notes.gp5", "keys.gp5");
+    fs::last_write_time(keys, fs::last_write_time(keys) + 10);
+    result = library.update(settings_manager);
+    REQUIRE(result.numImported == 1);
+    REQUIRE(library.search(query).empty());
+
+    fs::remove(fixture.myDir / "tempos.gp5");
+    result = library.update(settings_manager);
+    REQUIRE(result.numImported == 0);
+    REQUIRE(result.numRemoved == 1);
+    REQUIRE(library.getEntries().size() == 3);
+
+    // Save and reload the index.
+    const fs::path index_path = fixture.myDir / "library.idx";
+    library.save(index_path.string());
+
+    ScoreLibrary loaded;
+    loaded.load(index_path.string());
+    REQUIRE(loaded.getDirectories() == library.getDirectories());
+    REQUIRE(loaded.getEntries().size() == 3);
+    query = LibraryQuery();
+    query.text = "some title";
+    REQUIRE(loaded.search(query).size() == 1);
+
+    loaded.removeDirectory(fixture.myDir.string());
+    REQUIRE(loaded.getDirectories().empty());
+    REQUIRE(loaded.getEntries().empty());
+}
+
+TEST_CASE("Formats/ScoreLibrary/Directories", "")
+{
+    LibraryFixture fixture;
+    SettingsManager settings_manager;
+    ScoreLibrary library;
+
+    // Trailing separators are ignored.
+    const std::string dir = fixture.myDir.string();
+    library.addDirectory(dir + "/");
+    library.addDirectory(dir);
+    REQUIRE(library.getDirectories() == std::vector<std::string>({ dir }));
+
+    const std::string nested = (fixture.myDir / "nested").string();
+    library.addDirectory(nested + "//");
+    library.update(settings_manager);
+    REQUIRE(library.getEntries().size() == 4);
+
+    // The nested files are still in the parent directory.
+    library.removeDirectory(nested + "/");
+    REQUIRE(library.getDirectories() == std::vector<std::string>({ dir }));
+    REQUIRE(library.getEntries().size() == 4);
+
+    library.removeDirectory(dir + "/");
+    REQUIRE(library.getDirectories().empty());
+    REQUIRE(library.getEntries().empty());
+}
+
+TEST_CASE("Formats/ScoreLibrary/Progress", "")
+{
+    LibraryFixture fixture;
+    SettingsManager settings_manager;
+    ScoreLibrary library;
+    library.addDirectory(fixture.myDir.string());
+
+    // A cancelled update leaves the index unchanged.
+    TestListener cancelled(true);
+    LibraryUpdateResult result = library.update(settings_manager, &cancelled);
+    REQUIRE(result.cancelled);
+    REQUIRE(library.getEntries().empty());
+
+    TestListener listener(false);
+    result = library.update(settings_manager, &listener);
+    REQUIRE(!result.cancelled);
+    REQUIRE(listener.myNumChecked == 5);
+    REQUIRE(listener.myNumFiles == 5);
+    REQUIRE(library.getEntries().size() == 4);
+
+    // Unchanged files are reported as checked immediately.
+    TestListener rescan(false);
+    library.update(settings_manager, &rescan);
+    REQUIRE(rescan.myNumChecked == 5);
+}
+
+TEST_CASE("Formats/ScoreLibrary/Benchmark", "[!hide][benchmark]")
+{
+    const int num_files = 2000;
+    const int num_queries = 1000;
+
+    LibraryFixture fixture;
+    for (int i = 0; i < num_files; ++i)
+    {
+        const std::string filename =
+            "nested/copy" + std::to_string(i) + ".gp5";
+        fixture.copy("data/tempos.gp5", filename.c_str());
+    }
+
+    SettingsManager settings_manager;
+    ScoreLibrary library;
+    library.addDirectory(fixture.myDir.string());
+
+    const auto scan_time =
+        Benchmark::measure([&]() { library.update(settings_manager); });
+    WARN("Initial scan: " << Benchmark::format(scan_time));
+
+    const auto rescan_time =
+        Benchmark::measure([&]() { library.update(settings_manager); });
+    WARN("Rescan: " << Benchmark::format(rescan_time));
+
+    LibraryQuery query;
+    query.text = "signatures";
+    query.minTempo = 115;
+
+    size_t num_results = 0;
+    const auto search_time = Benchmark::measure(
+        [&]() { num_results += library.search(query).size(); }, num_queries);
+    REQUIRE(num_results == num_queries);
+
+    WARN("Search: " << Benchmark::format(search_time) << " per query");
+}
@@ -0,0 +1,395 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <catch.hpp>
+
+#include <algorithm>
+#include "benchmark.h"
+#include <midi/midifile.h>
+#include <score/score.h>
+
+/// Creates a score where every note is bent or slid.
+static void createBendScore(Score &score, int num_systems)
+{
+    score.insertPlayer(Player());
+    score.insertInstrument(Instrument());
+
+    for (int i = 0; i < num_systems; ++i)
+    {
+        System system;
+        Staff staff(6);
+
+        for (int j = 0; j < 16; ++j)
+        {
+            Position pos(j, Position::QuarterNote);
+            Note note(j % 6, 5);
+
+            if (j % 4 == 3)
+                note.setProperty(Note::ShiftSlide);
+            else
+            {
+                note.setBend(Bend(static_cast<Bend::BendType>(j % 3),
+                                  4 + j % 5, 0, 1));
+            }
+
+            pos.insertNote(note);
+            staff.getVoices()[0].insertPosition(pos);
+        }
+
+        system.insertStaff(staff);
+
+        if (i == 0)
+        {
+            PlayerChange change(0);
+            change.insertActivePlayer(0, ActivePlayer(0, 0));
+            system.insertPlayerChange(change);
+        }
+
+        score.insertSystem(system);
+    }
+}
+
+static int countPitchWheelEvents(const MidiFile &file)
+{
+    int count = 0;
+    for (const MidiEventList &track : file.getTracks())
+    {
+        for (const MidiEvent &event : track)
+        {
+            if (event.isPitchWheel())
+                ++count;
+        }
+    }
+
+    return count;
+}
+
+/// Computes a 64-bit FNV-1a hash of the ticks and data of every event.
+static uint64_t hashEvents(const MidiFile &file)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    auto add = [&](uint64_t value) {
+        hash ^= value;
+        hash *= 1099511628211ULL;
+    };
+
+    for (const MidiEventList &track : file.getTracks())
+    {
+        for (const MidiEvent &event : track)
+        {
+            add(static_cast<uint64_t>(event.getTicks()));
+            for (uint8_t byte : event.getData())
+                add(byte);
+        }
+    }
+
+    return hash;
+}
+
+TEST_CASE("Midi/MidiEvent/PitchWheelSweep", "")
+{
+    const MidiEvent sweep = MidiEvent::pitchWheelSweep(100, 2, 64, 70, 10);
+    REQUIRE(sweep.isModulation());
+    REQUIRE(!sweep.isPositionChange());
+
+    std::vector<MidiEvent> events;
+    sweep.expandModulation(events);
+    REQUIRE(events.size() == 6);
+    REQUIRE(events.front().getTicks() == 110);
+    REQUIRE(events.front().getData()[2] == 65);
+    REQUIRE(events.back().getTicks() == 160);
+    REQUIRE(events.back().getData()[2] == 70);
+
+    // Every third step should be generated, and the sweep should still end at
+    // the correct value.
+    events.clear();
+    sweep.expandModulation(events, 2);
+    REQUIRE(events.size() == 2);
+    REQUIRE(events[0].getTicks() == 130);
+    REQUIRE(events[0].getData()[2] == 67);
+    REQUIRE(events[1].getTicks() == 160);
+    REQUIRE(events[1].getData()[2] == 70);
+
+    events.clear();
+    sweep.expandModulation(events, 4);
+    REQUIRE(events.size() == 2);
+    REQUIRE(events[0].getData()[2] == 69);
+    REQUIRE(events[1].getData()[2] == 70);
+
+    // Without a tolerance, every step is generated even if they all occur at
+    // the same time.
+    const MidiEvent instant_sweep =
+        MidiEvent::pitchWheelSweep(100, 2, 70, 64, 0);
+    events.clear();
+    instant_sweep.expandModulation(events);
+    REQUIRE(events.size() == 6);
+    REQUIRE(events.back().getTicks() == 100);
+    REQUIRE(events.back().getData()[2] == 64);
+
+    // Otherwise, only the last step is needed.
+    events.clear();
+    instant_sweep.expandModulation(events, 1);
+    REQUIRE(events.size() == 1);
+    REQUIRE(events[0].getTicks() == 100);
+    REQUIRE(events[0].getData()[2] == 64);
+}
+
+TEST_CASE("Midi/MidiEvent/NoteRepeat", "")
+{
+    const MidiEvent trill =
+        MidiEvent::noteRepeat(0, 1, 60, 62, 127, 30, 3, SystemLocation(0, 4));
+    REQUIRE(trill.isModulation());
+
+    std::vector<MidiEvent> events;
+    trill.expandModulation(events);
+    REQUIRE(events.size() == 6);
+    REQUIRE(events[1].getData()[1] == 62);
+    REQUIRE(events[3].getData()[1] == 60);
+    REQUIRE(events[5].getTicks() == 60);
+    REQUIRE(events[5].getData()[1] == 62);
+    REQUIRE(events[5].getLocation() == SystemLocation(0, 4));
+}
+
+TEST_CASE("Midi/MidiEvent/ClipModulation", "")
+{
+    std::vector<MidiEvent> events;
+    MidiEvent::pitchWheelSweep(100, 2, 64, 70, 10).expandModulation(events);
+    MidiEvent::noteRepeat(100, 1, 60, 62, 127, 30, 3, SystemLocation(0, 4))
+        .expandModulation(events);
+
+    // Start playback in the middle of the bend and the trill.
+    MidiEvent::clipModulation(events, 135);
+
+    // The bend should resume from its current value at the start tick.
+    REQUIRE(events.size() == 6);
+    REQUIRE(events[0].getTicks() == 135);
+    REQUIRE(events[0].getChannel() == 2);
+    REQUIRE(events[0].getData()[2] == 67);
+
+    // The remaining notes and pitch wheel steps should be unchanged.
+    REQUIRE(events[1].getTicks() == 140);
+    REQUIRE(events[1].getData()[2] == 68);
+    REQUIRE(events[2].getTicks() == 150);
+    REQUIRE(events[3].getTicks() == 160);
+    REQUIRE(events[3].getData()[2] == 70);
+    REQUIRE(events[4].getTicks() == 160);
+    REQUIRE(events[4].isNoteOff());
+    REQUIRE(events[5].getTicks() == 160);
+    REQUIRE(events[5].isNoteOn());
+    REQUIRE(events[5].getData()[1] == 62);
+
+    // A bend that finished before the start only leaves its final value.
+    events.clear();
+    MidiEvent::pitchWheelSweep(0, 2, 70, 64, 10).expandModulation(events);
+    MidiEvent::clipModulation(events, 500);
+    REQUIRE(events.size() == 1);
+    REQUIRE(events[0].getTicks() == 500);
+    REQUIRE(events[0].getData()[2] == 64);
+}
+
+TEST_CASE("Midi/MidiEvent/SkippedEvents", "")
+{
+    // An earlier bend that has been released, followed by a bend that is in
+    // progress at the start tick.
+    std::vector<MidiEvent> compact_events;
+    compact_events.push_back(MidiEvent::pitchWheelSweep(0, 2, 64, 68, 10));
+    compact_events.push_back(MidiEvent::pitchWheel(50, 2, 64));
+    compact_events.push_back(MidiEvent::noteOn(100, 2, 60, 127,
+                                               SystemLocation(0, 1)));
+    compact_events.push_back(MidiEvent::pitchWheelSweep(100, 2, 64, 70, 10));
+
+    // The same events as they are sent for real-time playback, where the
+    // modulation has already been expanded.
+    std::vector<MidiEvent> expanded_events;
+    for (const MidiEvent &event : compact_events)
+    {
+        if (event.isModulation())
+            event.expandModulation(expanded_events);
+        else
+            expanded_events.push_back(event);
+    }
+    std::stable_sort(expanded_events.begin(), expanded_events.end());
+
+    // Start playback in the middle of the second bend.
+    const int start_tick = 135;
+    for (bool compact : { true, false })
+    {
+        std::vector<MidiEvent> skipped;
+        for (const MidiEvent &event :
+             compact ? compact_events : expanded_events)
+        {
+            if (event.getTicks() < start_tick)
+                event.recordSkippedEvent(skipped);
+        }
+        MidiEvent::clipModulation(skipped, start_tick);
+
+        // The bend should resume from its current value.
+        REQUIRE(!skipped.empty());
+        REQUIRE(skipped[0].getTicks() == start_tick);
+        REQUIRE(skipped[0].isPitchWheel());
+        REQUIRE(skipped[0].getData()[2] == 67);
+
+        // The remaining steps are either sent from the skipped events, or
+        // are still in the list of events to be played.
+        if (compact)
+        {
+            REQUIRE(skipped.size() == 4);
+            REQUIRE(skipped[1].getTicks() == 140);
+            REQUIRE(skipped[3].getTicks() == 160);
+            REQUIRE(skipped[3].getData()[2] == 70);
+        }
+        else
+            REQUIRE(skipped.size() == 1);
+    }
+
+    // A released bend should leave the pitch wheel at its released value.
+    std::vector<MidiEvent> skipped;
+    for (const MidiEvent &event : expanded_events)
+    {
+        if (event.getTicks() < 75)
+            event.recordSkippedEvent(skipped);
+    }
+    MidiEvent::clipModulation(skipped, 75);
+    REQUIRE(skipped.size() == 1);
+    REQUIRE(skipped[0].getData()[2] == 64);
+}
+
+TEST_CASE("Midi/MidiFile/CompactModulation", "")
+{
+    Score score;
+    createBendScore(score, 2);
+
+    MidiFile::LoadOptions options;
+    MidiFile expanded_file;
+    expanded_file.load(score, options);
+
+    options.myCompactModulation = true;
+    MidiFile compact_file;
+    compact_file.load(score, options);
+
+    // Expanding the compact events should produce the same output.
+    for (size_t i = 0; i < compact_file.getTracks().size(); ++i)
+    {
+        MidiEventList track = compact_file.getTracks()[i];
+        const MidiEventList &expected = expanded_file.getTracks()[i];
+
+        REQUIRE(track.size() <= expected.size());
+
+        track.convertToAbsoluteTicks();
+        track.expandModulation();
+        track.convertToDeltaTicks();
+
+        REQUIRE(track.size() == expected.size());
+        REQUIRE(std::equal(track.begin(), track.end(), expected.begin(),
+                           [](const MidiEvent &a, const MidiEvent &b) {
+                               return a.getTicks() == b.getTicks() &&
+                                      a.getData() == b.getData();
+                           }));
+    }
+}
+
+TEST_CASE("Midi/MidiFile/PerStepModulation", "")
+{
+    Score score;
+    createBendScore(score, 1);
+
+    // The output of the per-step generator that was used before modulation
+    // descriptors were introduced, for createBendScore(score, 1).
+    const size_t expected_events = 224;
+    const int expected_pitch_wheel_events = 183;
+    const uint64_t expected_hash = 0x042a1c27a3ccb3c1ULL;
+
+    MidiFile::LoadOptions options;
+    for (bool compact : { false, true })
+    {
+        options.myCompactModulation = compact;
+        MidiFile file;
+        file.load(score, options);
+
+        if (compact)
+        {
+            for (MidiEventList &track : file.getTracks())
+            {
+                track.convertToAbsoluteTicks();
+                track.expandModulation();
+                track.convertToDeltaTicks();
+            }
+        }
+
+        size_t num_events = 0;
+        for (const MidiEventList &track : file.getTracks())
+            num_events += track.size();
+
+        REQUIRE(num_events == expected_events);
+        REQUIRE(countPitchWheelEvents(file) == expected_pitch_wheel_events);
+        REQUIRE(hashEvents(file) == expected_hash);
+
+        // The first bend is sent one step at a time, then released.
+        auto bend = file.getTracks()[1].begin() + 8;
+        for (int i = 0; i < 5; ++i, ++bend)
+        {
+            REQUIRE(bend->getTicks() == 96);
+            REQUIRE(bend->getData() ==
+                    std::vector<uint8_t>(
+                        { 0xe0, 0, static_cast<uint8_t>(65 + i) }));
+        }
+        REQUIRE(bend->getTicks() == 0);
+        REQUIRE(bend->getData() == std::vector<uint8_t>({ 0xe0, 0, 64 }));
+    }
+}
+
+TEST_CASE("Midi/MidiFile/BendTolerance", "")
+{
+    Score score;
+    createBendScore(score, 1);
+
+    MidiFile::LoadOptions options;
+    MidiFile exact_file;
+    exact_file.load(score, options);
+
+    options.myMaxBendError = 2;
+    MidiFile approx_file;
+    approx_file.load(score, options);
+
+    REQUIRE(countPitchWheelEvents(approx_file) <
+            countPitchWheelEvents(exact_file));
+}
+
+TEST_CASE("Midi/MidiFile/BendBenchmark", "[!hide][benchmark]")
+{
+    Score score;
+    createBendScore(score, 500);
+
+    for (int max_error : { 0, 1, 2, 4 })
+    {
+        MidiFile::LoadOptions options;
+        options.myMaxBendError = max_error;
+
+        MidiFile file;
+        const auto load_time =
+            Benchmark::measure([&]() { file.load(score, options); });
+
+        size_t num_events = 0;
+        for (const MidiEventList &track : file.getTracks())
+            num_events += track.size();
+
+        WARN("Max bend error " << max_error << ": " << num_events
+                               << " events (" << countPitchWheelEvents(file)
+                               << " pitch wheel), "
+                               << Benchmark::format(load_time));
+    }
+}
@@ -0,0 +1,136 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <catch.hpp>
+
+#include <app/appinfo.h>
+#include "benchmark.h"
+#include <formats/powertab/powertabimporter.h>
+#include <score/binaryserialization.h>
+#include <score/score.h>
+#include <score/serialization.h>
+#include <sstream>
+
+static void loadScore(Score &score)
+{
+    PowerTabImporter importer;
+    importer.load(AppInfo::getAbsolutePath("data/test_viewfilter.pt2"), score);
+}
+
+TEST_CASE("Score/BinarySerialization/Score", "")
+{
+    Score score;
+    loadScore(score);
+
+    std::ostringstream json_output;
+    ScoreUtils::save(json_output, "score", score);
+
+    std::ostringstream output;
+    ScoreUtils::saveBinary(output, "score", score);
+    const std::string data = output.str();
+
+    REQUIRE(data.size() < json_output.str().size() / 2);
+
+    Score copy;
+    std::istringstream input(data);
+    REQUIRE(ScoreUtils::isBinaryArchive(input));
+    ScoreUtils::loadBinary(input, "score", copy);
+    REQUIRE(copy == score);
+
+    // The JSON data should not be mistaken for a binary archive.
+    std::istringstream json_input(json_output.str());
+    REQUIRE(!ScoreUtils::isBinaryArchive(json_input));
+}
+
+TEST_CASE("Score/BinarySerialization/InvalidData", "")
+{
+    Score score;
+    loadScore(score);
+
+    std::ostringstream output;
+    ScoreUtils::saveBinary(output, "score", score);
+    const std::string data = output.str();
+
+    {
+        Score copy;
+        std::istringstream input(data.substr(0, data.size() / 2));
+        REQUIRE_THROWS_AS(ScoreUtils::loadBinary(input, "score", copy),
+                          std::runtime_error);
+    }
+
+    {
+        Score copy;
+        std::istringstream input(data);
+        REQUIRE_THROWS_AS(ScoreUtils::loadBinary(input, "other", copy),
+                          std::runtime_error);
+    }
+
+    {
+        Score copy;
+        std::istringstream input("{ \"version\": 3 }");
+        REQUIRE_THROWS_AS(ScoreUtils::loadBinary(input, "score", copy),
+                          std::runtime_error);
+    }
+}
+
+TEST_CASE("Score/BinarySerialization/Benchmark", "[!hide][benchmark]")
+{
+    Score score;
+    loadScore(score);
+
+    // Make a much larger score by repeating the systems.
+    const System system = score.getSystems()[0];
+    for (int i = 0; i < 2000; ++i)
+        score.insertSystem(system);
+
+    std::ostringstream pretty_json_output;
+    const auto pretty_json_save_time = Benchmark::measure([&]() {
+        ScoreUtils::save(pretty_json_output, "score", score,
+                         ScoreUtils::JsonFormat::Pretty);
+    });
+
+    std::ostringstream json_output;
+    const auto json_save_time = Benchmark::measure(
+        [&]() { ScoreUtils::save(json_output, "score", score); });
+
+    Score json_copy;
+    const auto json_load_time = Benchmark::measure([&]() {
+        std::istringstream input(json_output.str());
+        ScoreUtils::load(input, "score", json_copy);
+    });
+    REQUIRE(json_copy == score);
+
+    std::ostringstream binary_output;
+    const auto binary_save_time = Benchmark::measure(
+        [&]() { ScoreUtils::saveBinary(binary_output, "score", score); });
+
+    Score binary_copy;
+    const auto binary_load_time = Benchmark::measure([&]() {
+        std::istringstream input(binary_output.str());
+        ScoreUtils::loadBinary(input, "score", binary_copy);
+    });
+    REQUIRE(binary_copy == score);
+
+    WARN("Pretty JSON: " << pretty_json_output.str().size() << " bytes, save "
+                         << Benchmark::format(pretty_json_save_time));
+    WARN("JSON: " << json_output.str().size() << " bytes, save "
+                  << Benchmark::format(json_save_time) << ", load "
+                  << Benchmark::format(json_load_time));
+    WARN("Binary: " << binary_output.str().size() << " bytes, save "
+                    << Benchmark::format(binary_save_time) << ", load "
+                    << Benchmark::format(binary_load_time));
+}
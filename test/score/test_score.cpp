@@ -17,7 +17,10 @@
   
 #include <catch.hpp>
 
+#include "benchmark.h"
 #include <score/score.h>
+#include <score/scorelocation.h>
+#include <set>
 
 TEST_CASE("Score/Score/Systems", "")
 {
@@ -77,3 +80,180 @@ TEST_CASE("Score/Score/ViewFilters", "")
     REQUIRE(score.getViewFilters().size() == 1);
     REQUIRE(score.getViewFilters()[0] == filter1);
 }
+
+TEST_CASE("Score/Score/Clone", "")
+{
+    Score score;
+    score.insertSystem(System());
+    score.insertPlayer(Player());
+    score.setLineSpacing(12);
+
+    std::unique_ptr<Score> copy = score.clone();
+    REQUIRE(*copy == score);
+
+    // The copy should be independent of the original.
+    score.removeSystem(0);
+    REQUIRE(copy->getSystems().size() == 1);
+}
+
+TEST_CASE("Score/Score/CopyOnWrite", "")
+{
+    Score score;
+    score.insertSystem(System());
+    score.insertSystem(System());
+
+    // Modifying a system that isn't shared doesn't copy it.
+    const System *original = &score.getSystems()[0];
+    score.getSystems()[0].insertBarline(Barline(10, Barline::SingleBar));
+    REQUIRE(&score.getSystems()[0] == original);
+
+    std::unique_ptr<Score> copy = score.clone();
+    REQUIRE(copy->getSystemHandle(0) == score.getSystemHandle(0));
+
+    // Only the modified system should be copied.
+    score.getSystems()[0].insertBarline(Barline(20, Barline::SingleBar));
+    REQUIRE(score.getSystems()[0].getBarlines().size() == 4);
+    REQUIRE(copy->getSystems()[0].getBarlines().size() == 3);
+    REQUIRE(copy->getSystemHandle(0) != score.getSystemHandle(0));
+    REQUIRE(copy->getSystemHandle(1) == score.getSystemHandle(1));
+
+    // Restoring a handle, e.g. when undoing an edit.
+    score.setSystem(0, copy->getSystemHandle(0));
+    REQUIRE(score == *copy);
+}
+
+TEST_CASE("Score/Score/CopyOnWrite/RestoreSystem", "")
+{
+    Score score;
+    score.insertSystem(System());
+
+    const Score::SystemHandle original = score.getSystemHandle(0);
+    const System &system = score.getSystems()[0];
+    score.getSystems()[0].insertBarline(Barline(10, Barline::SingleBar));
+    REQUIRE(&score.getSystems()[0] == &system);
+    REQUIRE(system.getBarlines().size() == 3);
+
+    // Restoring a system that isn't shared keeps the existing object, so
+    // references to it are still valid.
+    score.restoreSystem(0, original);
+    REQUIRE(&score.getSystems()[0] == &system);
+    REQUIRE(system == *original);
+    REQUIRE(score.getSystemHandle(0) != original);
+
+    // If the system is shared, the other owner keeps the existing object.
+    score.getSystems()[0].insertBarline(Barline(10, Barline::SingleBar));
+    const Score::SystemHandle shared = score.getSystemHandle(0);
+    score.restoreSystem(0, original);
+    REQUIRE(score.getSystemHandle(0) == original);
+    REQUIRE(shared->getBarlines().size() == 3);
+}
+
+TEST_CASE("Score/Score/CopyOnWrite/ScoreLocation", "")
+{
+    Score score;
+    System system;
+    Staff staff(6);
+    Position pos(1);
+    pos.insertNote(Note(2, 3));
+    staff.getVoices()[0].insertPosition(pos);
+    system.insertStaff(staff);
+    score.insertSystem(system);
+
+    // The system is shared, e.g. with the score area.
+    const Score::SystemHandle shared = score.getSystemHandle(0);
+    ScoreLocation location(score, 0, 0, 1, 0, 2);
+
+    // Reading through a const location doesn't copy the system.
+    const ScoreLocation &const_location = location;
+    REQUIRE(const_location.getNote());
+    REQUIRE(const_location.getSelectedNotes().size() == 1);
+    REQUIRE(score.getSystemHandle(0) == shared);
+
+    // Mutable pointers from the location must not refer to the shared system.
+    location.getNote()->setFretNumber(5);
+    REQUIRE(score.getSystemHandle(0) != shared);
+    REQUIRE(shared->getStaves()[0].getVoices()[0].getPositions()[0]
+                .getNotes()[0]
+                .getFretNumber() == 3);
+    REQUIRE(location.getSelectedNotes()[0]->getFretNumber() == 5);
+}
+
+static System makeBenchmarkSystem()
+{
+    Staff staff(6);
+    for (int i = 0; i < 50; ++i)
+    {
+        Position pos(i);
+        pos.insertNote(Note(i % 6, i % 12));
+        staff.getVoices()[0].insertPosition(pos);
+    }
+
+    System system;
+    system.insertStaff(staff);
+    return system;
+}
+
+TEST_CASE("Score/Score/CopyOnWrite/Benchmark", "[!hide][benchmark]")
+{
+    const int num_systems = 500;
+    const int num_edits = 5000;
+
+    Score score;
+    for (int i = 0; i < num_systems; ++i)
+        score.insertSystem(makeBenchmarkSystem());
+
+    // Simulate an editing session, where each edit keeps the original system
+    // for undo and every 100th edit takes a snapshot of the score (e.g. for a
+    // background save).
+    std::vector<Score::SystemHandle> undo_stack;
+    std::vector<std::unique_ptr<Score>> snapshots;
+
+    const auto edit_time = Benchmark::measure([&]() {
+        for (int i = 0; i < num_edits; ++i)
+        {
+            const int system_index = (i * 7) % num_systems;
+            undo_stack.push_back(score.getSystemHandle(system_index));
+
+            Position pos(100 + i / num_systems);
+            pos.insertNote(Note(0, 5));
+            score.getSystems()[system_index]
+                .getStaves()[0]
+                .getVoices()[0]
+                .insertPosition(pos);
+
+            if (i % 100 == 0)
+                snapshots.push_back(score.clone());
+        }
+    });
+
+    // Iterating over a non-const score could copy the shared systems.
+    std::set<const System *> distinct;
+    for (const Score::SystemHandle &system : undo_stack)
+        distinct.insert(system.get());
+    for (const std::unique_ptr<Score> &snapshot : snapshots)
+    {
+        const Score &snapshot_score = *snapshot;
+        for (const System &system : snapshot_score.getSystems())
+            distinct.insert(&system);
+    }
+    const Score &current_score = score;
+    for (const System &system : current_score.getSystems())
+        distinct.insert(&system);
+
+    // Only the edited systems should have been copied.
+    REQUIRE(distinct.size() ==
+            static_cast<size_t>(num_systems + num_edits));
+
+    WARN("Systems in memory after " << num_edits << " edits: "
+         << distinct.size() << " (vs "
+         << num_systems * (snapshots.size() + 1) + undo_stack.size()
+         << " if copied)");
+    WARN("Editing: " << Benchmark::format(edit_time / num_edits)
+                     << " per edit");
+
+    std::unique_ptr<Score> copy;
+    const auto clone_time =
+        Benchmark::measure([&]() { copy = score.clone(); });
+    WARN("Cloning the score: " << Benchmark::format(clone_time));
+    REQUIRE(*copy == score);
+}
@@ -20,6 +20,7 @@
 
 #include <catch.hpp>
 
+#include <score/binaryserialization.h>
 #include <score/serialization.h>
 #include <sstream>
 
@@ -27,17 +28,33 @@ namespace Serialization {
 
     /// Basic test for the serialization code - we should be able to serialize
     /// and deserialize and object, and get an equivalent object back.
+    /// This is checked for compact and pretty JSON, and the binary format.
     template <typename T>
     void test(const char *name, const T &original)
     {
-        std::ostringstream output;
-        ScoreUtils::save(output, name, original);
+        for (auto format : { ScoreUtils::JsonFormat::Compact,
+                             ScoreUtils::JsonFormat::Pretty })
+        {
+            std::ostringstream output;
+            ScoreUtils::save(output, name, original, format);
 
-        T copy;
-        std::istringstream input(output.str());
-        ScoreUtils::load(input, name, copy);
+            T copy;
+            std::istringstream input(output.str());
+            ScoreUtils::load(input, name, copy);
 
-        REQUIRE(original == copy);
+            REQUIRE(original == copy);
+        }
+
+        {
+            std::ostringstream output;
+            ScoreUtils::saveBinary(output, name, original);
+
+            T copy;
+            std::istringstream input(output.str());
+            ScoreUtils::loadBinary(input, name, copy);
+
+            REQUIRE(original == copy);
+        }
     }
 }
 
@@ -33,6 +33,24 @@ TEST_CASE("Score/Utils/FindByPosition", "")
     REQUIRE(*ScoreUtils::findByPosition(system.getBarlines(), 42) == barline);
 }
 
+TEST_CASE("Score/Utils/FindInSortedRange", "")
+{
+    System system;
+    system.insertBarline(Barline(4, Barline::SingleBar));
+    system.insertBarline(Barline(8, Barline::SingleBar));
+    system.insertBarline(Barline(12, Barline::SingleBar));
+
+    auto bars = ScoreUtils::findInSortedRange(system.getBarlines(), 4, 12);
+    REQUIRE(bars.size() == 3);
+    REQUIRE(bars.front().getPosition() == 4);
+    REQUIRE(bars.back().getPosition() == 12);
+
+    REQUIRE(ScoreUtils::findInSortedRange(system.getBarlines(), 5, 7).empty());
+    REQUIRE(ScoreUtils::findInSortedRange(system.getBarlines(), 7, 5).empty());
+    REQUIRE(ScoreUtils::findInSortedRange(system.getBarlines(), 9, 100).size() ==
+            2);
+}
+
 TEST_CASE("Score/Utils/GetCurrentPlayers", "")
 {
     Score score;
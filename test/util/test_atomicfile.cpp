@@ -0,0 +1,112 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <catch.hpp>
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <stdexcept>
+#include <util/atomicfile.h>
+
+namespace fs = boost::filesystem;
+
+static std::string readFile(const fs::path &path)
+{
+    std::ifstream file(path.string());
+    return std::string((std::istreambuf_iterator<char>(file)),
+                       std::istreambuf_iterator<char>());
+}
+
+static void writeFile(const std::string &path, const std::string &contents)
+{
+    std::ofstream file(path);
+    file << contents;
+}
+
+TEST_CASE("Util/AtomicFile")
+{
+    const fs::path dir = fs::temp_directory_path() / fs::unique_path();
+    fs::create_directories(dir);
+    const fs::path path = dir / "test.txt";
+
+    SECTION("New file")
+    {
+        Util::writeFileAtomically(path.string(), [](const std::string &temp) {
+            writeFile(temp, "foo");
+        });
+
+        REQUIRE(readFile(path) == "foo");
+    }
+
+    SECTION("Replace file")
+    {
+        writeFile(path.string(), "foo");
+        Util::writeFileAtomically(path.string(), [](const std::string &temp) {
+            writeFile(temp, "bar");
+        });
+
+        REQUIRE(readFile(path) == "bar");
+    }
+
+    SECTION("Failed write")
+    {
+        writeFile(path.string(), "foo");
+        REQUIRE_THROWS_AS(
+            Util::writeFileAtomically(path.string(),
+                                      [](const std::string &temp) {
+                                          writeFile(temp, "partial");
+                                          throw std::runtime_error("error");
+                                      }),
+            std::runtime_error);
+
+        // The original file should be untouched, and the temporary file
+        // should be removed.
+        REQUIRE(readFile(path) == "foo");
+    }
+
+    // Only the destination file should be left in the directory.
+    REQUIRE(std::distance(fs::directory_iterator(dir),
+                          fs::directory_iterator()) == 1);
+
+    fs::remove_all(dir);
+}
+
+#ifndef _WIN32
+TEST_CASE("Util/AtomicFile/Symlink")
+{
+    const fs::path dir = fs::temp_directory_path() / fs::unique_path();
+    fs::create_directories(dir / "target");
+    const fs::path target = dir / "target" / "test.txt";
+    const fs::path link = dir / "link.txt";
+
+    writeFile(target.string(), "foo");
+    fs::create_symlink(fs::path("target") / "test.txt", link);
+
+    Util::writeFileAtomically(link.string(), [](const std::string &temp) {
+        writeFile(temp, "bar");
+    });
+
+    // The file that the link points to should be replaced, and the link
+    // should be kept.
+    REQUIRE(fs::is_symlink(link));
+    REQUIRE(readFile(target) == "bar");
+    REQUIRE(std::distance(fs::directory_iterator(dir / "target"),
+                          fs::directory_iterator()) == 1);
+
+    fs::remove_all(dir);
+}
+#endif
@@ -0,0 +1,81 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <catch.hpp>
+
+#include <stdexcept>
+#include <thread>
+#include <util/parallel.h>
+#include <vector>
+
+TEST_CASE("Util/ParallelFor/VisitsEachIndex")
+{
+    for (size_t count : { 0, 1, 7, 1000 })
+    {
+        std::vector<int> visits(count, 0);
+        Util::parallelFor(count, 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                ++visits[i];
+        });
+
+        REQUIRE(visits == std::vector<int>(count, 1));
+    }
+}
+
+TEST_CASE("Util/ParallelFor/Error")
+{
+    REQUIRE_THROWS_AS(
+        Util::parallelFor(1000, 1,
+                          [](size_t begin, size_t end) {
+                              if (begin <= 500 && 500 < end)
+                                  throw std::runtime_error("error");
+                          }),
+        std::runtime_error);
+}
+
+TEST_CASE("Util/ParallelFor/SerialScope")
+{
+    const std::thread::id caller = std::this_thread::get_id();
+
+    {
+        Util::SerialScope serial;
+        REQUIRE(Util::launchPolicy() == std::launch::deferred);
+
+        int calls = 0;
+        Util::parallelFor(1000, 1, [&](size_t begin, size_t end) {
+            REQUIRE(begin == 0);
+            REQUIRE(end == 1000);
+            REQUIRE(std::this_thread::get_id() == caller);
+            ++calls;
+        });
+        REQUIRE(calls == 1);
+
+        {
+            Util::SerialScope disabled(false);
+            REQUIRE(Util::launchPolicy() == std::launch::deferred);
+        }
+        REQUIRE(Util::launchPolicy() == std::launch::deferred);
+    }
+
+    REQUIRE(Util::launchPolicy() == std::launch::async);
+
+    // The scope only applies to the thread that created it.
+    Util::SerialScope serial;
+    std::launch policy = std::launch::deferred;
+    std::thread([&]() { policy = Util::launchPolicy(); }).join();
+    REQUIRE(policy == std::launch::async);
+}
@@ -17,7 +17,7 @@
   
 #include <catch.hpp>
 
-#include <app/settingsmanager.h>
+#include <util/settingsmanager.h>
 
 TEST_CASE("App/SettingsManager", "")
 {
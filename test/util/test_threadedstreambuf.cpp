@@ -0,0 +1,70 @@
+/*
+  * Copyright (C) 2017 Cameron White
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <catch.hpp>
+
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <util/threadedstreambuf.h>
+
+TEST_CASE("Util/ThreadedOutputStreamBuf/Write")
+{
+    std::ostringstream expected;
+    std::stringbuf dest;
+
+    {
+        // Use a small chunk size so that many chunks are queued.
+        Util::ThreadedOutputStreamBuf buf(dest, 7, 2);
+        std::ostream output(&buf);
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            output << i << ' ';
+            expected << i << ' ';
+        }
+
+        const std::string large(100, 'x');
+        output << large;
+        expected << large;
+
+        output.flush();
+        buf.finish();
+    }
+
+    REQUIRE(dest.str() == expected.str());
+}
+
+TEST_CASE("Util/ThreadedOutputStreamBuf/Error")
+{
+    // A stream buffer that fails on every write.
+    class FailingBuf : public std::streambuf
+    {
+    protected:
+        virtual int_type overflow(int_type) override
+        {
+            throw std::runtime_error("Write failed");
+        }
+    };
+
+    FailingBuf dest;
+    Util::ThreadedOutputStreamBuf buf(dest, 4);
+    std::ostream output(&buf);
+    output << "some data that does not fit in a single chunk";
+
+    REQUIRE_THROWS_AS(buf.finish(), std::runtime_error);
+}